@@ -8,14 +8,23 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <chrono>
 #include <windows.h>
-#include "SoundManager.h"
-#include "SFMLSoundPlayer.h"
-#include "KeyboardHookManager.h"
+#include "Config.h"
+#include "Engine.h"
 
 /**
  * @class Application
  * @brief Main application class that manages the lifecycle and UI
+ *
+ * A Win32 shell around the Engine: it owns the window and its controls
+ * and mirrors changes the engine reports from its own threads.
+ *
+ * In tray mode (ui.tray) a hidden window owns a notification area icon
+ * for the whole session. Minimizing or closing the main window destroys
+ * it along with its fonts, brushes and controls; the tray icon creates
+ * it again from the engine's current state. The UI thread is then left
+ * with the message loop the keyboard hook is called from.
  */
 class Application
 {
@@ -23,8 +32,9 @@ public:
     /**
      * @brief Constructor
      * @param soundFolder Path to the folder containing sound packs
+     * @param config Startup configuration
      */
-    explicit Application(const std::string &soundFolder);
+    explicit Application(const std::string &soundFolder, const AppConfig &config = AppConfig());
 
     /**
      * @brief Destructor
@@ -73,17 +83,55 @@ private:
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
     /**
-     * @brief Initializes the application window and UI elements
+     * @brief Window procedure of the hidden window that owns the tray icon
+     */
+    static LRESULT CALLBACK TrayWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+    /**
+     * @brief Registers the window classes and creates the main window, the tray window or both
      * @return true if successful, false otherwise
      */
     bool initializeWindow();
 
     /**
-     * @brief Loads available sound packs
-     * @return true if at least one sound pack was found, false otherwise
+     * @brief Creates the main window and its controls
+     * @return true if successful, false otherwise
      */
-    bool loadSoundPacks();
-    
+    bool createMainWindow();
+
+    /**
+     * @brief Shows the main window, creating it first if it was released
+     * @return true if the window is shown, false otherwise
+     */
+    bool showWindow();
+
+    /**
+     * @brief Destroys the main window and its GDI objects, leaving the tray icon
+     *
+     * Logs how far the working set and the GDI and USER object counts dropped.
+     */
+    void hideToTray();
+
+    /**
+     * @brief Adds the tray icon; also called when Explorer restarts
+     */
+    void addTrayIcon();
+
+    /**
+     * @brief Shows the tray icon's menu at the cursor
+     */
+    void showTrayMenu();
+
+    /**
+     * @brief Creates the brushes and pen the main window paints with
+     */
+    void createPaintResources();
+
+    /**
+     * @brief Releases the fonts, brushes and pen of the main window
+     */
+    void releaseUiResources();
+
     /**
      * @brief Creates a font with the specified properties
      * @param size Font size in points
@@ -97,10 +145,11 @@ private:
      * @brief Draws a rounded rectangle 
      * @param hdc Device context
      * @param rect Rectangle coordinates
-     * @param color Fill color
+     * @param brush Fill brush
+     * @param pen Outline pen
      * @param radius Corner radius
      */
-    void drawRoundedRect(HDC hdc, RECT rect, COLORREF color, int radius);
+    void drawRoundedRect(HDC hdc, RECT rect, HBRUSH brush, HPEN pen, int radius);
     
     /**
      * @brief Sets custom colors for controls
@@ -108,13 +157,45 @@ private:
      */
     void SetControlColors(HWND hwnd);
 
+    /**
+     * @brief Bring up the hook, device, packs and window as a dependency graph
+     *
+     * Independent steps overlap on worker threads; window and hook creation
+     * stay on the UI thread. Shows an error box on failure.
+     * @return true if everything started, false otherwise
+     */
+    bool runStartup();
+
+    /**
+     * @brief Actions posted from the engine's threads to the UI thread
+     */
+    enum ControlAction : WPARAM
+    {
+        CONTROL_SELECT_PACK,
+        CONTROL_SET_VOLUME,
+        CONTROL_SET_PROFILE,
+        CONTROL_ADD_PACK
+    };
+
+    /**
+     * @brief Hand an engine change over to the UI thread (runs on engine threads)
+     * @param change Change reported by the engine
+     * @param value Value of the change
+     */
+    void postEngineChange(Engine::Change change, int value);
+
     // Data members
-    std::string soundFolder_;
-    std::vector<std::string> soundPacks_;
+    std::chrono::steady_clock::time_point startTime_;
+    std::unique_ptr<Engine> engine_;
 
-    std::unique_ptr<SoundManager> soundManager_;
-    std::unique_ptr<SFMLSoundPlayer> soundPlayer_;
-    std::unique_ptr<KeyboardHookManager> hookManager_;
+    // Tray mode
+    bool trayMode_;
+    bool startHidden_;
+    HWND trayHwnd_;
+    UINT taskbarCreatedMessage_;
+
+    // Receives engine changes; the tray window in tray mode, else the main window. Set before the engine's threads start
+    HWND controlHwnd_;
 
     // UI elements
     HWND hwnd_;
@@ -123,17 +204,20 @@ private:
     HWND volumeValueLabel_;
     HWND optimizationCombo_;
     
-    // Resource management
+    // Resource management, all released with the main window
     std::vector<HFONT> fonts_; // Store font handles for cleanup
+    HBRUSH backgroundBrush_;
+    HBRUSH highlightBrush_;
+    HPEN highlightPen_;
 
-    // Settings
-    int volume_;
-    int latencyOptimizationLevel_;
-
-    // Window class name
+    // Window class names
     static constexpr const wchar_t *CLASS_NAME = L"KeyboardSoundsAppWindowClass";
-    static constexpr int DEFAULT_VOLUME = 50;
-    static constexpr int DEFAULT_OPTIMIZATION = 2;
+    static constexpr const wchar_t *TRAY_CLASS_NAME = L"KeyboardSoundsTrayWindowClass";
+    static constexpr UINT WM_APP_CONTROL = WM_APP + 1;
+    static constexpr UINT WM_APP_TRAY = WM_APP + 2;
+    static constexpr UINT TRAY_ICON_ID = 1;
+    static constexpr UINT TRAY_OPEN = 1;
+    static constexpr UINT TRAY_EXIT = 2;
 };
 
 #endif // APPLICATION_H
\ No newline at end of file
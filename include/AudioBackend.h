@@ -0,0 +1,193 @@
+/**
+ * @file AudioBackend.h
+ * @brief Interface for the audio output backends used by the sound player
+ */
+#ifndef AUDIOBACKEND_H
+#define AUDIOBACKEND_H
+
+#include <chrono>
+#include <string>
+#include <memory>
+#include <SFML/Audio.hpp>
+#include "BusEffects.h"
+
+struct ClickParams;
+
+/**
+ * @enum OverloadPolicy
+ * @brief How the engine copes with more sounds than it should play at once
+ */
+enum class OverloadPolicy
+{
+    LIMIT, ///< Play every event; voices are stolen at the cap and the bus limiter keeps the peak down
+    DROP   ///< Skip fast repeats and releases, and drop low priority sounds at the voice cap
+};
+
+/**
+ * @struct AudioBackendConfig
+ * @brief Backend selection and output parameters
+ */
+struct AudioBackendConfig
+{
+    std::string backend = "sfml-sound"; ///< "sfml-sound", "sfml-stream" or "null"
+    std::string device;                 ///< Playback device name, empty for the system default
+    unsigned int sampleRate = 44100;    ///< Mix rate for the mixing backends
+    unsigned int periodFrames = 256;    ///< Frames rendered per period by the mixing backends
+    std::string outputFile;             ///< Raw PCM dump for the null backend (optional)
+    BusEffectSettings effects;          ///< Mix bus effects for the mixing backends
+    OverloadPolicy overloadPolicy = OverloadPolicy::LIMIT; ///< audio.overloadPolicy, "limit" or "drop"
+    unsigned int scheduleLatencyMs = 10; ///< audio.scheduleLatencyMs, key event to onset for the mixing backends, 0 starts at once
+};
+
+/**
+ * @class AudioVoice
+ * @brief Handle to one playing sound owned by a backend
+ */
+class AudioVoice
+{
+public:
+    virtual ~AudioVoice() = default;
+
+    /**
+     * @brief Stop the voice immediately
+     */
+    virtual void stop() = 0;
+
+    /**
+     * @brief Check whether the voice is still producing audio
+     * @return true if playing, false once finished or stopped
+     */
+    virtual bool isPlaying() const = 0;
+
+    /**
+     * @brief Change the voice volume
+     * @param volume Volume level (0-100)
+     */
+    virtual void setVolume(float volume) = 0;
+
+    /**
+     * @brief Start a voice created by AudioBackend::armVoice()
+     * @param onset When the sound should be heard, as for AudioBackend::startVoice()
+     * @return false if the voice was not armed or has been stopped
+     */
+    virtual bool trigger(std::chrono::steady_clock::time_point onset) = 0;
+};
+
+/**
+ * @class AudioBackend
+ * @brief Output device abstraction below the sound player
+ *
+ * Buffers are still decoded by SFML; a backend only decides how decoded
+ * samples reach the device.
+ */
+class AudioBackend
+{
+public:
+    virtual ~AudioBackend() = default;
+
+    /**
+     * @brief Open the output device
+     * @param config Backend parameters
+     * @return true if successful, false otherwise
+     */
+    virtual bool open(const AudioBackendConfig &config) = 0;
+
+    /**
+     * @brief Close the output device and release all voices
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Stop pulling audio from the device while the player is parked
+     */
+    virtual void suspend() {}
+
+    /**
+     * @brief Restart the device after suspend()
+     */
+    virtual void resume() {}
+
+    /**
+     * @brief Start playing a decoded buffer
+     *
+     * Mixing backends start the voice at the sample that plays at onset;
+     * the others, and onsets already past, start at once.
+     *
+     * @param buffer Decoded sound buffer (kept alive by the voice)
+     * @param volume Volume level (0-100)
+     * @param onset When the sound should be heard, or a default time point for as soon as possible
+     * @return Voice handle, or nullptr if no voice could be started
+     */
+    virtual std::shared_ptr<AudioVoice> startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                                   std::chrono::steady_clock::time_point onset) = 0;
+
+    /**
+     * @brief Start a synthesized key click
+     *
+     * Mixing backends render the click directly into the mix. The default
+     * renders it into a buffer that lives only as long as the voice.
+     *
+     * @param params Keystroke parameters
+     * @param volume Volume level (0-100)
+     * @param onset When the click should be heard, as for startVoice()
+     * @return Voice handle, or nullptr if no voice could be started
+     */
+    virtual std::shared_ptr<AudioVoice> startSynthVoice(const ClickParams &params, float volume,
+                                                        std::chrono::steady_clock::time_point onset);
+
+    /**
+     * @brief Prepare a voice for a buffer that trigger() starts later
+     *
+     * Everything that can be done ahead is done here, so triggering only
+     * flips a flag. stop() releases an armed voice that is not needed.
+     *
+     * @param buffer Decoded sound buffer (kept alive by the voice)
+     * @param volume Volume level (0-100)
+     * @return Armed voice, or nullptr if no voice could be reserved
+     */
+    virtual std::shared_ptr<AudioVoice> armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume) = 0;
+
+    /**
+     * @brief Prepare a synthesized key click that trigger() starts later
+     *
+     * The default renders the click into a buffer and arms that.
+     *
+     * @param params Keystroke parameters
+     * @param volume Volume level (0-100)
+     * @return Armed voice, or nullptr if no voice could be reserved
+     */
+    virtual std::shared_ptr<AudioVoice> armSynthVoice(const ClickParams &params, float volume);
+
+    /**
+     * @brief Replace the mix bus effects while playing
+     * @param settings New effect settings
+     * @return false if this backend has no mix bus or the settings could not be applied in full
+     */
+    virtual bool configureEffects(const BusEffectSettings &settings) { (void)settings; return false; }
+
+    /**
+     * @brief Drop the buffers still held by finished voices (player thread)
+     */
+    virtual void releaseFinishedVoices() {}
+
+    /**
+     * @brief Get the backend name as used in the configuration
+     * @return Backend name
+     */
+    virtual std::string getName() const = 0;
+
+    /**
+     * @brief Describe the negotiated buffer latency for the startup log
+     * @return Human readable latency description
+     */
+    virtual std::string describeLatency() const = 0;
+
+    /**
+     * @brief Create a backend by configuration name
+     * @param name Backend name
+     * @return The backend, or nullptr for an unknown name
+     */
+    static std::unique_ptr<AudioBackend> create(const std::string &name);
+};
+
+#endif // AUDIOBACKEND_H
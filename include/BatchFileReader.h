@@ -0,0 +1,73 @@
+/**
+ * @file BatchFileReader.h
+ * @brief Reads many small files at once
+ */
+#ifndef BATCHFILEREADER_H
+#define BATCHFILEREADER_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct FileRead
+ * @brief One file to read and its contents
+ */
+struct FileRead
+{
+    std::string path;       ///< File to read
+    std::vector<char> data; ///< Contents, filled by readAll()
+    bool ok = false;        ///< true if the whole file was read
+};
+
+/**
+ * @class BatchFileReader
+ * @brief Reads a set of files with all reads in flight together
+ *
+ * On Linux every read of the set is submitted as one io_uring batch, so a
+ * cold page cache or a network home directory costs roughly one round
+ * trip instead of one per file. Elsewhere, or when io_uring is not
+ * available, a small thread pool issues the reads concurrently.
+ */
+class BatchFileReader
+{
+public:
+    enum class Method
+    {
+        IO_URING,   ///< One io_uring submission (Linux)
+        THREAD_POOL ///< Blocking reads spread over worker threads
+    };
+
+    /**
+     * @brief Read every file in the set
+     * @param files Files to read; data and ok are filled in
+     * @param preferred Method to try first
+     * @return Method that completed the batch
+     */
+    static Method readAll(std::vector<FileRead> &files, Method preferred = Method::IO_URING);
+
+    /**
+     * @brief Get a printable name for a method
+     * @param method Method
+     * @return "io_uring" or "thread_pool"
+     */
+    static const char *getMethodName(Method method);
+
+private:
+    /**
+     * @brief Read the files with one io_uring batch
+     * @param files Files to read
+     * @return false if io_uring is unavailable; unread files are left with ok == false
+     */
+    static bool readWithIoUring(std::vector<FileRead> &files);
+
+    /**
+     * @brief Read the files that are not yet ok on worker threads
+     * @param files Files to read
+     */
+    static void readWithThreadPool(std::vector<FileRead> &files);
+
+    static constexpr unsigned int MAX_IN_FLIGHT = 256;
+    static constexpr unsigned int MAX_THREADS = 8;
+};
+
+#endif // BATCHFILEREADER_H
@@ -0,0 +1,131 @@
+/**
+ * @file BusEffects.h
+ * @brief Effect chain applied once to the summed mix
+ */
+#ifndef BUSEFFECTS_H
+#define BUSEFFECTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+/**
+ * @struct BusEffectSettings
+ * @brief Parameters of the mix bus effects (effects.* keys)
+ */
+struct BusEffectSettings
+{
+    bool eq = false;               ///< effects.eq, three-band EQ
+    float lowGainDb = 0.0f;        ///< effects.lowGainDb, low shelf gain
+    float lowFrequency = 200.0f;   ///< effects.lowFrequency, low shelf corner in Hz
+    float midGainDb = 0.0f;        ///< effects.midGainDb, peaking band gain
+    float midFrequency = 2500.0f;  ///< effects.midFrequency, peaking band centre in Hz
+    float midQ = 1.0f;             ///< effects.midQ, peaking band quality
+    float highGainDb = 0.0f;       ///< effects.highGainDb, high shelf gain
+    float highFrequency = 8000.0f; ///< effects.highFrequency, high shelf corner in Hz
+
+    bool reverb = false;           ///< effects.reverb, convolution reverb
+    float reverbMix = 0.15f;       ///< effects.reverbMix, wet level (0-1)
+    float reverbTimeMs = 400.0f;   ///< effects.reverbTimeMs, decay to -60 dB of the built-in room
+    float reverbDamping = 0.5f;    ///< effects.reverbDamping, high-frequency damping of the built-in room (0-1)
+    std::string reverbImpulse;     ///< effects.reverbImpulse, impulse response file replacing the built-in room
+
+    bool compressor = false;       ///< effects.compressor, compressor/limiter after the EQ and reverb
+    float thresholdDb = -12.0f;    ///< effects.thresholdDb
+    float ratio = 4.0f;            ///< effects.ratio, 20 or more acts as a limiter
+    float attackMs = 5.0f;         ///< effects.attackMs
+    float releaseMs = 80.0f;       ///< effects.releaseMs
+    float makeupDb = 0.0f;         ///< effects.makeupDb
+
+    bool limiter = true;           ///< effects.limiter, peak limiter and soft clipper ending the chain
+    float limiterCeilingDb = -1.0f; ///< effects.limiterCeilingDb, highest output peak
+    float limiterReleaseMs = 50.0f; ///< effects.limiterReleaseMs, gain recovery time
+
+    /**
+     * @brief Apply a single setting
+     * @param name Setting name without the "effects." prefix, e.g. "reverbMix"
+     * @param value Setting value
+     * @return true if the name is known and the value valid, false otherwise
+     */
+    bool set(const std::string &name, const std::string &value);
+};
+
+/**
+ * @class BusEffectChain
+ * @brief EQ, convolution reverb, compressor and limiter processing the summed voices
+ *
+ * Runs once per period on the device thread, so its cost does not grow
+ * with the number of voices. configure() prepares everything, impulse
+ * response spectra included, on the calling thread and hands the result
+ * over through an atomic pointer. process() therefore never locks or
+ * allocates; a replaced setup is freed by the next configure() call.
+ *
+ * The limiter has no lookahead, so it adds no latency: its fast gain
+ * follower handles sustained overload, and a soft clipper above a knee
+ * just below the ceiling rounds off the transients it is too slow for.
+ * The output never exceeds the ceiling however many voices pile up.
+ */
+class BusEffectChain
+{
+public:
+    static constexpr std::size_t REVERB_BLOCK = 256;  ///< Convolution partition size in frames
+    static constexpr float MAX_REVERB_SECONDS = 2.0f; ///< Longest impulse response used
+
+    /**
+     * @brief Constructor
+     * @param sampleRate Mix sample rate
+     */
+    explicit BusEffectChain(unsigned int sampleRate);
+
+    /**
+     * @brief Destructor; the device thread must no longer call process()
+     */
+    ~BusEffectChain();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    BusEffectChain(const BusEffectChain &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    BusEffectChain &operator=(const BusEffectChain &) = delete;
+
+    /**
+     * @brief Replace the effect settings (any thread but the device thread)
+     * @param settings New settings
+     * @return false if the impulse response file could not be loaded; the built-in room is used then
+     */
+    bool configure(const BusEffectSettings &settings);
+
+    /**
+     * @brief Process a block of the mix in place (device thread)
+     * @param mix Interleaved stereo samples
+     * @param frames Number of frames
+     */
+    void process(float *mix, std::size_t frames);
+
+private:
+    struct Program;
+
+    unsigned int sampleRate_;
+
+    // Setup in use, owned by the device thread
+    Program *active_;
+
+    // Hand-over slots: configure() fills pending_, process() moves the setup it replaces to retired_
+    std::atomic<Program *> pending_;
+    std::atomic<Program *> retired_;
+
+    // Serializes configure() callers; the device thread never takes it
+    std::mutex configureMutex_;
+
+    // Filter and envelope state survives reconfiguration to avoid clicks
+    float eqState_[3][2][2];
+    float envelope_;
+    float limiterGain_;
+};
+
+#endif // BUSEFFECTS_H
@@ -0,0 +1,131 @@
+/**
+ * @file ClickSynth.h
+ * @brief Procedural key click model used as a pack without samples
+ */
+#ifndef CLICKSYNTH_H
+#define CLICKSYNTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <SFML/Audio.hpp>
+
+/**
+ * @struct ClickParams
+ * @brief Parameters of one synthesized keystroke
+ *
+ * The first three modes model the keycap and housing, the last one the
+ * ringing stabilizer spring.
+ */
+struct ClickParams
+{
+    static constexpr std::size_t MODES = 4;
+
+    float modeFrequency[MODES] = {}; ///< Resonant mode frequencies in Hz
+    float modeDecay[MODES] = {};     ///< Mode decay to -60 dB in seconds
+    float modeGain[MODES] = {};      ///< Mode amplitudes
+    float noiseGain = 0.0f;          ///< Amplitude of the contact noise burst
+    float noiseDecay = 0.0f;         ///< Noise decay to -60 dB in seconds
+    float noiseCutoff = 0.0f;        ///< Low-pass cutoff of the noise in Hz
+    std::uint32_t seed = 1;          ///< Noise generator seed
+};
+
+/**
+ * @class ClickVoice
+ * @brief Render state of one synthesized keystroke
+ *
+ * Small enough to live inside a mixer voice slot: the click is computed
+ * sample by sample, so it needs no sample memory and no load time. The
+ * four modes run side by side in SIMD lanes where SSE2 is available.
+ */
+class ClickVoice
+{
+public:
+    /**
+     * @brief Reset the voice to the start of a keystroke
+     * @param params Keystroke parameters
+     * @param sampleRate Output sample rate
+     */
+    void start(const ClickParams &params, unsigned int sampleRate);
+
+    /**
+     * @brief Add the next frames of the click to a stereo accumulator
+     * @param mix Interleaved stereo accumulator, frames * 2 floats
+     * @param frames Number of frames to render
+     * @param gain Output gain
+     * @return true while the click is still sounding, false once it has finished
+     */
+    bool render(float *mix, std::size_t frames, float gain);
+
+private:
+    // Two-pole resonator state, one lane per mode
+    alignas(16) float coef1_[ClickParams::MODES] = {};
+    alignas(16) float coef2_[ClickParams::MODES] = {};
+    alignas(16) float y1_[ClickParams::MODES] = {};
+    alignas(16) float y2_[ClickParams::MODES] = {};
+
+    float noiseLevel_ = 0.0f;
+    float noiseDecay_ = 0.0f;
+    float noiseCoef_ = 0.0f;
+    float noiseState_ = 0.0f;
+    std::uint32_t rng_ = 1;
+    std::uint64_t remaining_ = 0;
+};
+
+/**
+ * @class ClickSynth
+ * @brief The "synth:" pack built on ClickVoice
+ *
+ * Its sounds are addressed as "synth:click/<category>/<down|up>/<variant>"
+ * and are never decoded or cached: the path selects the click parameters,
+ * which are varied again for each keystroke.
+ */
+class ClickSynth
+{
+public:
+    static constexpr const char *PATH_PREFIX = "synth:";
+    static constexpr std::size_t VARIANTS = 8;  ///< Sounds per category and direction
+    static constexpr float MAX_DURATION = 0.3f; ///< Longest click in seconds
+
+    /**
+     * @brief Get the pseudo folder path of the synthesized pack
+     * @return "synth:click"
+     */
+    static std::string getFolderPath();
+
+    /**
+     * @brief Check whether a path refers to the synthesized pack
+     * @param path Sound or folder path
+     * @return true if the path starts with PATH_PREFIX
+     */
+    static bool isSynthPath(const std::string &path);
+
+    /**
+     * @brief Build the path of a synthesized sound
+     * @param categoryName Category folder name ("alpha", "space", ...)
+     * @param keyDown true for a key down sound
+     * @param variant Variant index below VARIANTS
+     * @return Sound path
+     */
+    static std::string getSoundPath(const std::string &categoryName, bool keyDown, std::size_t variant);
+
+    /**
+     * @brief Get the parameters of a keystroke
+     * @param path Sound path from getSoundPath()
+     * @param keystroke Running keystroke number, varies the click slightly each time
+     * @param params Parameters to fill
+     * @return false if the path is not a valid synthesized sound
+     */
+    static bool getParams(const std::string &path, std::uint32_t keystroke, ClickParams &params);
+
+    /**
+     * @brief Render a whole click into a buffer, for backends without a software mix
+     * @param params Keystroke parameters
+     * @param sampleRate Sample rate of the buffer
+     * @param buffer Buffer to fill with stereo samples
+     * @return true if successful, false otherwise
+     */
+    static bool renderBuffer(const ClickParams &params, unsigned int sampleRate, sf::SoundBuffer &buffer);
+};
+
+#endif // CLICKSYNTH_H
@@ -0,0 +1,63 @@
+/**
+ * @file Config.h
+ * @brief Application configuration loaded from a key=value file
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <chrono>
+#include "AudioBackend.h"
+#include "Logger.h"
+
+/**
+ * @struct AppConfig
+ * @brief Settings that are fixed at startup
+ *
+ * The file uses one "section.key = value" pair per line; '#' starts a
+ * comment. Missing keys keep their defaults.
+ */
+struct AppConfig
+{
+    AudioBackendConfig audio;                          ///< audio.* and effects.* keys
+    std::chrono::milliseconds idleTimeout{30000};      ///< power.idleTimeoutMs
+    bool keepDeviceWarm = false;                       ///< power.keepDeviceWarm
+    std::string inputStream;                           ///< input.stream endpoint, empty to disable
+    std::string inputStreamFormat = "text";            ///< input.streamFormat ("text" or "binary")
+    bool evdevInput = false;                           ///< input.evdev (Linux only)
+    std::string controlEndpoint;                       ///< control.endpoint, empty to disable
+    bool telemetryEnabled = false;                     ///< telemetry.enabled
+    std::string telemetryName = "keyboard-sounds-telemetry"; ///< telemetry.name (shared-memory segment)
+    LogLevel logLevel = LogLevel::INFO;                ///< log.level ("debug", "info", "warning", "error")
+    std::string logFile = "keyboard_sounds_debug.log"; ///< log.file, empty for stderr
+    std::string traceFile;                             ///< trace.file, records the whole session when set
+    bool watchPacks = false;                           ///< packs.watch, reload edited pack files live
+    std::chrono::milliseconds watchDebounce{300};      ///< packs.watchDebounceMs
+    bool trayMode = false;                             ///< ui.tray, hide to the tray and release the window
+    bool startHidden = false;                          ///< ui.startHidden, start in the tray (implies ui.tray)
+
+    /**
+     * @brief Load the configuration from a file
+     * @param path Path to the configuration file
+     * @return The loaded configuration, or defaults if the file does not exist
+     */
+    static AppConfig loadFromFile(const std::string &path);
+
+    /**
+     * @brief Apply a single setting
+     * @param key Setting name, e.g. "audio.backend"
+     * @param value Setting value
+     * @return true if the key is known and the value valid, false otherwise
+     */
+    bool set(const std::string &key, const std::string &value);
+
+    /**
+     * @brief Parse a boolean setting ("true"/"false", "1"/"0", "yes"/"no", "on"/"off")
+     * @param value Setting value
+     * @param out Parsed value
+     * @return true if the value is valid, false otherwise
+     */
+    static bool parseBool(const std::string &value, bool &out);
+};
+
+#endif // CONFIG_H
@@ -0,0 +1,96 @@
+/**
+ * @file ControlServer.h
+ * @brief Local IPC endpoint for runtime control and metrics
+ */
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @class ControlServer
+ * @brief Serves line-based requests on a Unix socket or Windows named pipe
+ *
+ * Each request is one line, "<command> [argument]". Each response is
+ * zero or more payload lines followed by "OK" or "ERR <reason>".
+ * Requests are handled on the server's own thread, one client at a time;
+ * a client that sends nothing for a few seconds is disconnected.
+ *
+ * Endpoints: "unix:<path>" (POSIX) or "pipe:<name>" (\\.\pipe\<name> on Windows).
+ */
+class ControlServer
+{
+public:
+    /**
+     * @brief Request handler
+     *
+     * Returns the payload for a request; throws std::invalid_argument to
+     * answer with ERR.
+     */
+    using Handler = std::function<std::string(const std::string &command, const std::string &argument)>;
+
+    /**
+     * @brief Constructor
+     * @param endpoint Endpoint specification
+     * @param handler Request handler, called on the server thread
+     */
+    ControlServer(const std::string &endpoint, Handler handler);
+
+    /**
+     * @brief Destructor
+     * Stops the server
+     */
+    ~ControlServer();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    ControlServer(const ControlServer &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    ControlServer &operator=(const ControlServer &) = delete;
+
+    /**
+     * @brief Start serving on the endpoint
+     * @return true if successful, false otherwise
+     */
+    bool start();
+
+    /**
+     * @brief Stop serving and join the server thread
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Server thread main loop
+     */
+    void serve();
+
+    /**
+     * @brief Handle one request line
+     * @param line Request without terminator
+     * @return Complete response text
+     */
+    std::string handleRequest(const std::string &line);
+
+    std::string endpoint_;
+    Handler handler_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+#ifdef _WIN32
+    void *handle_;    // Overlapped pipe HANDLE
+    void *stopEvent_; // Manual-reset event HANDLE, set by stop()
+#else
+    int listenFd_;
+    int wakeFd_;
+#endif
+};
+
+#endif // CONTROLSERVER_H
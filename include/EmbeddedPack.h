@@ -0,0 +1,94 @@
+/**
+ * @file EmbeddedPack.h
+ * @brief Access to the sound pack compiled into the executable
+ */
+#ifndef EMBEDDEDPACK_H
+#define EMBEDDEDPACK_H
+
+#include <cstdint>
+#include <string>
+#include <SFML/Audio.hpp>
+
+/**
+ * @struct EmbeddedSound
+ * @brief One pre-decoded sound in the read-only data of the executable
+ */
+struct EmbeddedSound
+{
+    const char *category;         ///< Category folder name ("alpha", "space", ...)
+    bool keyDown;                 ///< true for down sounds, false for up sounds
+    const std::int16_t *samples;  ///< Interleaved PCM
+    std::uint64_t sampleCount;    ///< Samples (frames * channels)
+    unsigned int channels;        ///< Channel count
+    unsigned int sampleRate;      ///< Sample rate in Hz
+};
+
+/**
+ * @class EmbeddedPack
+ * @brief Optional built-in pack produced by the pack-embedder tool
+ *
+ * Configure with -DKS_EMBED_PACK=<folder under sounds/> to convert that
+ * pack to conditioned PCM at build time. Its sounds are addressed as
+ * "embedded:<pack>/<category>/<down|up>/<index>" and load without any
+ * file I/O or decoding.
+ */
+class EmbeddedPack
+{
+public:
+    static constexpr const char *PATH_PREFIX = "embedded:";
+
+    /**
+     * @brief Check whether a pack was compiled in
+     * @return true if available
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Get the pseudo folder path of the built-in pack
+     * @return "embedded:<pack>", or an empty string if none is compiled in
+     */
+    static std::string getFolderPath();
+
+    /**
+     * @brief Check whether a path refers to the built-in pack
+     * @param path Sound or folder path
+     * @return true if the path starts with PATH_PREFIX
+     */
+    static bool isEmbeddedPath(const std::string &path);
+
+    /**
+     * @brief Get the number of embedded sounds
+     * @return Sound count
+     */
+    static std::size_t getSoundCount();
+
+    /**
+     * @brief Get an embedded sound by index
+     * @param index Index below getSoundCount()
+     * @return The sound
+     */
+    static const EmbeddedSound &getSound(std::size_t index);
+
+    /**
+     * @brief Build the sound path for an embedded sound
+     * @param index Index below getSoundCount()
+     * @return Sound path
+     */
+    static std::string getSoundPath(std::size_t index);
+
+    /**
+     * @brief Get the size of all embedded PCM
+     * @return Size in bytes
+     */
+    static std::size_t getByteSize();
+
+    /**
+     * @brief Fill a sound buffer from an embedded sound path
+     * @param path Path returned by getSoundPath()
+     * @param buffer Buffer to fill
+     * @return true if successful, false if the path is not an embedded sound
+     */
+    static bool loadBuffer(const std::string &path, sf::SoundBuffer &buffer);
+};
+
+#endif // EMBEDDEDPACK_H
@@ -0,0 +1,255 @@
+/**
+ * @file Engine.h
+ * @brief The sound engine without any user interface
+ */
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <set>
+#include "SoundManager.h"
+#include "SFMLSoundPlayer.h"
+#include "KeyboardHookManager.h"
+#include "Config.h"
+#include "ControlServer.h"
+#include "PackWatcher.h"
+#include "StartupOrchestrator.h"
+#include "TelemetryRing.h"
+
+/**
+ * @class Engine
+ * @brief Owns the packs, the player, the key handling and the services around them
+ *
+ * Both front ends are thin shells around it: the Win32 window in
+ * Application and the headless keysound-cli daemon. The engine holds no
+ * window, font or other GUI resource, and nothing in it depends on a
+ * message loop except the optional Windows keyboard hook.
+ *
+ * Changes made on the engine's own threads (control requests and pack
+ * watcher updates) are reported through the change listener so a front
+ * end can mirror them.
+ */
+class Engine
+{
+public:
+    /**
+     * @brief Changes reported to the change listener
+     */
+    enum class Change
+    {
+        PACK_SELECTED, ///< Value is the index of the pack now in use
+        PACK_ADDED,    ///< Value is the index of a newly found pack
+        VOLUME,        ///< Value is the new volume (0-100)
+        PROFILE        ///< Value is the new latency optimization level (0-3)
+    };
+
+    /**
+     * @brief Called on the thread that made the change
+     */
+    using ChangeListener = std::function<void(Change change, int value)>;
+
+    /**
+     * @brief Constructor
+     * @param soundFolder Path to the folder containing sound packs
+     * @param config Startup configuration
+     * @param startTime Time the process started, for the startup report
+     */
+    Engine(const std::string &soundFolder, const AppConfig &config,
+           std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now());
+
+    /**
+     * @brief Destructor
+     * Stops the services and uninstalls the hook
+     */
+    ~Engine();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    Engine(const Engine &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    Engine &operator=(const Engine &) = delete;
+
+    /**
+     * @brief Set the listener for changes made by control requests and the pack watcher
+     *
+     * Set it before startServices(); it is not synchronized with those threads.
+     * @param listener Listener, or nullptr for none
+     */
+    void setChangeListener(ChangeListener listener);
+
+    /**
+     * @brief Add the engine's startup steps to a startup graph
+     *
+     * Adds install_hook (when requested, on the caller thread), open_device,
+     * scan_packs, load_pack, decode_common and attach_inputs.
+     * @param startup Startup graph to add to
+     * @param installHook true to install the system-wide keyboard hook (Windows only)
+     * @param packName Folder name of the pack to start with; empty for the default one
+     */
+    void addStartupTasks(StartupOrchestrator &startup, bool installHook, const std::string &packName = "");
+
+    /**
+     * @brief Record the startup report once the startup graph has run
+     * @param startup Startup graph passed to addStartupTasks()
+     */
+    void finishStartup(const StartupOrchestrator &startup);
+
+    /**
+     * @brief Start the control endpoint and the pack watcher, if configured
+     */
+    void startServices();
+
+    /**
+     * @brief Stop the control endpoint and the pack watcher
+     */
+    void stopServices();
+
+    /**
+     * @brief Get a copy of the known pack folders
+     * @return Pack folders, in the order they were found
+     */
+    std::vector<std::string> getSoundPacks() const;
+
+    /**
+     * @brief Get a pack folder by index
+     * @param index Index into the pack list
+     * @return Pack folder, or an empty string if out of range
+     */
+    std::string getSoundPack(int index) const;
+
+    /**
+     * @brief Get the index of the pack in use
+     * @return Index into the pack list, or -1 if the pack is not listed
+     */
+    int getCurrentPackIndex() const;
+
+    /**
+     * @brief Find a sound pack by folder name
+     * @param name Folder name of the pack
+     * @param folder Receives the pack folder path
+     * @return Index into the pack list, or -1 if not found
+     */
+    int findSoundPack(const std::string &name, std::string &folder) const;
+
+    /**
+     * @brief Switch packs and decode the common keys of the new one
+     *
+     * Records how far the resident set peaked above its starting point
+     * while doing so (exact on Linux; elsewhere only a new process peak
+     * shows up).
+     * @param folder Pack folder
+     * @return true if the pack was switched, false if the old pack is kept
+     */
+    bool switchSoundPack(const std::string &folder);
+
+    /**
+     * @brief Sets the volume level
+     * @param volume Volume level, clamped to 0-100
+     */
+    void setVolume(int volume);
+
+    /**
+     * @brief Gets the current volume level
+     * @return Current volume (0-100)
+     */
+    int getVolume() const;
+
+    /**
+     * @brief Sets the latency optimization level
+     * @param level Optimization level, clamped to 0-3
+     */
+    void setLatencyOptimization(int level);
+
+    /**
+     * @brief Gets the latency optimization level
+     * @return Current level (0-3)
+     */
+    int getLatencyOptimization() const;
+
+    /**
+     * @brief Handle a control request (runs on the control server thread)
+     * @param command Request command
+     * @param argument Request argument
+     * @return Response payload
+     * @throws std::invalid_argument for an unknown command or a bad argument
+     */
+    std::string handleControlCommand(const std::string &command, const std::string &argument);
+
+    /**
+     * @brief Format the metrics report, as returned by the metrics request
+     * @return One "name=value" pair per line
+     */
+    std::string dumpMetrics() const;
+
+private:
+    /**
+     * @brief Loads available sound packs
+     * @return true if at least one sound pack was found, false otherwise
+     */
+    bool loadSoundPacks();
+
+    /**
+     * @brief Attach the input sources enabled in the configuration
+     */
+    void attachInputSources();
+
+    /**
+     * @brief Apply a batch of pack tree changes (runs on the pack watcher thread)
+     *
+     * New pack folders are appended to the list, touched categories of the
+     * current pack are re-listed and changed files that are cached are
+     * re-decoded. Nothing else is rescanned.
+     * @param paths Changed paths relative to the sounds folder
+     */
+    void handlePackChanges(const std::set<std::string> &paths);
+
+    /**
+     * @brief Report a change to the listener, if any
+     */
+    void notify(Change change, int value);
+
+    std::string soundFolder_;
+    AppConfig config_;
+    std::vector<std::string> soundPacks_;
+    mutable std::mutex packsMutex_; // Guards soundPacks_, which the pack watcher appends to
+
+    // Declared before the engine parts so it outlives every writer
+    std::unique_ptr<TelemetryRing> telemetry_;
+
+    std::unique_ptr<SoundManager> soundManager_;
+    std::unique_ptr<SFMLSoundPlayer> soundPlayer_;
+    std::unique_ptr<KeyboardHookManager> hookManager_;
+    std::unique_ptr<ControlServer> controlServer_;
+    std::unique_ptr<PackWatcher> packWatcher_;
+
+    ChangeListener listener_;
+
+    // Settings
+    std::atomic<int> volume_;
+    std::atomic<int> latencyOptimizationLevel_;
+
+    // Startup timing, reported by the metrics request
+    std::chrono::steady_clock::time_point startTime_;
+    std::string startupReport_;
+
+    // Resident set growth during the last pack switch, reported by the metrics request
+    std::atomic<std::size_t> lastSwitchPeakRssBytes_;
+
+    // Mix bus effects as last applied; only the control thread changes them
+    BusEffectSettings effectSettings_;
+
+    static constexpr int DEFAULT_VOLUME = 50;
+    static constexpr int DEFAULT_OPTIMIZATION = 2;
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,134 @@
+/**
+ * @file EvdevInputSource.h
+ * @brief Linux input source reading keyboards from /dev/input
+ */
+#ifndef EVDEVINPUTSOURCE_H
+#define EVDEVINPUTSOURCE_H
+
+#ifdef __linux__
+
+#include "InputSource.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @class EvdevInputSource
+ * @brief Watches every keyboard under /dev/input from one epoll loop
+ *
+ * Keyboards plugged in later are picked up through inotify; unplugged
+ * devices are dropped when their read fails. Kernel key codes are
+ * translated to engine (virtual-key) codes, and event timestamps are
+ * the kernel's own, switched to CLOCK_MONOTONIC on each device.
+ */
+class EvdevInputSource : public InputSource
+{
+public:
+    /**
+     * @brief Constructor
+     * @param inputDir Directory holding the event device nodes
+     */
+    explicit EvdevInputSource(const std::string &inputDir = "/dev/input");
+
+    /**
+     * @brief Destructor
+     * Stops the event loop and closes all devices
+     */
+    ~EvdevInputSource() override;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    EvdevInputSource(const EvdevInputSource &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    EvdevInputSource &operator=(const EvdevInputSource &) = delete;
+
+    bool start(EventCallback callback) override;
+    void stop() override;
+    std::string getName() const override;
+
+    /**
+     * @brief Watch an already open descriptor producing struct input_event records
+     * @param fd Descriptor to take ownership of (a device node, pipe or socket)
+     * @param name Name used in logs
+     * @return true if successful, false otherwise
+     */
+    bool addDevice(int fd, const std::string &name);
+
+    /**
+     * @brief Get the number of devices currently watched
+     * @return Device count
+     */
+    std::size_t getDeviceCount() const;
+
+    /**
+     * @brief Translate a kernel key code to an engine key code
+     * @param code Linux KEY_* code
+     * @return Virtual-key code, or 0 if the key has no mapping
+     */
+    static std::uint16_t translateKeyCode(std::uint16_t code);
+
+private:
+    /**
+     * @brief Epoll loop run on the source thread
+     */
+    void eventLoop();
+
+    /**
+     * @brief Open a device node if it is a keyboard
+     * @param path Path to the event node
+     */
+    void openDeviceIfKeyboard(const std::string &path);
+
+    /**
+     * @brief Drain and dispatch pending records from a device
+     * @param fd Device descriptor
+     * @return false if the device is gone and must be removed
+     */
+    bool readDevice(int fd);
+
+    /**
+     * @brief Handle pending inotify notifications for the input directory
+     */
+    void handleHotplug();
+
+    /**
+     * @brief Stop watching and close a device
+     * @param fd Device descriptor
+     */
+    void removeDevice(int fd);
+
+    std::string inputDir_;
+    EventCallback callback_;
+
+    int epollFd_;
+    int inotifyFd_;
+    int wakeFd_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    /**
+     * @brief Per-device state; a stream descriptor may split records
+     */
+    struct Device {
+        std::string name;
+        std::string path;
+        unsigned char partial[32];
+        std::size_t partialSize;
+        bool monotonicClock; // Records carry CLOCK_MONOTONIC (steady_clock) times
+    };
+
+    // Watched descriptors (fd -> device)
+    mutable std::mutex devicesMutex_;
+    std::unordered_map<int, Device> devices_;
+};
+
+#endif // __linux__
+
+#endif // EVDEVINPUTSOURCE_H
@@ -0,0 +1,61 @@
+/**
+ * @file InputSource.h
+ * @brief Interface for keyboard event sources feeding the hook manager
+ */
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+static constexpr std::size_t KEY_CODE_COUNT = 256; ///< Engine key codes are one byte
+
+/**
+ * @struct KeyEvent
+ * @brief A single key transition in engine key codes
+ *
+ * Engine key codes use the Windows virtual-key numbering, so sources on
+ * other platforms translate their native codes before dispatching.
+ */
+struct KeyEvent
+{
+    std::uint16_t keyCode = 0;                       ///< Virtual-key code
+    bool keyDown = false;                            ///< true for press, false for release
+    bool injected = false;                           ///< Synthesized by other software
+    std::chrono::steady_clock::time_point timestamp; ///< When the source observed the event
+};
+
+/**
+ * @class InputSource
+ * @brief Produces key events on its own thread and hands them to a callback
+ */
+class InputSource
+{
+public:
+    using EventCallback = std::function<void(const KeyEvent &)>;
+
+    virtual ~InputSource() = default;
+
+    /**
+     * @brief Start delivering events
+     * @param callback Called from the source thread for every event
+     * @return true if successful, false otherwise
+     */
+    virtual bool start(EventCallback callback) = 0;
+
+    /**
+     * @brief Stop delivering events and join the source thread
+     */
+    virtual void stop() = 0;
+
+    /**
+     * @brief Get the source name for logging
+     * @return Source name
+     */
+    virtual std::string getName() const = 0;
+};
+
+#endif // INPUTSOURCE_H
@@ -0,0 +1,50 @@
+/**
+ * @file KeyPredictor.h
+ * @brief Learns which keys follow which, to preload their sounds ahead of time
+ */
+#ifndef KEYPREDICTOR_H
+#define KEYPREDICTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class KeyPredictor
+ * @brief Key sequence model behind predictive preloading
+ *
+ * Remembers every key seen right after another one. On each press it
+ * returns up to `level` keys that have followed the pressed key before, in
+ * no particular order. Level 0 predicts nothing and forgets what was
+ * learned; level 1 keeps a shorter history. Not thread-safe; the hook
+ * manager's input worker owns the instance, and prefetch-sim replays
+ * traces through it.
+ */
+class KeyPredictor
+{
+public:
+    static constexpr std::size_t KEY_HISTORY_LENGTH = 5;
+
+    /**
+     * @brief Learn from a key press and list the keys to preload
+     * @param keyCode Engine key code that was pressed
+     * @param level Latency optimization level (0-3)
+     * @param predicted Cleared, then filled with the keys whose sounds to preload
+     */
+    void observe(std::uint16_t keyCode, int level, std::vector<std::uint16_t> &predicted);
+
+    /**
+     * @brief Forget everything learned
+     */
+    void clear();
+
+private:
+    int level_ = 2;
+    std::deque<std::uint16_t> recentKeys_;
+    std::unordered_map<std::uint16_t, std::unordered_set<std::uint16_t>> keyFollowers_;
+};
+
+#endif // KEYPREDICTOR_H
@@ -0,0 +1,82 @@
+/**
+ * @file KeyThrottle.h
+ * @brief Per-key rate limiting of key sounds under the DROP overload policy
+ */
+#ifndef KEYTHROTTLE_H
+#define KEYTHROTTLE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "AudioBackend.h"
+#include "InputSource.h"
+
+/**
+ * @class KeyThrottle
+ * @brief Decides whether a key event gets a sound
+ *
+ * Under OverloadPolicy::DROP a key pressed again within REPEAT_INTERVAL of
+ * its last press, and a key released within MIN_HOLD of its press, stay
+ * silent, which keeps bursts from stacking up voices. Under
+ * OverloadPolicy::LIMIT every event is let through and the mix bus limiter
+ * handles the level instead. The policy is passed with every event, so the
+ * caller reads it from whatever settings it has published.
+ *
+ * Press times live in one atomic per key code, so input sources on
+ * different threads may share a throttle without locking.
+ */
+class KeyThrottle
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds REPEAT_INTERVAL{25}; ///< Shortest press-to-press time with a sound
+    static constexpr std::chrono::milliseconds MIN_HOLD{20};        ///< Shortest press-to-release time with a sound
+
+    /**
+     * @brief Constructor
+     */
+    KeyThrottle();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    KeyThrottle(const KeyThrottle &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    KeyThrottle &operator=(const KeyThrottle &) = delete;
+
+    /**
+     * @brief Record a key press
+     * @param keyCode Engine key code; codes from KEY_CODE_COUNT up are always let through
+     * @param now Time of the event
+     * @param policy Overload policy to apply
+     * @return true if the press should play a sound
+     */
+    bool allowKeyDown(std::uint16_t keyCode, Clock::time_point now, OverloadPolicy policy);
+
+    /**
+     * @brief Record a key release
+     * @param keyCode Engine key code; codes from KEY_CODE_COUNT up are always let through
+     * @param now Time of the event
+     * @param policy Overload policy to apply
+     * @return true if the release should play a sound
+     */
+    bool allowKeyUp(std::uint16_t keyCode, Clock::time_point now, OverloadPolicy policy);
+
+    /**
+     * @brief Get the number of events kept silent since construction
+     * @return Dropped event count
+     */
+    std::uint64_t getDroppedCount() const;
+
+private:
+    // Last press per key in steady_clock ticks, 0 if never pressed
+    std::array<std::atomic<Clock::rep>, KEY_CODE_COUNT> lastKeyDown_;
+    std::atomic<std::uint64_t> dropped_;
+};
+
+#endif // KEYTHROTTLE_H
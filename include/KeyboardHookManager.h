@@ -5,21 +5,63 @@
 #ifndef KEYBOARDHOOKMANAGER_H
 #define KEYBOARDHOOKMANAGER_H
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <string>
 #include <unordered_set>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <deque>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+#include "InputSource.h"
+#include "KeyPredictor.h"
+#include "KeyThrottle.h"
+#include "ProfiledMutex.h"
 
 // Forward declarations
 class SoundManager;
 class SFMLSoundPlayer;
 
+/**
+ * @struct HookSettings
+ * @brief Configuration read on every key event
+ *
+ * Published as an immutable snapshot; setters copy the current one, change
+ * the copy and swap it in.
+ */
+struct HookSettings
+{
+    int latencyOptimizationLevel = 2;                      ///< 0-3, where 3 is maximum
+    OverloadPolicy overloadPolicy = OverloadPolicy::LIMIT; ///< Whether fast repeats and releases are skipped
+    bool keyFilteringEnabled = false;                      ///< Whether filteredKeys is applied
+    std::bitset<KEY_CODE_COUNT> filteredKeys;              ///< Keys that play no sound
+};
+
 /**
  * @class KeyboardHookManager
  * @brief Manages Windows keyboard hooks to detect key events and play corresponding sounds
+ *
+ * Events from additional InputSource instances (e.g. evdev on Linux) go
+ * through the same dispatchKeyEvent() path as the Windows hook. Elsewhere
+ * there is no global hook and input sources are the only way in.
+ *
+ * dispatchKeyEvent() may run on several source threads at once. Reading
+ * the settings takes no lock: they come from an immutable HookSettings
+ * snapshot behind an atomic pointer. Per-key state is kept in atomics, and
+ * key presses are handed to an input worker through a wait-free ring.
+ * Queueing the sound still locks inside the player (queueMutex_, and
+ * armMutex_ for key-up voices). The worker owns the learned key sequences
+ * and preloads the sounds they predict.
  */
 class KeyboardHookManager
 {
@@ -49,15 +91,28 @@ public:
 
     /**
      * @brief Install the keyboard hook
-     * @return true if successful, false otherwise
+     * @return true if successful, false otherwise (always on platforms without one)
      */
     bool installHook();
 
     /**
-     * @brief Uninstall the keyboard hook
+     * @brief Uninstall the keyboard hook and stop all attached input sources
      */
     void uninstallHook();
 
+    /**
+     * @brief Attach and start an additional input source
+     * @param source Source to take ownership of
+     * @return true if the source started, false otherwise
+     */
+    bool addInputSource(std::unique_ptr<InputSource> source);
+
+    /**
+     * @brief Process a key event from any input source
+     * @param event Key event in engine key codes
+     */
+    void dispatchKeyEvent(const KeyEvent &event);
+
     /**
      * @brief Set an option to filter specific keys
      * @param enabled Whether key filtering is enabled
@@ -68,13 +123,13 @@ public:
      * @brief Add a key to the filter list
      * @param vkCode Virtual key code to add
      */
-    void addKeyToFilter(WORD vkCode);
+    void addKeyToFilter(std::uint16_t vkCode);
 
     /**
      * @brief Remove a key from the filter list
      * @param vkCode Virtual key code to remove
      */
-    void removeKeyFromFilter(WORD vkCode);
+    void removeKeyFromFilter(std::uint16_t vkCode);
     
     /**
      * @brief Set latency optimization level
@@ -82,18 +137,85 @@ public:
      */
     void setLatencyOptimization(int level);
 
-private:
     /**
-     * @brief Preload sounds for commonly used keys
+     * @brief Choose whether fast repeats and releases are skipped
+     * @param policy DROP to skip them, LIMIT to play every event
+     */
+    void setOverloadPolicy(OverloadPolicy policy);
+
+    /**
+     * @brief Preload sounds for commonly used keys from the current pack
+     *
+     * Thread-safe; startup runs it on a worker once the pack is loaded.
      */
     void preloadCommonSounds();
-    
+
+private:
     /**
-     * @brief Preload sounds for likely key combinations
-     * @param baseKey The key that was just pressed
+     * @brief Pins the current settings snapshot for the lifetime of the reader
+     *
+     * Costs two atomic increments; a snapshot replaced while readers are
+     * active is freed by a later update once none are.
      */
-    void preloadPredictedKeys(WORD baseKey);
+    class SettingsReader
+    {
+    public:
+        explicit SettingsReader(KeyboardHookManager &manager);
+        ~SettingsReader();
+        SettingsReader(const SettingsReader &) = delete;
+        SettingsReader &operator=(const SettingsReader &) = delete;
+
+        const HookSettings &operator*() const { return *settings_; }
+        const HookSettings *operator->() const { return settings_; }
+
+    private:
+        std::atomic<std::uint32_t> &readers_;
+        const HookSettings *settings_;
+    };
+
+    /**
+     * @brief One key press waiting for the input worker
+     */
+    struct LearnSlot
+    {
+        std::atomic<std::uint64_t> sequence{0}; // 2 * index + 2 once written
+        std::atomic<std::uint16_t> keyCode{0};
+    };
+
+    static constexpr std::size_t LEARN_CAPACITY = 256; // Power of two
+
+    /**
+     * @brief Publish a changed copy of the settings
+     * @param edit Applied to the copy before it is published
+     */
+    void updateSettings(const std::function<void(HookSettings &)> &edit);
+
+    /**
+     * @brief Hand a key press to the input worker (wait-free, any thread)
+     * @param vkCode Virtual key code
+     */
+    void postKeyToLearn(std::uint16_t vkCode);
+
+    /**
+     * @brief Input worker body
+     */
+    void learnLoop();
+
+    /**
+     * @brief Learn from a key press and preload what usually follows it (input worker)
+     * @param vkCode Virtual key code
+     * @param level Latency optimization level of the current snapshot
+     */
+    void learnKey(std::uint16_t vkCode, int level);
+
+    /**
+     * @brief Preload the sounds of keys likely to come next (input worker)
+     * @param keys Keys predicted by the KeyPredictor
+     * @param level Latency optimization level of the current snapshot
+     */
+    void preloadPredictedKeys(const std::vector<std::uint16_t> &keys, int level);
     
+#ifdef _WIN32
     /**
      * @brief Windows keyboard hook procedure
      * @param nCode Hook code
@@ -103,41 +225,76 @@ private:
      */
     static LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam);
 
+    /**
+     * @brief Foreground window change callback; releases armed key-up voices
+     */
+    static void CALLBACK ForegroundChangedProc(HWINEVENTHOOK hook, DWORD eventType, HWND hwnd, LONG idObject,
+                                               LONG idChild, DWORD eventThread, DWORD eventTime);
+#endif
+
     /**
      * @brief Process a key down event
      * @param vkCode Virtual key code
+     * @param timestamp When the source observed the event
+     * @param settings Settings snapshot of this event
      */
-    void handleKeyDown(WORD vkCode);
+    void handleKeyDown(std::uint16_t vkCode, std::chrono::steady_clock::time_point timestamp, const HookSettings &settings);
 
     /**
      * @brief Process a key up event
      * @param vkCode Virtual key code
+     * @param timestamp When the source observed the event
+     * @param settings Settings snapshot of this event
      */
-    void handleKeyUp(WORD vkCode);
+    void handleKeyUp(std::uint16_t vkCode, std::chrono::steady_clock::time_point timestamp, const HookSettings &settings);
 
     /**
      * @brief Check if a key should be processed
      * @param vkCode Virtual key code
+     * @param settings Settings snapshot of this event
      * @return true if the key should be processed, false otherwise
      */
-    bool shouldProcessKey(WORD vkCode) const;
+    static bool shouldProcessKey(std::uint16_t vkCode, const HookSettings &settings);
 
     // References to dependent objects
     SoundManager &soundManager_;
     SFMLSoundPlayer &soundPlayer_;
 
-    // Windows hook handle
+#ifdef _WIN32
+    // Windows hook handles
     HHOOK hook_;
+    HWINEVENTHOOK foregroundHook_;
+#endif
+
+    // Additional input sources
+    std::vector<std::unique_ptr<InputSource>> inputSources_;
+
+    // Settings snapshot read by the hook path; setters serialize on settingsMutex_
+    std::atomic<const HookSettings *> settings_;
+    std::atomic<std::uint32_t> settingsReaders_;
+    ProfiledMutex settingsMutex_{"hook_settings_mutex"};
+    std::unique_ptr<const HookSettings> currentSettings_;
+    std::vector<std::unique_ptr<const HookSettings>> retiredSettings_;
+
+    // Per-key rate limiting under the DROP overload policy
+    KeyThrottle throttle_;
 
-    // Key filtering
-    bool keyFilteringEnabled_;
-    std::unordered_set<WORD> filteredKeys_;
+    // Currently pressed keys, to ignore key repeat
+    std::array<std::atomic<bool>, KEY_CODE_COUNT> pressedKeys_;
 
-    // Performance optimization level
-    int latencyOptimizationLevel_;
+    // Key presses on their way to the input worker
+    std::array<LearnSlot, LEARN_CAPACITY> learnSlots_;
+    std::atomic<std::uint64_t> learnWriteIndex_;
+    std::atomic<bool> learnPending_;
+    std::atomic<bool> learnRunning_;
+    std::mutex learnWakeMutex_;
+    std::condition_variable learnWakeCv_;
+    std::thread learnThread_;
 
-    // Currently pressed keys
-    static std::unordered_set<WORD> pressedKeys_;
+    // Input worker only: read position and the learned key sequences
+    std::uint64_t learnCursor_;
+    KeyPredictor predictor_;
+    std::vector<std::uint16_t> predictedKeys_;
 
     // Singleton instance for hook callback
     static KeyboardHookManager *instance_;
@@ -0,0 +1,328 @@
+/**
+ * @file Logger.h
+ * @brief Asynchronous leveled logger with per-thread lock-free staging
+ */
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @enum LogLevel
+ * @brief Message severity, in increasing order
+ */
+enum class LogLevel : int
+{
+    DEBUG = 0,
+    INFO = 1,
+    WARNING = 2,
+    ERR = 3 ///< Not ERROR, which wingdi.h defines as a macro
+};
+
+// Messages below this level are removed at compile time
+#ifndef KS_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define KS_LOG_MIN_LEVEL 1
+#else
+#define KS_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+/**
+ * @class Logger
+ * @brief Process-wide logger writing from a background flusher thread
+ *
+ * Each logging thread formats into a thread-local fixed buffer and pushes
+ * the record into its own single-producer ring, so after a thread's first
+ * message logging never takes a lock, allocates or touches the disk on the
+ * caller's thread. Repeats of the same message from one thread are
+ * suppressed for SUPPRESS_WINDOW and reported as a count, on the next
+ * emission or by the flusher once per window and at stop().
+ */
+class Logger
+{
+public:
+    static constexpr std::size_t MAX_MESSAGE = 240;
+    static constexpr std::size_t THREAD_CAPACITY = 128; // Records per thread, power of two
+    static constexpr std::chrono::seconds SUPPRESS_WINDOW{5};
+    static constexpr std::chrono::seconds FLUSH_INTERVAL{1}; // Bounds the delay of a missed wakeup
+
+    /**
+     * @brief Get the process-wide logger
+     * @return The logger
+     */
+    static Logger &instance();
+
+    /**
+     * @brief Destructor
+     * Flushes staged records and stops the flusher
+     */
+    ~Logger();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    Logger(const Logger &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * @brief Open the output and start the flusher thread
+     * @param path Log file path, empty for stderr
+     * @return true if successful, false otherwise
+     */
+    bool start(const std::string &path);
+
+    /**
+     * @brief Write every staged record and stop the flusher thread
+     */
+    void stop();
+
+    /**
+     * @brief Set the runtime level filter
+     * @param level Lowest level that is recorded
+     */
+    void setLevel(LogLevel level);
+
+    /**
+     * @brief Get the runtime level filter
+     * @return Lowest level that is recorded
+     */
+    LogLevel getLevel() const;
+
+    /**
+     * @brief Check whether a level passes the runtime filter
+     * @param level Level to check
+     * @return true if messages at this level are recorded
+     */
+    bool isEnabled(LogLevel level) const
+    {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Stage one formatted message from the calling thread
+     * @param level Message level
+     * @param text Message text (truncated to MAX_MESSAGE)
+     * @param length Text length in bytes
+     */
+    void write(LogLevel level, const char *text, std::size_t length);
+
+    /**
+     * @brief Get the number of records dropped because a thread ring was full
+     * @return Dropped record count
+     */
+    std::uint64_t getDroppedCount() const;
+
+    /**
+     * @brief Get the number of repeated messages that were suppressed
+     * @return Suppressed message count
+     */
+    std::uint64_t getSuppressedCount() const;
+
+    /**
+     * @brief Parse a level name ("debug", "info", "warning", "error")
+     * @param name Level name
+     * @param level Parsed level
+     * @return true if the name is valid, false otherwise
+     */
+    static bool parseLevel(const std::string &name, LogLevel &level);
+
+private:
+    Logger() = default;
+
+    struct Record
+    {
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point wallTime;
+        std::chrono::steady_clock::time_point time;
+        std::uint64_t hash = 0;         // Message hash when tracked for repeats, 0 otherwise
+        std::uint16_t messageLength = 0; // Length without the repeat count suffix
+        std::uint16_t length = 0;
+        char text[MAX_MESSAGE];
+    };
+
+    /**
+     * @brief Repeat tracking for one message
+     *
+     * The state packs the top REPEAT_TAG_BITS of the message hash with the
+     * number of suppressed repeats not reported yet. The owning thread sets
+     * the tag and counts up; the flusher only takes the count.
+     */
+    struct RepeatEntry
+    {
+        std::atomic<std::uint64_t> state{0};
+        std::chrono::steady_clock::time_point lastEmitted; // Owning thread only
+    };
+
+    static constexpr int REPEAT_COUNT_BITS = 24;
+    static constexpr std::uint64_t REPEAT_COUNT_MASK = (1ULL << REPEAT_COUNT_BITS) - 1;
+
+    /**
+     * @brief Last emitted text of a tracked message, to name it in a repeat summary
+     */
+    struct RepeatText
+    {
+        std::uint64_t tag = 0;
+        LogLevel level = LogLevel::INFO;
+        std::uint16_t length = 0;
+        char text[MAX_MESSAGE];
+    };
+
+    /**
+     * @brief Single-producer ring owned by one logging thread
+     */
+    struct ThreadBuffer
+    {
+        std::array<Record, THREAD_CAPACITY> records;
+        std::atomic<std::uint64_t> head{0}; // Written by the owning thread
+        std::atomic<std::uint64_t> tail{0}; // Written by the flusher
+        std::atomic<bool> retired{false};   // Owning thread has exited
+
+        std::array<RepeatEntry, 32> repeats;
+
+        // Flusher only, indexed like repeats
+        std::array<RepeatText, 32> repeatTexts;
+    };
+
+    friend struct ThreadBufferHandle;
+
+    /**
+     * @brief Get (registering on first use) the calling thread's buffer
+     * @return The buffer
+     */
+    ThreadBuffer &threadBuffer();
+
+    /**
+     * @brief Wake the flusher if it is idle
+     */
+    void notifyFlusher();
+
+    /**
+     * @brief Flusher thread body
+     */
+    void flushLoop();
+
+    /**
+     * @brief Move staged records from every thread ring to the output
+     * @param reportAll Also write every repeat count no later message has reported
+     * @return Number of records written
+     */
+    std::size_t drain(bool reportAll);
+
+    /**
+     * @brief Write the unreported repeat counts of one thread as summary lines
+     * @param buffer Thread buffer, already drained
+     */
+    void reportRepeats(ThreadBuffer &buffer);
+
+    /**
+     * @brief Write one line with timestamp and level to the output
+     */
+    void writeLine(LogLevel level, std::chrono::system_clock::time_point wallTime, const char *text,
+                   std::size_t length);
+
+    std::atomic<int> level_{static_cast<int>(LogLevel::INFO)};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> suppressed_{0};
+
+    std::mutex registryMutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::atomic<bool> pending_{false};
+    bool running_ = false;
+    std::thread flusherThread_;
+
+    // Flusher thread only (or the stopping thread once the flusher is joined)
+    std::ofstream file_;
+    std::ostream *out_ = nullptr;
+    std::vector<const Record *> batch_;
+};
+
+/**
+ * @class LogLine
+ * @brief Formats one message into the calling thread's scratch buffer
+ *
+ * Use through the KS_LOG_* macros; the message is staged on destruction.
+ */
+class LogLine
+{
+public:
+    explicit LogLine(LogLevel level);
+    ~LogLine();
+
+    LogLine(const LogLine &) = delete;
+    LogLine &operator=(const LogLine &) = delete;
+
+    std::ostream &stream();
+
+private:
+    class FixedBuffer : public std::streambuf
+    {
+    public:
+        void reset();
+        std::size_t size() const;
+        const char *data() const;
+
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char *s, std::streamsize count) override;
+
+    private:
+        char data_[Logger::MAX_MESSAGE];
+        std::size_t size_ = 0;
+    };
+
+    struct Scratch
+    {
+        FixedBuffer buffer;
+        std::ostream stream{&buffer};
+    };
+
+    static Scratch &scratch();
+
+    LogLevel level_;
+    Scratch &scratch_;
+};
+
+#define KS_LOG(level, message)                          \
+    do {                                                \
+        if (Logger::instance().isEnabled(level)) {      \
+            LogLine ksLogLine(level);                   \
+            ksLogLine.stream() << message;              \
+        }                                               \
+    } while (0)
+
+#if KS_LOG_MIN_LEVEL <= 0
+#define KS_LOG_DEBUG(message) KS_LOG(LogLevel::DEBUG, message)
+#else
+#define KS_LOG_DEBUG(message) do {} while (0)
+#endif
+
+#if KS_LOG_MIN_LEVEL <= 1
+#define KS_LOG_INFO(message) KS_LOG(LogLevel::INFO, message)
+#else
+#define KS_LOG_INFO(message) do {} while (0)
+#endif
+
+#define KS_LOG_WARNING(message) KS_LOG(LogLevel::WARNING, message)
+#define KS_LOG_ERROR(message) KS_LOG(LogLevel::ERR, message)
+
+#endif // LOGGER_H
@@ -0,0 +1,70 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory mapping of a whole file
+ */
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Maps a file read-only for the lifetime of the object
+ *
+ * Decoding straight from the mapping reads the page cache in place instead
+ * of copying the file through a stream buffer first. Keep the object only
+ * as long as the decode runs so the pages are released right after.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Constructor
+     * @param path File to map
+     */
+    explicit MappedFile(const std::string &path);
+
+    /**
+     * @brief Destructor
+     * Unmaps the file
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    MappedFile(const MappedFile &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Check whether the file is mapped
+     * @return true if data() is usable
+     */
+    bool isValid() const { return data_ != nullptr; }
+
+    /**
+     * @brief Get the mapped bytes
+     * @return Start of the file, or nullptr if not mapped
+     */
+    const void *data() const { return data_; }
+
+    /**
+     * @brief Get the file size
+     * @return Size in bytes
+     */
+    std::size_t size() const { return size_; }
+
+private:
+    const void *data_;
+    std::size_t size_;
+#ifdef _WIN32
+    void *mapping_; // File mapping HANDLE
+#endif
+};
+
+#endif // MAPPEDFILE_H
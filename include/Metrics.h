@@ -0,0 +1,96 @@
+/**
+ * @file Metrics.h
+ * @brief Lock-free counters and histograms for runtime metrics
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class LatencyHistogram
+ * @brief Power-of-two bucketed histogram of durations (microseconds by default)
+ *
+ * record() is a handful of relaxed atomic operations and is safe to call
+ * from any thread, including the hook and audio threads.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t BUCKET_COUNT = 32;
+
+    /**
+     * @brief Constructor
+     * @param name Name used when formatting
+     * @param unit Unit suffix used when formatting (a literal)
+     */
+    explicit LatencyHistogram(const std::string &name, const char *unit = "us");
+
+    /**
+     * @brief Record one sample
+     * @param duration Duration to record
+     */
+    void record(std::chrono::microseconds duration);
+
+    /**
+     * @brief Record one sample already expressed in the histogram unit
+     * @param value Sample value
+     */
+    void recordValue(std::uint64_t value);
+
+    /**
+     * @brief Get the number of recorded samples
+     * @return Sample count
+     */
+    std::uint64_t getCount() const;
+
+    /**
+     * @brief Get an upper bound for a percentile
+     * @param percentile Percentile in the range 0-100
+     * @return Upper edge of the bucket holding the percentile, in the histogram unit
+     */
+    std::uint64_t getPercentile(double percentile) const;
+
+    /**
+     * @brief Get the largest recorded sample
+     * @return Maximum in the histogram unit
+     */
+    std::uint64_t getMax() const;
+
+    /**
+     * @brief Get the histogram name
+     * @return Name
+     */
+    const std::string &getName() const;
+
+    /**
+     * @brief Format a one-line summary (count, mean, p50, p99, max)
+     * @return Summary text
+     */
+    std::string formatSummary() const;
+
+    /**
+     * @brief Format the summary followed by one line per non-empty bucket
+     * @return Histogram text
+     */
+    std::string format() const;
+
+    /**
+     * @brief Clear all samples
+     */
+    void reset();
+
+private:
+    std::string name_;
+    const char *unit_;
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets_;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> sum_;
+    std::atomic<std::uint64_t> max_;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,60 @@
+/**
+ * @file NullAudioBackend.h
+ * @brief Audio backend that renders the mix without an output device
+ */
+#ifndef NULLAUDIOBACKEND_H
+#define NULLAUDIOBACKEND_H
+
+#include "AudioBackend.h"
+#include "SoftwareMixer.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class NullAudioBackend
+ * @brief Renders mixer periods at the real-time rate on its own thread and
+ * optionally writes them to a raw 16-bit stereo PCM file
+ *
+ * Used for headless runs and for exercising the player without a device.
+ */
+class NullAudioBackend : public AudioBackend
+{
+public:
+    NullAudioBackend();
+    ~NullAudioBackend() override;
+
+    bool open(const AudioBackendConfig &config) override;
+    void close() override;
+    void suspend() override;
+    void resume() override;
+    std::shared_ptr<AudioVoice> startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                           std::chrono::steady_clock::time_point onset) override;
+    std::shared_ptr<AudioVoice> startSynthVoice(const ClickParams &params, float volume,
+                                                std::chrono::steady_clock::time_point onset) override;
+    std::shared_ptr<AudioVoice> armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume) override;
+    std::shared_ptr<AudioVoice> armSynthVoice(const ClickParams &params, float volume) override;
+    bool configureEffects(const BusEffectSettings &settings) override;
+    void releaseFinishedVoices() override;
+    std::string getName() const override;
+    std::string describeLatency() const override;
+
+private:
+    /**
+     * @brief Render loop pacing one period per period duration
+     */
+    void renderLoop();
+
+    std::unique_ptr<SoftwareMixer> mixer_;
+    std::ofstream output_;
+    std::thread renderThread_;
+    std::atomic<bool> running_;
+    std::atomic<bool> suspended_;
+    std::mutex stateMutex_;
+    std::condition_variable stateCv_;
+    unsigned int periodFrames_;
+};
+
+#endif // NULLAUDIOBACKEND_H
@@ -0,0 +1,100 @@
+/**
+ * @file PackWatcher.h
+ * @brief Watches the sound pack tree for edits
+ */
+#ifndef PACKWATCHER_H
+#define PACKWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @class PackWatcher
+ * @brief Reports changed paths under a directory tree, debounced
+ *
+ * Uses ReadDirectoryChangesW on Windows and recursive inotify watches
+ * elsewhere. Changes are collected until the tree has been quiet for the
+ * debounce interval and then delivered as one batch, so an editor saving
+ * a file in several steps produces a single callback.
+ */
+class PackWatcher
+{
+public:
+    /**
+     * @brief Change handler
+     *
+     * Receives the changed paths relative to the root, with '/' separators.
+     * Called on the watcher thread.
+     */
+    using Callback = std::function<void(const std::set<std::string> &paths)>;
+
+    /**
+     * @brief Constructor
+     * @param root Directory to watch recursively
+     * @param debounce Quiet time before a batch is delivered
+     * @param callback Change handler
+     */
+    PackWatcher(const std::string &root, std::chrono::milliseconds debounce, Callback callback);
+
+    /**
+     * @brief Destructor
+     * Stops the watcher
+     */
+    ~PackWatcher();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    PackWatcher(const PackWatcher &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    PackWatcher &operator=(const PackWatcher &) = delete;
+
+    /**
+     * @brief Start watching
+     * @return true if successful, false otherwise
+     */
+    bool start();
+
+    /**
+     * @brief Stop watching and join the watcher thread
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Watcher thread main loop
+     */
+    void watch();
+
+    std::string root_;
+    std::chrono::milliseconds debounce_;
+    Callback callback_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+#ifdef _WIN32
+    void *directory_; // Directory HANDLE opened for overlapped I/O
+    void *stopEvent_; // Event HANDLE signalled by stop()
+#else
+    /**
+     * @brief Watch a directory and everything below it
+     * @param relative Directory relative to the root ("" for the root)
+     * @param changes Receives the files found in directories added after start
+     */
+    void addWatches(const std::string &relative, std::set<std::string> *changes);
+
+    int inotifyFd_;
+    int wakeFd_;
+    std::unordered_map<int, std::string> watches_; // Watch descriptor to relative directory
+#endif
+};
+
+#endif // PACKWATCHER_H
@@ -0,0 +1,39 @@
+/**
+ * @file ProcessMemory.h
+ * @brief Resident memory of the running process
+ */
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <cstddef>
+
+/**
+ * @class ProcessMemory
+ * @brief Reads the process working set and its high-water mark
+ */
+class ProcessMemory
+{
+public:
+    /**
+     * @brief Get the current resident set size
+     * @return Bytes, or 0 if unknown
+     */
+    static std::size_t getResidentBytes();
+
+    /**
+     * @brief Get the peak resident set size
+     * @return Bytes, or 0 if unknown
+     */
+    static std::size_t getPeakResidentBytes();
+
+    /**
+     * @brief Reset the peak to the current resident set size
+     *
+     * Supported on Linux only. Elsewhere the peak covers the whole process
+     * lifetime, so an operation only shows up if it sets a new peak.
+     * @return true if the peak was reset
+     */
+    static bool resetPeak();
+};
+
+#endif // PROCESSMEMORY_H
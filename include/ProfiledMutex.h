@@ -0,0 +1,106 @@
+/**
+ * @file ProfiledMutex.h
+ * @brief Mutex wrapper that records contention and hold times
+ */
+#ifndef PROFILEDMUTEX_H
+#define PROFILEDMUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "Metrics.h"
+
+/**
+ * @class ProfiledMutex
+ * @brief Drop-in std::mutex replacement (Lockable) with per-lock statistics
+ *
+ * Every acquisition first tries the lock; only a failed try counts as
+ * contended and is timed into the wait histogram (and traced as a span
+ * named after the lock). Hold times are recorded on every unlock. All
+ * statistics are relaxed atomics and may be read from any thread.
+ */
+class ProfiledMutex
+{
+public:
+    /**
+     * @brief Constructor
+     * @param name Lock name used in reports and traces (a literal)
+     */
+    explicit ProfiledMutex(const char *name);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    ProfiledMutex(const ProfiledMutex &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    /**
+     * @brief Get the lock name
+     * @return Name
+     */
+    const char *getName() const;
+
+    /**
+     * @brief Get the number of acquisitions
+     * @return Acquisition count
+     */
+    std::uint64_t getAcquisitions() const;
+
+    /**
+     * @brief Get the number of acquisitions that had to wait
+     * @return Contended acquisition count
+     */
+    std::uint64_t getContended() const;
+
+    /**
+     * @brief Get the histogram of contended wait times
+     * @return Wait histogram in nanoseconds
+     */
+    const LatencyHistogram &getWaitTime() const;
+
+    /**
+     * @brief Get the histogram of hold times
+     * @return Hold histogram in nanoseconds
+     */
+    const LatencyHistogram &getHoldTime() const;
+
+    /**
+     * @brief Format acquisition counts and wait/hold summaries
+     * @return Summary text, one line per item
+     */
+    std::string formatSummary() const;
+
+    /**
+     * @brief Format the counts followed by the full wait and hold histograms
+     * @return Histogram text
+     */
+    std::string format() const;
+
+private:
+    /**
+     * @brief Bookkeeping once the underlying mutex is held
+     */
+    void acquired();
+
+    std::mutex mutex_;
+    const char *name_;
+    std::atomic<std::uint64_t> acquisitions_{0};
+    std::atomic<std::uint64_t> contended_{0};
+    LatencyHistogram waitTime_; // Contended acquisitions only, nanoseconds
+    LatencyHistogram holdTime_; // Nanoseconds
+
+    // Only touched by the current owner
+    std::chrono::steady_clock::time_point lockedAt_;
+};
+
+#endif // PROFILEDMUTEX_H
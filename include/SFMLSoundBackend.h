@@ -0,0 +1,36 @@
+/**
+ * @file SFMLSoundBackend.h
+ * @brief Audio backend playing each voice through its own sf::Sound
+ */
+#ifndef SFMLSOUNDBACKEND_H
+#define SFMLSOUNDBACKEND_H
+
+#include "AudioBackend.h"
+
+/**
+ * @class SFMLSoundBackend
+ * @brief Default backend: one sf::Sound per voice, mixed by SFML itself
+ *
+ * The device period is managed by SFML and cannot be configured; only
+ * the playback device can be selected.
+ */
+class SFMLSoundBackend : public AudioBackend
+{
+public:
+    bool open(const AudioBackendConfig &config) override;
+    void close() override;
+    std::shared_ptr<AudioVoice> startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                           std::chrono::steady_clock::time_point onset) override;
+    std::shared_ptr<AudioVoice> armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume) override;
+    std::string getName() const override;
+    std::string describeLatency() const override;
+};
+
+/**
+ * @brief Select the SFML playback device
+ * @param device Device name, empty to keep the system default
+ * @return true if the device is in use, false otherwise
+ */
+bool selectSFMLPlaybackDevice(const std::string &device);
+
+#endif // SFMLSOUNDBACKEND_H
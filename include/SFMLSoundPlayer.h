@@ -7,6 +7,7 @@
 
 #include <string>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <memory>
 #include <unordered_map>
@@ -16,6 +17,25 @@
 #include <chrono>
 #include <vector>
 #include <future>
+#include <unordered_set>
+#include <cstdint>
+#include "AudioBackend.h"
+#include "Metrics.h"
+#include "ProfiledMutex.h"
+
+/**
+ * @struct SoundMemoryUsage
+ * @brief Memory held by the player and by the process
+ */
+struct SoundMemoryUsage
+{
+    std::size_t cachedBuffers = 0;     ///< Entries in the buffer cache
+    std::size_t cachedPcmBytes = 0;    ///< Decoded samples held by the cache, each shared buffer once
+    std::size_t dedupSavedBytes = 0;   ///< Decoded samples not held twice thanks to content sharing
+    std::uint64_t dedupHits = 0;       ///< Decodes skipped because identical content was resident
+    std::size_t residentBytes = 0;     ///< Process resident set
+    std::size_t peakResidentBytes = 0; ///< Process resident set high-water mark
+};
 
 /**
  * @class SFMLSoundPlayer
@@ -23,16 +43,34 @@
  *
  * This class provides a thread-safe way to play audio files
  * with volume control and automatic resource cleanup.
- * It uses modern C++ features and SFML for better performance
- * and lower latency than the older MCI system.
+ * Files are decoded with SFML straight from a read-only mapping;
+ * playback goes through a pluggable AudioBackend selected by
+ * configuration.
  */
 class SFMLSoundPlayer
 {
 public:
     /**
      * @brief Constructor
+     * The device is not touched until open(), so construction is cheap
+     * @param config Output backend selection and parameters
+     */
+    explicit SFMLSoundPlayer(const AudioBackendConfig &config = AudioBackendConfig());
+
+    /**
+     * @brief Open the output backend and start the processing thread
+     *
+     * Safe to call from a worker thread. Until it succeeds, playSound()
+     * returns false; preloading already works.
+     * @return true if a backend (possibly the fallback) is open
+     */
+    bool open();
+
+    /**
+     * @brief Check whether open() has succeeded
+     * @return true if open
      */
-    SFMLSoundPlayer();
+    bool isOpen() const;
 
     /**
      * @brief Destructor
@@ -52,11 +90,48 @@ public:
 
     /**
      * @brief Play a sound file
+     *
+     * With a schedule latency configured, mixing backends start the sound
+     * exactly that long after eventTime, so keystrokes keep their spacing.
      * @param filePath Path to the sound file
      * @param highPriority Whether the sound should be played with high priority
+     * @param eventTime When the key event happened; a default time point uses the time of the call
      * @return true if successful, false otherwise
      */
-    bool playSound(const std::string &filePath, bool highPriority = false);
+    bool playSound(const std::string &filePath, bool highPriority = false,
+                   std::chrono::steady_clock::time_point eventTime = {});
+
+    /**
+     * @brief Prepare the key-up sound of a key that was just pressed
+     *
+     * The processing thread resolves the buffer, pinning it, and reserves
+     * a backend voice for it, so the release only has to start that voice.
+     * A newer call for the same key replaces the previous one.
+     * @param keyCode Key being held
+     * @param filePath Key-up sound, chosen now
+     */
+    void armKeyUp(std::uint16_t keyCode, const std::string &filePath);
+
+    /**
+     * @brief Start the key-up sound armed for a key
+     *
+     * Safe to call from the input thread; it takes no queue or cache lock.
+     * @param keyCode Key being released
+     * @param eventTime When the key was released
+     * @return false if nothing is armed for the key yet; play the sound with playSound() then
+     */
+    bool triggerKeyUp(std::uint16_t keyCode, std::chrono::steady_clock::time_point eventTime);
+
+    /**
+     * @brief Give back the voice armed for a key whose release will not be played
+     * @param keyCode Key
+     */
+    void releaseKeyUp(std::uint16_t keyCode);
+
+    /**
+     * @brief Give back every armed voice, e.g. when held keys may never be released to us
+     */
+    void releaseArmedVoices();
 
     /**
      * @brief Preloads a sound into the cache
@@ -66,6 +141,27 @@ public:
      */
     bool preloadSound(const std::string &filePath, bool highPriority = false);
 
+    /**
+     * @brief Preload many sound files at once, synchronously
+     *
+     * All files are read in one batch (io_uring on Linux, a thread pool
+     * elsewhere) and then decoded from memory, instead of opening and
+     * reading each file in turn while decoding.
+     * @param filePaths Paths to the sound files
+     * @return Number of sounds that are cached afterwards
+     */
+    std::size_t preloadSounds(const std::vector<std::string> &filePaths);
+
+    /**
+     * @brief Re-decode a cached sound whose file changed on disk
+     *
+     * Sounds that are not cached are left alone; they decode on first use.
+     * Voices already playing keep the old buffer.
+     * @param filePath Path to the sound file
+     * @return true if a cached buffer was replaced, false otherwise
+     */
+    bool refreshSound(const std::string &filePath);
+
     /**
      * @brief Set the global volume level
      * @param volume Volume level (0-100)
@@ -78,30 +174,158 @@ public:
      */
     int getVolume() const;
 
+    /**
+     * @brief Replace the mix bus effects of the open backend
+     * @param settings New effect settings
+     * @return false if the player is not open, the backend has no mix bus, or an impulse response failed to load
+     */
+    bool setEffects(const BusEffectSettings &settings);
+
     /**
      * @brief Stop all currently playing sounds
      */
     void stopAllSounds();
 
+    /**
+     * @brief Set how long the player waits without sounds before parking
+     * @param timeout Idle timeout (zero disables parking)
+     */
+    void setIdleTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Keep voices and predicted buffers resident while parked
+     * @param keepWarm true to trade idle memory for zero resume cost
+     */
+    void setKeepDeviceWarm(bool keepWarm);
+
+    /**
+     * @brief Check whether the processing loop is currently parked
+     * @return true if parked, false otherwise
+     */
+    bool isIdle() const;
+
+    /**
+     * @brief Get the queue-to-play latency of the first sound after the last resume
+     * @return Wake cost in microseconds
+     */
+    std::chrono::microseconds getLastWakeLatency() const;
+
+    /**
+     * @brief Get the number of times the processing thread has woken up
+     * @return Wakeup count since construction
+     */
+    std::uint64_t getWakeupCount() const;
+
+    /**
+     * @brief Get the number of sounds that were requested but never played
+     * @return Dropped sound count since construction
+     */
+    std::uint64_t getDroppedCount() const;
+
+    /**
+     * @brief Account for the memory held by the sound cache and the process
+     * @return Current usage
+     */
+    SoundMemoryUsage getMemoryUsage() const;
+
+    /**
+     * @brief Format player counters and state for the metrics dump
+     * @return One "key=value" per line
+     */
+    std::string dumpMetrics();
+
+    /**
+     * @brief Format acquisition, contention, wait and hold figures for each player lock
+     * @return One "key=value" per line
+     */
+    std::string dumpLockContention() const;
+
+    /**
+     * @brief Format the player latency histograms
+     * @return Histogram text
+     */
+    std::string dumpLatencyHistograms() const;
+
 private:
+    /**
+     * @brief Decode a mapped sound file, or copy an embedded sound, into a buffer
+     * @param path Sound file path or embedded sound path
+     * @return The buffer, shared with any resident sound of identical content, or nullptr on failure
+     */
+    std::shared_ptr<sf::SoundBuffer> decodeSound(const std::string &path);
+
+    /**
+     * @brief Decode encoded sound bytes, reusing a resident buffer decoded from the same bytes
+     *
+     * A resident buffer is shared only after its source file has been
+     * compared byte for byte, not on the content hash alone.
+     * @param path File the bytes were read from, kept to compare later matches against
+     * @param data Encoded file contents
+     * @param size Size in bytes
+     * @return The buffer, or nullptr on failure
+     */
+    std::shared_ptr<sf::SoundBuffer> decodeSound(const std::string &path, const void *data, std::size_t size);
+
     /**
      * @brief Process function for the sound queue thread
      */
     void processSoundQueue();
+
+    /**
+     * @brief Enter the idle state, releasing resources unless kept warm
+     */
+    void parkPipeline();
     
     /**
      * @brief Clean up finished sounds
      */
     void cleanupFinishedSounds();
 
-    // Thread safety
-    std::mutex soundsMutex_;
-    std::mutex queueMutex_;
-    std::mutex cacheMutex_;
+    /**
+     * @brief Hand a reserved voice to its hold, or release it if the hold is gone
+     * @param keyCode Key the voice was armed for
+     * @param token Hold the request was made for
+     * @param voice Armed voice, or nullptr if none could be reserved
+     * @param path Sound path
+     * @param duration How long to track the voice once triggered
+     */
+    void attachArmedVoice(std::uint16_t keyCode, std::uint64_t token, const std::shared_ptr<AudioVoice> &voice,
+                          const std::string &path, std::chrono::milliseconds duration);
+
+    // Thread safety, profiled so contention shows up in the metrics dump
+    ProfiledMutex soundsMutex_{"sounds_mutex"};
+    ProfiledMutex queueMutex_{"queue_mutex"};
+    mutable ProfiledMutex cacheMutex_{"cache_mutex"};
+    std::condition_variable_any queueCv_;
 
     // Internal state
+    AudioBackendConfig backendConfig_;
     std::atomic<int> volume_;
     std::atomic<bool> running_;
+    std::atomic<bool> opened_;
+
+    // Idle power management
+    std::atomic<bool> idle_;
+    std::atomic<bool> keepDeviceWarm_;
+    bool suspended_ = false; // Backend suspended by the last park (processing thread only)
+    std::atomic<long long> idleTimeoutMs_;
+    std::atomic<long long> lastWakeLatencyUs_;
+    std::atomic<std::uint64_t> wakeupCount_;
+
+    // Metrics
+    std::atomic<std::uint64_t> soundsPlayed_;
+    std::atomic<std::uint64_t> soundsDropped_;
+    std::atomic<std::uint64_t> voicesStolen_;
+    std::atomic<std::uint64_t> armedHits_;   // Key-ups started from an armed voice
+    std::atomic<std::uint64_t> armedMisses_; // Key-ups released before their voice was ready
+    std::atomic<std::uint64_t> cacheHits_;
+    std::atomic<std::uint64_t> cacheMisses_;
+    std::atomic<std::uint64_t> dedupHits_;
+    LatencyHistogram queueLatency_;  // playSound() to voice start
+    LatencyHistogram decodeLatency_; // Synchronous decodes on cache misses
+    
+    // Output backend
+    std::unique_ptr<AudioBackend> backend_;
     
     // Sound processing thread
     std::thread processingThread_;
@@ -112,8 +336,14 @@ private:
     struct PendingSound {
         std::string path;
         bool highPriority;
+        std::chrono::steady_clock::time_point enqueueTime;
+        std::chrono::steady_clock::time_point eventTime;
+        std::uint16_t armKey = 0;   // Key whose key-up voice to arm
+        std::uint64_t armToken = 0; // Hold being armed; 0 for a sound to play now
         
-        PendingSound(const std::string& p, bool hp) : path(p), highPriority(hp) {}
+        PendingSound(const std::string& p, bool hp, std::chrono::steady_clock::time_point et)
+            : path(p), highPriority(hp), enqueueTime(std::chrono::steady_clock::now()),
+              eventTime(et == std::chrono::steady_clock::time_point{} ? enqueueTime : et) {}
     };
     
     // Queue for pending sounds to play
@@ -122,9 +352,26 @@ private:
     // Sound buffers cache
     std::unordered_map<std::string, std::shared_ptr<sf::SoundBuffer>> soundBuffers_;
     
+    // Cache entries brought in by speculative preloads and not yet played (cold tier)
+    std::unordered_set<std::string> predictedPaths_;
+
+    // A resident buffer and the file it was decoded from, to compare candidate duplicates against
+    struct ContentEntry
+    {
+        std::weak_ptr<sf::SoundBuffer> buffer;
+        std::string sourcePath;
+    };
+
+    // Resident buffers by hash of their source bytes, so paths with identical content share one
+    // buffer across categories and packs (guarded by cacheMutex_)
+    std::unordered_map<std::uint64_t, ContentEntry> buffersByContent_;
+
+    // Keystrokes played from the synthesized pack, varies each click (processing thread only)
+    std::uint32_t synthKeystrokes_ = 0;
+    
     // Currently playing sounds
     struct SoundInstance {
-        std::shared_ptr<sf::Sound> sound;
+        std::shared_ptr<AudioVoice> voice;
         std::chrono::steady_clock::time_point expirationTime;
         std::string path;
         bool highPriority;
@@ -132,13 +379,27 @@ private:
     
     std::vector<SoundInstance> activeSounds_;
     
+    // Key-up voices reserved while their key is held; voice stays null until the processing thread has armed it
+    struct ArmedVoice {
+        std::uint64_t token = 0;
+        std::shared_ptr<AudioVoice> voice;
+        std::string path;
+        std::chrono::milliseconds duration{0};
+    };
+    
+    ProfiledMutex armMutex_{"arm_mutex"};
+    std::unordered_map<std::uint16_t, ArmedVoice> armedVoices_;
+    std::uint64_t nextArmToken_ = 0;
+    
     // Store futures from preload operations to prevent warning about discarding them
     std::vector<std::future<void>> preloadFutures_;
     
     // Constants
     static constexpr int MAX_CONCURRENT_SOUNDS = 32; // SFML can handle more concurrent sounds
     static constexpr int MAX_CACHE_SIZE = 100;       // More generous cache size
+    static constexpr std::size_t MAX_ARMED_VOICES = 16; // Held keys with a reserved key-up voice
     static constexpr auto CLEANUP_INTERVAL = std::chrono::seconds(1);
+    static constexpr auto DEFAULT_IDLE_TIMEOUT = std::chrono::seconds(30);
 };
 
 #endif // SFMLSOUNDPLAYER_H 
\ No newline at end of file
@@ -0,0 +1,62 @@
+/**
+ * @file SFMLStreamBackend.h
+ * @brief Audio backend mixing all voices into a single SFML sound stream
+ */
+#ifndef SFMLSTREAMBACKEND_H
+#define SFMLSTREAMBACKEND_H
+
+#include "AudioBackend.h"
+#include "SoftwareMixer.h"
+#include <vector>
+
+/**
+ * @class SFMLStreamBackend
+ * @brief Low-latency backend: voices are summed by SoftwareMixer and fed to
+ * one sf::SoundStream in periods of a configurable size
+ */
+class SFMLStreamBackend : public AudioBackend
+{
+public:
+    SFMLStreamBackend();
+    ~SFMLStreamBackend() override;
+
+    bool open(const AudioBackendConfig &config) override;
+    void close() override;
+    void suspend() override;
+    void resume() override;
+    std::shared_ptr<AudioVoice> startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                           std::chrono::steady_clock::time_point onset) override;
+    std::shared_ptr<AudioVoice> startSynthVoice(const ClickParams &params, float volume,
+                                                std::chrono::steady_clock::time_point onset) override;
+    std::shared_ptr<AudioVoice> armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume) override;
+    std::shared_ptr<AudioVoice> armSynthVoice(const ClickParams &params, float volume) override;
+    bool configureEffects(const BusEffectSettings &settings) override;
+    void releaseFinishedVoices() override;
+    std::string getName() const override;
+    std::string describeLatency() const override;
+
+private:
+    /**
+     * @class MixerStream
+     * @brief sf::SoundStream pulling one mixer period per request
+     */
+    class MixerStream : public sf::SoundStream
+    {
+    public:
+        MixerStream(SoftwareMixer &mixer, unsigned int periodFrames);
+
+    protected:
+        bool onGetData(Chunk &data) override;
+        void onSeek(sf::Time timeOffset) override;
+
+    private:
+        SoftwareMixer &mixer_;
+        std::vector<std::int16_t> period_;
+    };
+
+    std::unique_ptr<SoftwareMixer> mixer_;
+    std::unique_ptr<MixerStream> stream_;
+    unsigned int periodFrames_;
+};
+
+#endif // SFMLSTREAMBACKEND_H
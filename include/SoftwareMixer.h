@@ -0,0 +1,293 @@
+/**
+ * @file SoftwareMixer.h
+ * @brief Fixed-voice software mixer shared by the streaming and null backends
+ */
+#ifndef SOFTWAREMIXER_H
+#define SOFTWAREMIXER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <SFML/Audio.hpp>
+#include "AudioBackend.h"
+#include "BusEffects.h"
+#include "ClickSynth.h"
+
+/**
+ * @class SoftwareMixer
+ * @brief Sums voices into an interleaved stereo 16-bit output
+ *
+ * Voices are started from the player thread and rendered from the device
+ * thread. Each slot is handed over through an atomic state, so render()
+ * never locks or allocates. The summed voices pass through the bus
+ * effect chain once per period.
+ *
+ * A voice given an onset time starts at the matching sample rather than
+ * at the start of the next period. render() keeps a frame clock for this:
+ * the time of each period is predicted from the frames rendered so far
+ * and pulled gently towards the time render() is actually called, so the
+ * device thread's wakeup jitter does not reach the onsets.
+ */
+class SoftwareMixer
+{
+public:
+    static constexpr unsigned int CHANNELS = 2;
+    static constexpr std::size_t MAX_VOICES = 64;
+    static constexpr std::size_t MAX_PERIOD_FRAMES = 4096;
+
+    /**
+     * @brief Constructor
+     * @param sampleRate Output sample rate
+     */
+    explicit SoftwareMixer(unsigned int sampleRate);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    SoftwareMixer(const SoftwareMixer &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    SoftwareMixer &operator=(const SoftwareMixer &) = delete;
+
+    /**
+     * @brief Start a voice
+     * @param buffer Decoded sound buffer
+     * @param volume Volume level (0-100)
+     * @param onset Time the first sample should play; a default time point starts at the next period
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    std::int64_t startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                            std::chrono::steady_clock::time_point onset = {});
+
+    /**
+     * @brief Start a synthesized click rendered directly into the mix
+     * @param params Keystroke parameters
+     * @param volume Volume level (0-100)
+     * @param onset Time the click should start, as for startVoice()
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    std::int64_t startSynthVoice(const ClickParams &params, float volume,
+                                 std::chrono::steady_clock::time_point onset = {});
+
+    /**
+     * @brief Reserve a voice slot for a buffer without starting it
+     *
+     * The slot is set up and the first period of samples is read in, so
+     * triggerVoice() only has to flip its state. The caller owns the armed
+     * voice: it must trigger or stop it, from one thread at a time.
+     * @param buffer Decoded sound buffer
+     * @param volume Volume level (0-100)
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    std::int64_t armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume);
+
+    /**
+     * @brief Reserve a voice slot for a synthesized click without starting it
+     * @param params Keystroke parameters
+     * @param volume Volume level (0-100)
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    std::int64_t armSynthVoice(const ClickParams &params, float volume);
+
+    /**
+     * @brief Start an armed voice
+     * @param handle Handle returned by armVoice() or armSynthVoice()
+     * @param onset Time the first sample should play, as for startVoice()
+     * @return false if the handle is not an armed voice
+     */
+    bool triggerVoice(std::int64_t handle, std::chrono::steady_clock::time_point onset);
+
+    /**
+     * @brief Request a voice to stop at the next period; an armed voice is released at once
+     * @param handle Handle returned by startVoice() or armVoice()
+     */
+    void stopVoice(std::int64_t handle);
+
+    /**
+     * @brief Stop every playing voice at the next period and release every armed one
+     *
+     * Handles of released armed voices no longer trigger.
+     */
+    void stopAllVoices();
+
+    /**
+     * @brief Drop the buffer references kept by free slots
+     *
+     * A finished voice keeps its buffer until the slot is reused, which for
+     * the high slots of a burst may be never. Call from the starting side,
+     * never from the device thread.
+     */
+    void releaseFinishedVoices();
+
+    /**
+     * @brief Check whether a voice is still playing
+     * @param handle Handle returned by startVoice()
+     * @return true if playing, false otherwise
+     */
+    bool isVoicePlaying(std::int64_t handle) const;
+
+    /**
+     * @brief Change the volume of a playing voice
+     * @param handle Handle returned by startVoice()
+     * @param volume Volume level (0-100)
+     */
+    void setVoiceVolume(std::int64_t handle, float volume);
+
+    /**
+     * @brief Replace the mix bus effects; takes effect at the next period
+     * @param settings New effect settings
+     * @return false if the impulse response file could not be loaded
+     */
+    bool configureEffects(const BusEffectSettings &settings);
+
+    /**
+     * @brief Render the next block of output (device thread)
+     * @param out Interleaved stereo output, frames * CHANNELS samples
+     * @param frames Number of frames to render
+     */
+    void render(std::int16_t *out, std::size_t frames);
+
+    /**
+     * @brief Get the output sample rate
+     * @return Sample rate in Hz
+     */
+    unsigned int getSampleRate() const;
+
+    /**
+     * @brief Get the number of voices whose onset had already passed when they were mixed
+     * @return Late onset count since construction
+     */
+    std::uint64_t getLateOnsetCount() const;
+
+private:
+    /**
+     * @brief Mix all playing voices into the float accumulator
+     * @param frames Number of frames (at most MAX_PERIOD_FRAMES)
+     * @param startNs Frame clock time of the first frame, in steady clock nanoseconds
+     * @return Number of voices that contributed
+     */
+    std::uint32_t mixVoices(std::size_t frames, double startNs);
+
+    struct Voice;
+
+    /**
+     * @brief Claim a free slot and hand it to the device thread
+     * @param volume Volume level (0-100)
+     * @param onset Requested start time, or a default time point
+     * @param state VOICE_PLAYING to start at once, VOICE_ARMED to wait for triggerVoice()
+     * @param setup Fills in the source fields of the claimed slot
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    enum VoiceState : int
+    {
+        VOICE_FREE = 0,
+        VOICE_PLAYING = 1,
+        VOICE_ARMED = 2,      // Set up but not started; the device thread skips it
+        VOICE_TRIGGERING = 3, // Armed voice whose owner is writing the onset; the device thread skips it
+        VOICE_STOPPING = 4,   // Freed by the device thread at its next period
+        VOICE_CANCELLED = 5   // Stopped while triggering; freed by triggerVoice(), skipped by the device thread
+    };
+
+    /**
+     * @brief Move a voice towards free: an armed one at once, a playing one at the next period
+     * @param voice Voice slot
+     * @param generation Generation the voice must still have
+     * @param anyGeneration Release whatever voice holds the slot
+     * @return true if the voice was released or marked for stopping
+     */
+    bool releaseVoice(Voice &voice, std::uint32_t generation, bool anyGeneration);
+
+    /**
+     * @brief Reset the buffers of free slots; startMutex_ must be held
+     */
+    void releaseFreeBuffers();
+
+    template <typename Setup>
+    std::int64_t claimVoice(float volume, std::chrono::steady_clock::time_point onset, VoiceState state, Setup setup);
+
+    /**
+     * @brief Claim a slot playing a decoded buffer
+     * @return Voice handle, or -1 if the buffer is empty or all slots are busy
+     */
+    std::int64_t claimBufferVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                  std::chrono::steady_clock::time_point onset, VoiceState state);
+
+    /**
+     * @brief Claim a slot playing a synthesized click
+     * @return Voice handle, or -1 if all slots are busy
+     */
+    std::int64_t claimSynthVoice(const ClickParams &params, float volume, std::chrono::steady_clock::time_point onset,
+                                 VoiceState state);
+
+    struct Voice
+    {
+        // Generation (high half) and VoiceState (low half), changed together so a stale handle
+        // can never act on a later voice in the same slot
+        std::atomic<std::uint64_t> control{0};
+        std::atomic<float> gain{0.0f};
+
+        // Owned by the starting thread; only touched while the slot is free, under startMutex_
+        std::shared_ptr<sf::SoundBuffer> buffer;
+
+        // Read by the device thread while the slot is playing; a pending onset is cleared once reached
+        std::int64_t onsetNs = 0;
+        bool synth = false;
+        ClickVoice click;
+        const std::int16_t *samples = nullptr;
+        std::uint64_t frameCount = 0;
+        unsigned int channels = 1;
+        double step = 1.0;
+        double position = 0.0;
+    };
+
+    unsigned int sampleRate_;
+    std::array<Voice, MAX_VOICES> voices_;
+    std::vector<float> mixBuffer_;
+    BusEffectChain effects_;
+
+    // Frame clock, owned by the device thread: predicted time of the next frame to render
+    double clockNs_;
+    bool clockValid_;
+    std::atomic<std::uint64_t> lateOnsets_;
+
+    // Serializes voice starts; the device thread never takes it
+    std::mutex startMutex_;
+
+    // Frames read in when arming a voice, one sample per cache line; the sum only keeps the reads alive
+    static constexpr std::uint64_t PRIME_FRAMES = 1024;
+    static constexpr std::size_t PRIME_STRIDE = 32;
+    std::uint32_t primeSink_ = 0;
+};
+
+/**
+ * @class MixerVoice
+ * @brief AudioVoice handle for a voice playing in a SoftwareMixer
+ */
+class MixerVoice : public AudioVoice
+{
+public:
+    /**
+     * @brief Constructor
+     * @param mixer Mixer the voice belongs to
+     * @param handle Handle returned by SoftwareMixer::startVoice()
+     */
+    MixerVoice(SoftwareMixer &mixer, std::int64_t handle)
+        : mixer_(mixer), handle_(handle) {}
+
+    void stop() override { mixer_.stopVoice(handle_); }
+    bool isPlaying() const override { return mixer_.isVoicePlaying(handle_); }
+    void setVolume(float volume) override { mixer_.setVoiceVolume(handle_, volume); }
+    bool trigger(std::chrono::steady_clock::time_point onset) override { return mixer_.triggerVoice(handle_, onset); }
+
+private:
+    SoftwareMixer &mixer_;
+    std::int64_t handle_;
+};
+
+#endif // SOFTWAREMIXER_H
@@ -5,11 +5,12 @@
 #ifndef SOUNDMANAGER_H
 #define SOUNDMANAGER_H
 
-#include <windows.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 
 /**
  * @struct SoundCategory
@@ -34,9 +35,22 @@ enum class KeyType
     OTHER  ///< Any other key
 };
 
+/**
+ * @struct SoundPack
+ * @brief Immutable snapshot of a loaded sound pack
+ */
+struct SoundPack
+{
+    std::string folderPath;                               ///< Pack folder
+    std::unordered_map<KeyType, SoundCategory> categories; ///< Sounds per key type
+};
+
 /**
  * @class SoundManager
  * @brief Manages loading and retrieving sound files for keyboard events
+ *
+ * The current pack is an immutable snapshot swapped atomically, so a pack
+ * can be loaded on any thread while key events keep reading the old one.
  */
 class SoundManager
 {
@@ -58,13 +72,28 @@ public:
      */
     bool loadSounds();
 
+    /**
+     * @brief Scan a pack folder and make it current if it holds sounds
+     * @param folder Path to the pack folder
+     * @return true if the pack was switched, false if the old pack is kept
+     */
+    bool switchPack(const std::string &folder);
+
+    /**
+     * @brief Re-list some categories of the current pack and publish the result
+     * @param folder Pack folder the changes belong to; ignored unless it is current
+     * @param categoryNames Category folder names to re-list ("alpha", "space", ...)
+     * @return true if a new snapshot was published, false otherwise
+     */
+    bool refreshCategories(const std::string &folder, const std::vector<std::string> &categoryNames);
+
     /**
      * @brief Get a random sound file for a specific key event
      * @param vkCode Virtual key code of the key
      * @param keyDown true for key down event, false for key up
      * @return Path to the sound file or empty string if none found
      */
-    std::string getRandomSoundForKey(WORD vkCode, bool keyDown) const;
+    std::string getRandomSoundForKey(std::uint16_t vkCode, bool keyDown) const;
 
     /**
      * @brief Set a new folder path for sounds
@@ -76,36 +105,68 @@ public:
      * @brief Get the current folder path
      * @return Current folder path
      */
-    const std::string &getFolderPath() const;
+    std::string getFolderPath() const;
+
+    /**
+     * @brief Get the pack snapshot currently in use
+     * @return Current pack, or nullptr if none is loaded
+     */
+    std::shared_ptr<const SoundPack> getCurrentPack() const;
+
+    /**
+     * @brief Scan a pack folder without making it current
+     * @param folder Path to the pack folder
+     * @return The scanned pack, or nullptr if it holds no sounds
+     */
+    static std::shared_ptr<SoundPack> scanPack(const std::string &folder);
 
     /**
      * @brief Add a custom key mapping
      * @param vkCode Virtual key code to map
      * @param type Key type to associate with this key
      */
-    void addKeyMapping(WORD vkCode, KeyType type);
+    void addKeyMapping(std::uint16_t vkCode, KeyType type);
 
 private:
     /**
      * @brief Load sounds for a specific category
+     * @param folder Path to the pack folder
      * @param categoryName Name of the category folder
      * @param cat SoundCategory to populate
      * @return true if successful, false otherwise
      */
-    bool loadSoundCategory(const std::string &categoryName, SoundCategory &cat);
+    static bool loadSoundCategory(const std::string &folder, const std::string &categoryName, SoundCategory &cat);
+
+    /**
+     * @brief Load sounds for a specific category from the embedded pack
+     * @param categoryName Name of the category
+     * @param cat SoundCategory to populate
+     * @return true if successful, false otherwise
+     */
+    static bool loadEmbeddedCategory(const std::string &categoryName, SoundCategory &cat);
+
+    /**
+     * @brief List the synthesized sounds of a category
+     * @param categoryName Name of the category
+     * @param cat SoundCategory to populate
+     * @return true (every category is synthesized)
+     */
+    static bool loadSynthCategory(const std::string &categoryName, SoundCategory &cat);
 
     /**
      * @brief Get the key type for a given virtual key code
      * @param vkCode Virtual key code
      * @return KeyType for the given key
      */
-    KeyType getKeyTypeForVkCode(WORD vkCode) const;
+    KeyType getKeyTypeForVkCode(std::uint16_t vkCode) const;
 
     // Data members
     std::string folderPath_;
+    mutable std::mutex folderMutex_;
 
-    std::unordered_map<KeyType, SoundCategory> categories_;
-    std::unordered_map<WORD, KeyType> keyMappings_;
+    // Current pack; read and replaced with std::atomic_load/std::atomic_store
+    std::shared_ptr<const SoundPack> pack_;
+    std::unordered_map<std::uint16_t, KeyType> keyMappings_;
 };
 
 #endif // SOUNDMANAGER_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+/**
+ * @file StartupOrchestrator.h
+ * @brief Runs startup steps as a dependency graph
+ */
+#ifndef STARTUPORCHESTRATOR_H
+#define STARTUPORCHESTRATOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class StartupOrchestrator
+ * @brief Executes named tasks as soon as their dependencies have finished
+ *
+ * Worker tasks run concurrently on background threads. Caller tasks run
+ * on the thread that calls run(), which matters for anything bound to
+ * the UI thread (windows, the low-level keyboard hook). While waiting,
+ * run() keeps calling a pump function so that thread stays responsive.
+ * A task that fails skips everything that depends on it.
+ */
+class StartupOrchestrator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = std::function<bool()>;
+
+    enum class Affinity
+    {
+        WORKER, ///< Runs on a background thread
+        CALLER  ///< Runs on the thread that calls run()
+    };
+
+    enum class State
+    {
+        PENDING,
+        RUNNING,
+        DONE,
+        FAILED,
+        SKIPPED
+    };
+
+    /**
+     * @brief Constructor
+     * @param origin Time the measured startup began
+     */
+    explicit StartupOrchestrator(Clock::time_point origin = Clock::now());
+
+    /**
+     * @brief Add a task; dependencies must have been added before
+     * @param name Unique task name
+     * @param dependencies Tasks that must finish successfully first
+     * @param affinity Where the task runs
+     * @param task Task body, returning false on failure
+     */
+    void addTask(const std::string &name, const std::vector<std::string> &dependencies,
+                 Affinity affinity, Task task);
+
+    /**
+     * @brief Run every task to completion
+     * @param pump Called on the caller thread while waiting for workers
+     * @param pumpInterval Longest wait between two pump calls
+     * @return true if every task succeeded, false otherwise
+     */
+    bool run(const std::function<void()> &pump = nullptr,
+             std::chrono::milliseconds pumpInterval = std::chrono::milliseconds(10));
+
+    /**
+     * @brief Get the final state of a task
+     * @param name Task name
+     * @return Task state (PENDING for an unknown name)
+     */
+    State getState(const std::string &name) const;
+
+    /**
+     * @brief Get when a task finished, relative to the origin
+     * @param name Task name
+     * @return Offset of the task's completion, or zero if it did not finish
+     */
+    std::chrono::microseconds getFinishOffset(const std::string &name) const;
+
+    /**
+     * @brief Format "startup_<task>_done_ms" and "startup_<task>_took_ms" lines per finished task
+     * @return Report text
+     */
+    std::string formatReport() const;
+
+private:
+    struct Node
+    {
+        std::string name;
+        std::vector<std::size_t> dependencies;
+        Affinity affinity;
+        Task task;
+        State state = State::PENDING;
+        Clock::time_point started;
+        Clock::time_point finished;
+    };
+
+    /**
+     * @brief Mark ready tasks as running or skipped (lock held)
+     * @param callerTasks Receives ready caller tasks to run on this thread
+     * @param workerTasks Receives ready worker tasks to launch
+     * @return Number of tasks that changed state
+     */
+    std::size_t schedule(std::vector<std::size_t> &callerTasks, std::vector<std::size_t> &workerTasks);
+
+    /**
+     * @brief Record the result of a task and wake run()
+     * @param index Task index
+     * @param succeeded Task result
+     */
+    void finish(std::size_t index, bool succeeded);
+
+    Clock::time_point origin_;
+    std::vector<Node> nodes_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+};
+
+#endif // STARTUPORCHESTRATOR_H
@@ -0,0 +1,146 @@
+/**
+ * @file StreamInputSource.h
+ * @brief Input source reading programmatic key events from a stream
+ */
+#ifndef STREAMINPUTSOURCE_H
+#define STREAMINPUTSOURCE_H
+
+#include "InputSource.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * @class StreamInputSource
+ * @brief Reads key events from stdin, a named pipe or a Unix socket
+ *
+ * Endpoints:
+ * - "stdin"
+ * - "pipe:<path>" (a FIFO on POSIX, \\.\pipe\<path> on Windows)
+ * - "unix:<path>" (POSIX only; one client at a time)
+ *
+ * Text format, one event per line: "d <vk>" or "u <vk>", the key code in
+ * decimal or 0x-prefixed hex. Binary format: 16-bit little-endian records,
+ * bits 0-14 the key code and bit 15 set for key down. Both formats take
+ * key codes 1-255 and skip anything else.
+ *
+ * Reads are batched and every decoded event is dispatched directly on the
+ * reader thread. Events are not marked injected.
+ */
+class StreamInputSource : public InputSource
+{
+public:
+    enum class Format
+    {
+        TEXT,
+        BINARY
+    };
+
+    /**
+     * @brief Constructor
+     * @param endpoint Endpoint specification (see class description)
+     * @param format Wire format
+     */
+    StreamInputSource(const std::string &endpoint, Format format);
+
+    /**
+     * @brief Destructor
+     * Stops the reader thread
+     */
+    ~StreamInputSource() override;
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    StreamInputSource(const StreamInputSource &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    StreamInputSource &operator=(const StreamInputSource &) = delete;
+
+    bool start(EventCallback callback) override;
+    void stop() override;
+    std::string getName() const override;
+
+    /**
+     * @brief Get the number of events dispatched so far
+     * @return Event count
+     */
+    std::uint64_t getEventCount() const;
+
+    /**
+     * @brief Get the number of read batches so far
+     * @return Batch count
+     */
+    std::uint64_t getBatchCount() const;
+
+    /**
+     * @brief Parse a format name from configuration
+     * @param name "text" or "binary"
+     * @param format Parsed format
+     * @return true if the name is valid, false otherwise
+     */
+    static bool parseFormat(const std::string &name, Format &format);
+
+private:
+    /**
+     * @brief Reader thread: open the endpoint and read until stopped
+     */
+    void readLoop();
+
+    /**
+     * @brief Decode a batch of bytes and dispatch the events
+     * @param data Bytes read from the endpoint
+     * @param size Number of bytes
+     */
+    void consume(const char *data, std::size_t size);
+
+    /**
+     * @brief Decode one binary record
+     * @param record Little-endian word as read
+     * @param timestamp Batch arrival time
+     */
+    void consumeRecord(std::uint16_t record, std::chrono::steady_clock::time_point timestamp);
+
+    /**
+     * @brief Decode one text line
+     * @param line Line without terminator
+     * @param length Line length
+     * @param timestamp Batch arrival time
+     */
+    void consumeLine(const char *line, std::size_t length, std::chrono::steady_clock::time_point timestamp);
+
+    std::string endpoint_;
+    Format format_;
+    EventCallback callback_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    std::atomic<std::uint64_t> eventCount_;
+    std::atomic<std::uint64_t> batchCount_;
+
+    // Bytes of an incomplete line or record carried into the next batch
+    std::string carry_;
+
+#ifdef _WIN32
+    /**
+     * @brief Open the endpoint and read until stopped or closed (reader thread)
+     */
+    void readEndpoint();
+
+    /**
+     * @brief Close the reader thread handle once the reader has finished
+     */
+    void closeReaderThread();
+
+    std::atomic<void *> readerThread_; // Reader thread HANDLE, target of CancelSynchronousIo
+    std::atomic<bool> readerDone_;     // Set by the reader as its last step
+#else
+    int wakeFd_;   // Signalled by stop() to break out of poll()
+#endif
+};
+
+#endif // STREAMINPUTSOURCE_H
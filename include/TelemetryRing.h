@@ -0,0 +1,146 @@
+/**
+ * @file TelemetryRing.h
+ * @brief Lock-free telemetry ring in a named shared-memory segment
+ */
+#ifndef TELEMETRYRING_H
+#define TELEMETRYRING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @enum TelemetryType
+ * @brief Kind of record written to the ring
+ */
+enum class TelemetryType : std::uint32_t
+{
+    KEY_EVENT = 1,   ///< code = key code, flags = 1 for down
+    VOICE_LEVEL = 2, ///< code = active voices, value = peak of the last period (0-1)
+    LATENCY = 3      ///< code = latency source, value = microseconds
+};
+
+/**
+ * @struct TelemetryEvent
+ * @brief A record as seen by readers
+ */
+struct TelemetryEvent
+{
+    std::uint64_t sequence;    ///< Monotonic record index
+    std::uint64_t timestampNs; ///< steady_clock time in nanoseconds
+    TelemetryType type;
+    std::uint32_t code;
+    std::uint32_t flags;
+    float value;
+};
+
+/**
+ * @class TelemetryRing
+ * @brief Fixed-size ring of seqlock-protected records in shared memory
+ *
+ * Writers claim a slot with one fetch_add and publish it with a per-slot
+ * sequence number, so writing is wait-free and never blocks on readers.
+ * Any number of readers, in this or other processes, poll with their own
+ * cursor and detect torn or overwritten slots through the sequence.
+ */
+class TelemetryRing
+{
+public:
+    static constexpr std::uint32_t CAPACITY = 4096; // Power of two
+    static constexpr const char *DEFAULT_NAME = "keyboard-sounds-telemetry";
+
+    /**
+     * @brief Destructor
+     * Unmaps the segment (and removes it if this process created it)
+     */
+    ~TelemetryRing();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    TelemetryRing(const TelemetryRing &) = delete;
+
+    /**
+     * @brief Deleted assignment operator
+     */
+    TelemetryRing &operator=(const TelemetryRing &) = delete;
+
+    /**
+     * @brief Create (or reset) the named segment for writing
+     * @param name Segment name
+     * @return The ring, or nullptr on failure
+     */
+    static std::unique_ptr<TelemetryRing> create(const std::string &name);
+
+    /**
+     * @brief Map an existing segment for reading
+     * @param name Segment name
+     * @return The ring, or nullptr if it does not exist
+     */
+    static std::unique_ptr<TelemetryRing> open(const std::string &name);
+
+    /**
+     * @brief Append a record (wait-free, any thread)
+     * @param type Record type
+     * @param code Type-specific code
+     * @param value Type-specific value
+     * @param flags Type-specific flags
+     */
+    void write(TelemetryType type, std::uint32_t code, float value, std::uint32_t flags = 0);
+
+    /**
+     * @brief Read records after a cursor
+     * @param cursor Next sequence to read; advanced past returned and lost records
+     * @param out Output array
+     * @param maxEvents Capacity of out
+     * @param lost Incremented by the number of records overwritten before they were read
+     * @return Number of records written to out
+     */
+    std::size_t read(std::uint64_t &cursor, TelemetryEvent *out, std::size_t maxEvents, std::uint64_t &lost) const;
+
+    /**
+     * @brief Get the sequence the next write will use
+     * @return Write position
+     */
+    std::uint64_t getWritePosition() const;
+
+    /**
+     * @brief Install the process-wide writer used by publish()
+     * @param ring Ring to publish to, or nullptr to disable telemetry
+     */
+    static void setGlobal(TelemetryRing *ring);
+
+    /**
+     * @brief Write to the process-wide ring if telemetry is enabled
+     *
+     * Costs one atomic load and a branch when disabled.
+     */
+    static void publish(TelemetryType type, std::uint32_t code, float value, std::uint32_t flags = 0)
+    {
+        TelemetryRing *ring = global_.load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            ring->write(type, code, value, flags);
+        }
+    }
+
+private:
+    struct Slot;
+    struct Header;
+
+    TelemetryRing(void *mapping, std::size_t size, const std::string &name, bool owner, void *handle);
+
+    void *mapping_;
+    std::size_t size_;
+    std::string name_;
+    bool owner_;
+    void *handle_; // File mapping HANDLE on Windows
+
+    Header *header_;
+    Slot *slots_;
+
+    static std::atomic<TelemetryRing *> global_;
+};
+
+#endif // TELEMETRYRING_H
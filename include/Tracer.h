@@ -0,0 +1,166 @@
+/**
+ * @file Tracer.h
+ * @brief Opt-in span tracer exporting Chrome/Perfetto trace-event JSON
+ */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @class Tracer
+ * @brief Process-wide recorder of timed spans
+ *
+ * While disabled, a span costs one relaxed load and a branch. While
+ * enabled, each thread appends to its own single-producer ring, allocated
+ * on the thread's first span, so recording never takes a lock. stop()
+ * writes everything recorded since start() as a trace-event file that
+ * chrome://tracing and ui.perfetto.dev open directly.
+ */
+class Tracer
+{
+public:
+    static constexpr std::size_t THREAD_CAPACITY = 16384; // Spans per thread, power of two
+    static constexpr std::size_t MAX_THREAD_NAME = 32;
+
+    /**
+     * @brief Check whether spans are being recorded
+     * @return true if enabled
+     */
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Discard old spans and start recording
+     */
+    static void start();
+
+    /**
+     * @brief Stop recording and write the trace
+     * @param path Output file
+     * @return true if the file was written, false otherwise
+     */
+    static bool stop(const std::string &path);
+
+    /**
+     * @brief Name the calling thread in the exported trace
+     *
+     * Call before the thread records its first span.
+     * @param name Thread name (truncated to MAX_THREAD_NAME - 1)
+     */
+    static void setThreadName(const char *name);
+
+    /**
+     * @brief Record one completed span from the calling thread
+     * @param name Span name (must outlive the tracer, e.g. a literal)
+     * @param argName Argument name (literal), or nullptr for none
+     * @param argValue Argument value
+     * @param begin Span start
+     * @param end Span end
+     */
+    static void record(const char *name, const char *argName, std::int64_t argValue,
+                       std::chrono::steady_clock::time_point begin,
+                       std::chrono::steady_clock::time_point end);
+
+    /**
+     * @brief Get the number of spans dropped because a thread ring was full
+     * @return Dropped span count
+     */
+    static std::uint64_t getDroppedCount();
+
+private:
+    struct Span
+    {
+        const char *name;
+        const char *argName;
+        std::int64_t argValue;
+        std::int64_t beginNs;
+        std::int64_t durationNs;
+    };
+
+    /**
+     * @brief Single-producer ring owned by one recording thread
+     */
+    struct ThreadBuffer
+    {
+        std::array<Span, THREAD_CAPACITY> spans;
+        std::atomic<std::uint64_t> head{0}; // Written by the owning thread
+        std::atomic<std::uint64_t> tail{0}; // Written by start()/stop()
+        std::atomic<bool> retired{false};   // Owning thread has exited
+        std::uint32_t threadId = 0;
+        char threadName[MAX_THREAD_NAME] = {};
+    };
+
+    friend struct TraceThreadState;
+
+    /**
+     * @brief Get (registering on first use) the calling thread's ring
+     * @return The ring
+     */
+    static ThreadBuffer &threadBuffer();
+
+    /**
+     * @brief Forget rings of exited threads once their spans are consumed (registry lock held)
+     */
+    static void pruneRetired();
+
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::atomic<std::uint64_t> dropped_{0};
+    static inline std::atomic<std::uint32_t> nextThreadId_{1};
+
+    // Taken on a thread's first span and by start()/stop(), never per span
+    static inline std::mutex registryMutex_;
+    static inline std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records the lifetime of a scope as a span
+ */
+class TraceSpan
+{
+public:
+    /**
+     * @brief Begin a span
+     * @param name Span name (literal)
+     * @param argName Optional argument name (literal)
+     * @param argValue Argument value
+     */
+    explicit TraceSpan(const char *name, const char *argName = nullptr, std::int64_t argValue = 0)
+        : name_(Tracer::isEnabled() ? name : nullptr), argName_(argName), argValue_(argValue)
+    {
+        if (name_) {
+            begin_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (name_) {
+            Tracer::record(name_, argName_, argValue_, begin_, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    /**
+     * @brief Replace the argument value once it is known
+     * @param argValue Argument value
+     */
+    void setArg(std::int64_t argValue) { argValue_ = argValue; }
+
+private:
+    const char *name_;
+    const char *argName_;
+    std::int64_t argValue_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+#endif // TRACER_H
@@ -3,16 +3,20 @@
  * @brief Implementation of the Application class
  */
 #include "Application.h"
+#include "Logger.h"
+#include "ProcessMemory.h"
+#include "Tracer.h"
 #include "Utils.h"
+#include "StartupOrchestrator.h"
 #include <windows.h>
 #include <filesystem>
 #include <vector>
 #include <string>
-#include <iostream>
 #include <commctrl.h>
+#include <shellapi.h>
 #include <limits>
 #include <uxtheme.h>
-#include <stdexcept>
+#include <algorithm>
 
 // Global volume variable (0–100)
 int g_volume = 50;
@@ -33,16 +37,22 @@ const int LABEL_WIDTH = 130;
 const int CONTROL_WIDTH = WINDOW_WIDTH - (2 * MARGIN) - LABEL_WIDTH - 20;
 const int SPACING = 20;
 
-Application::Application(const std::string &soundFolder)
-    : soundFolder_(soundFolder),
-      soundManager_(std::make_unique<SoundManager>(soundFolder)),
-      soundPlayer_(std::make_unique<SFMLSoundPlayer>()),
+Application::Application(const std::string &soundFolder, const AppConfig &config)
+    : startTime_(std::chrono::steady_clock::now()),
+      engine_(std::make_unique<Engine>(soundFolder, config, startTime_)),
+      trayMode_(config.trayMode || config.startHidden),
+      startHidden_(config.startHidden),
+      trayHwnd_(nullptr),
+      taskbarCreatedMessage_(0),
+      controlHwnd_(nullptr),
       hwnd_(nullptr),
       comboBox_(nullptr),
       volumeSlider_(nullptr),
+      volumeValueLabel_(nullptr),
       optimizationCombo_(nullptr),
-      volume_(DEFAULT_VOLUME),
-      latencyOptimizationLevel_(DEFAULT_OPTIMIZATION)
+      backgroundBrush_(nullptr),
+      highlightBrush_(nullptr),
+      highlightPen_(nullptr)
 {
     // Initialize common controls for trackbar and modern UI elements
     INITCOMMONCONTROLSEX icex = {};
@@ -50,74 +60,42 @@ Application::Application(const std::string &soundFolder)
     icex.dwICC = ICC_BAR_CLASSES | ICC_STANDARD_CLASSES;
     InitCommonControlsEx(&icex);
 
-    // Create the hook manager after we have the sound manager and player
-    hookManager_ = std::make_unique<KeyboardHookManager>(*soundManager_, *soundPlayer_);
-
-    // Set initial volume
-    soundPlayer_->setVolume(volume_);
-    
-    // Set initial optimization level
-    hookManager_->setLatencyOptimization(latencyOptimizationLevel_);
+    engine_->setChangeListener([this](Engine::Change change, int value) {
+        postEngineChange(change, value);
+    });
 }
 
 Application::~Application()
 {
-    // Ensure hook is uninstalled when application is destroyed
-    if (hookManager_)
-    {
-        hookManager_->uninstallHook();
-    }
-    
+    // The engine stops its services and the hook before the window state goes
+    engine_.reset();
+
     // Clean up fonts and other resources
-    for (HFONT font : fonts_) {
-        if (font) DeleteObject(font);
-    }
+    releaseUiResources();
 }
 
 int Application::run()
 {
+    Tracer::setThreadName("ui");
+
     // Seed random number generator
     srand(static_cast<unsigned>(time(nullptr)));
 
-    // Load sound packs
-    if (!loadSoundPacks())
-    {
-        MessageBoxW(nullptr, L"No sound packs found in sounds folder.", L"Error", MB_ICONERROR);
-        return 1;
-    }
-
-    // Initialize the window
-    if (!initializeWindow())
+    if (!runStartup())
     {
-        MessageBoxW(nullptr, L"Failed to create application window.", L"Error", MB_ICONERROR);
         return 1;
     }
 
-    // Load the default sound pack
-    if (!soundPacks_.empty())
-    {
-        // Use the first sound pack by default
-        soundManager_->setFolderPath(soundPacks_[0]);
-        std::cerr << "Setting default sound pack: " << soundPacks_[0] << std::endl;
-    }
-    
-    if (!soundManager_->loadSounds())
-    {
-        MessageBoxW(nullptr, L"Failed to load default sound pack.", L"Error", MB_ICONERROR);
-        return 1;
-    }
+    // Start the control endpoint and pack watcher once everything they drive is ready
+    engine_->startServices();
 
-    // Install keyboard hook
-    if (!hookManager_->installHook())
+    // Show the window, unless starting in the tray
+    if (hwnd_)
     {
-        MessageBoxW(nullptr, L"Error installing keyboard hook.", L"Error", MB_ICONERROR);
-        return 1;
+        ShowWindow(hwnd_, SW_SHOW);
+        UpdateWindow(hwnd_);
     }
 
-    // Show the window
-    ShowWindow(hwnd_, SW_SHOW);
-    UpdateWindow(hwnd_);
-
     // Message loop
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0))
@@ -129,54 +107,82 @@ int Application::run()
     return static_cast<int>(msg.wParam);
 }
 
-bool Application::loadSoundPacks()
+bool Application::runStartup()
 {
-    soundPacks_.clear();
-
-    try
-    {
-        // Validate sounds folder exists
-        if (!std::filesystem::exists(soundFolder_))
-        {
-            std::cerr << "Error: Sounds folder does not exist: " << soundFolder_ << std::endl;
-            return false;
-        }
-
-        // Find all subdirectories in the sounds folder
-        for (const auto &entry : std::filesystem::directory_iterator(soundFolder_))
+    using Affinity = StartupOrchestrator::Affinity;
+    StartupOrchestrator startup(startTime_);
+
+    // The engine's steps; the window only needs the pack list to fill its combobox
+    engine_->addStartupTasks(startup, true);
+    startup.addTask("create_window", {"scan_packs"}, Affinity::CALLER, [this]() {
+        return initializeWindow();
+    });
+
+    // Keep the hook serviced while workers run: it is called from this thread's message pump
+    bool quitRequested = false;
+    WPARAM quitCode = 0;
+    auto pump = [&quitRequested, &quitCode]() {
+        MSG msg;
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
-            if (entry.is_directory())
+            if (msg.message == WM_QUIT)
             {
-                soundPacks_.push_back(entry.path().string());
-                std::cerr << "Found sound pack: " << entry.path().string() << std::endl;
+                quitRequested = true;
+                quitCode = msg.wParam;
+                continue;
             }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
         }
-    }
-    catch (const std::filesystem::filesystem_error &e)
+    };
+
+    bool succeeded = startup.run(pump);
+    if (quitRequested)
     {
-        std::cerr << "Error scanning sound packs directory: " << e.what() << std::endl;
-        return false;
+        PostQuitMessage(static_cast<int>(quitCode));
     }
 
-    if (soundPacks_.empty())
+    engine_->finishStartup(startup);
+
+    if (!succeeded)
     {
-        std::cerr << "No sound packs found in: " << soundFolder_ << std::endl;
-        return false;
+        // Report the earliest failure the user can act on
+        using State = StartupOrchestrator::State;
+        const wchar_t *message = L"Startup failed.";
+        if (startup.getState("scan_packs") != State::DONE)
+        {
+            message = L"No sound packs found in sounds folder.";
+        }
+        else if (startup.getState("create_window") != State::DONE)
+        {
+            message = L"Failed to create application window.";
+        }
+        else if (startup.getState("load_pack") != State::DONE)
+        {
+            message = L"Failed to load default sound pack.";
+        }
+        else if (startup.getState("install_hook") != State::DONE)
+        {
+            message = L"Error installing keyboard hook.";
+        }
+        else if (startup.getState("open_device") != State::DONE)
+        {
+            message = L"Failed to open the audio device.";
+        }
+        MessageBoxW(nullptr, message, L"Error", MB_ICONERROR);
     }
 
-    std::cerr << "Loaded " << soundPacks_.size() << " sound packs" << std::endl;
-    return true;
+    return succeeded;
 }
 
 bool Application::initializeWindow()
 {
-    // Register window class
+    // Register window class; WM_PAINT fills the background, so the class needs no brush
     WNDCLASSW wc = {};
     wc.lpfnWndProc = WindowProc;
     wc.hInstance = GetModuleHandle(nullptr);
     wc.lpszClassName = CLASS_NAME;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
-    wc.hbrBackground = CreateSolidBrush(APP_BG_COLOR);
     wc.style = CS_HREDRAW | CS_VREDRAW;
     wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
 
@@ -185,6 +191,42 @@ bool Application::initializeWindow()
         return false;
     }
 
+    if (trayMode_)
+    {
+        // Never shown; it only owns the tray icon and receives engine changes
+        WNDCLASSW tray = {};
+        tray.lpfnWndProc = TrayWindowProc;
+        tray.hInstance = GetModuleHandle(nullptr);
+        tray.lpszClassName = TRAY_CLASS_NAME;
+        if (!RegisterClassW(&tray))
+        {
+            return false;
+        }
+
+        trayHwnd_ = CreateWindowExW(0, TRAY_CLASS_NAME, L"Keyboard Sounds", WS_POPUP, 0, 0, 0, 0,
+                                    nullptr, nullptr, GetModuleHandle(nullptr), this);
+        if (!trayHwnd_)
+        {
+            return false;
+        }
+        taskbarCreatedMessage_ = RegisterWindowMessageW(L"TaskbarCreated");
+        addTrayIcon();
+        controlHwnd_ = trayHwnd_;
+
+        // Starting hidden creates no window, font or brush until the icon is clicked
+        return startHidden_ || createMainWindow();
+    }
+
+    if (!createMainWindow())
+    {
+        return false;
+    }
+    controlHwnd_ = hwnd_;
+    return true;
+}
+
+bool Application::createMainWindow()
+{
     // Get screen dimensions for centering the window
     int screenWidth = GetSystemMetrics(SM_CXSCREEN);
     int screenHeight = GetSystemMetrics(SM_CYSCREEN);
@@ -206,10 +248,104 @@ bool Application::initializeWindow()
     return hwnd_ != nullptr;
 }
 
+bool Application::showWindow()
+{
+    if (!hwnd_ && !createMainWindow())
+    {
+        KS_LOG_ERROR("Failed to create the application window");
+        return false;
+    }
+    ShowWindow(hwnd_, SW_SHOWNORMAL);
+    UpdateWindow(hwnd_);
+    SetForegroundWindow(hwnd_);
+    return true;
+}
+
+void Application::hideToTray()
+{
+    if (!hwnd_)
+    {
+        return;
+    }
+
+    std::size_t residentBefore = ProcessMemory::getResidentBytes();
+    DWORD gdiBefore = GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+    DWORD userBefore = GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS);
+
+    // WM_DESTROY releases the fonts, brushes and pen with the controls
+    DestroyWindow(hwnd_);
+
+    std::size_t residentAfter = ProcessMemory::getResidentBytes();
+    std::size_t released = residentBefore > residentAfter ? residentBefore - residentAfter : 0;
+    KS_LOG_INFO("Window released to the tray: working set " << residentBefore / 1024 << " KB -> "
+                << residentAfter / 1024 << " KB (" << released / 1024 << " KB released), GDI objects "
+                << gdiBefore << " -> " << GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS)
+                << ", USER objects " << userBefore << " -> " << GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS));
+}
+
+void Application::addTrayIcon()
+{
+    NOTIFYICONDATAW data = {};
+    data.cbSize = sizeof(data);
+    data.hWnd = trayHwnd_;
+    data.uID = TRAY_ICON_ID;
+    data.uFlags = NIF_MESSAGE | NIF_ICON | NIF_TIP;
+    data.uCallbackMessage = WM_APP_TRAY;
+    data.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
+    wcscpy_s(data.szTip, L"Keyboard Sounds");
+    if (!Shell_NotifyIconW(NIM_ADD, &data))
+    {
+        KS_LOG_WARNING("Failed to add the tray icon");
+    }
+}
+
+void Application::showTrayMenu()
+{
+    // Built on demand so nothing stays allocated between clicks
+    HMENU menu = CreatePopupMenu();
+    if (!menu)
+    {
+        return;
+    }
+    AppendMenuW(menu, MF_STRING, TRAY_OPEN, L"Open");
+    AppendMenuW(menu, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(menu, MF_STRING, TRAY_EXIT, L"Exit");
+
+    // The menu only closes on an outside click if its owner is in the foreground
+    POINT cursor;
+    GetCursorPos(&cursor);
+    SetForegroundWindow(trayHwnd_);
+    TrackPopupMenu(menu, TPM_RIGHTBUTTON, cursor.x, cursor.y, 0, trayHwnd_, nullptr);
+    PostMessage(trayHwnd_, WM_NULL, 0, 0);
+    DestroyMenu(menu);
+}
+
+void Application::createPaintResources()
+{
+    backgroundBrush_ = CreateSolidBrush(APP_BG_COLOR);
+    highlightBrush_ = CreateSolidBrush(APP_HIGHLIGHT_COLOR);
+    highlightPen_ = CreatePen(PS_SOLID, 1, APP_HIGHLIGHT_COLOR);
+}
+
+void Application::releaseUiResources()
+{
+    for (HFONT font : fonts_) {
+        if (font) DeleteObject(font);
+    }
+    fonts_.clear();
+
+    for (HGDIOBJ object : {static_cast<HGDIOBJ>(backgroundBrush_), static_cast<HGDIOBJ>(highlightBrush_),
+                           static_cast<HGDIOBJ>(highlightPen_)}) {
+        if (object) DeleteObject(object);
+    }
+    backgroundBrush_ = nullptr;
+    highlightBrush_ = nullptr;
+    highlightPen_ = nullptr;
+}
+
 bool Application::updateSoundPack(const std::string &pack)
 {
-    soundManager_->setFolderPath(pack);
-    if (soundManager_->loadSounds())
+    if (engine_->switchSoundPack(pack))
     {
         // Successfully loaded the sounds
         return true;
@@ -224,53 +360,64 @@ bool Application::updateSoundPack(const std::string &pack)
 
 void Application::setVolume(int volume)
 {
-    // Clamp volume between 0 and 100
-    volume_ = (volume < 0) ? 0 : ((volume > 100) ? 100 : volume);
-
-    // Update the sound player
-    if (soundPlayer_)
-    {
-        soundPlayer_->setVolume(volume_);
-    }
+    // Clamped by the engine
+    engine_->setVolume(volume);
+    int current = engine_->getVolume();
 
     // Update the volume slider if it exists
     if (volumeSlider_)
     {
-        SendMessage(volumeSlider_, TBM_SETPOS, TRUE, volume_);
+        SendMessage(volumeSlider_, TBM_SETPOS, TRUE, current);
     }
     
     // Update volume label if it exists
     if (volumeValueLabel_)
     {
         wchar_t volumeText[16];
-        swprintf_s(volumeText, L"%d%%", volume_);
+        swprintf_s(volumeText, L"%d%%", current);
         SetWindowTextW(volumeValueLabel_, volumeText);
     }
 }
 
 int Application::getVolume() const
 {
-    return volume_;
+    return engine_->getVolume();
 }
 
 void Application::setLatencyOptimization(int level)
 {
-    // Clamp level between 0 and 3
-    latencyOptimizationLevel_ = (level < 0) ? 0 : ((level > 3) ? 3 : level);
-    
-    // Update the hook manager
-    if (hookManager_)
-    {
-        hookManager_->setLatencyOptimization(latencyOptimizationLevel_);
-    }
-    
+    // Clamped by the engine
+    engine_->setLatencyOptimization(level);
+
     // Update the combo box if it exists
     if (optimizationCombo_)
     {
-        SendMessage(optimizationCombo_, CB_SETCURSEL, latencyOptimizationLevel_, 0);
+        SendMessage(optimizationCombo_, CB_SETCURSEL, engine_->getLatencyOptimization(), 0);
     }
 }
 
+void Application::postEngineChange(Engine::Change change, int value)
+{
+    // Controls belong to the UI thread; apply the change there
+    ControlAction action = CONTROL_SELECT_PACK;
+    switch (change)
+    {
+    case Engine::Change::PACK_SELECTED:
+        action = CONTROL_SELECT_PACK;
+        break;
+    case Engine::Change::PACK_ADDED:
+        action = CONTROL_ADD_PACK;
+        break;
+    case Engine::Change::VOLUME:
+        action = CONTROL_SET_VOLUME;
+        break;
+    case Engine::Change::PROFILE:
+        action = CONTROL_SET_PROFILE;
+        break;
+    }
+    PostMessage(controlHwnd_, WM_APP_CONTROL, action, static_cast<LPARAM>(value));
+}
+
 HFONT Application::createFont(int size, bool bold, bool italic)
 {
     HFONT font = CreateFont(
@@ -293,21 +440,17 @@ HFONT Application::createFont(int size, bool bold, bool italic)
     return font;
 }
 
-void Application::drawRoundedRect(HDC hdc, RECT rect, COLORREF color, int radius)
+void Application::drawRoundedRect(HDC hdc, RECT rect, HBRUSH brush, HPEN pen, int radius)
 {
-    HBRUSH brush = CreateSolidBrush(color);
     HBRUSH oldBrush = (HBRUSH)SelectObject(hdc, brush);
-    HPEN pen = CreatePen(PS_SOLID, 1, color);
     HPEN oldPen = (HPEN)SelectObject(hdc, pen);
     
     // Create rounded rectangle
     RoundRect(hdc, rect.left, rect.top, rect.right, rect.bottom, radius, radius);
     
-    // Clean up
+    // Restore the DC; the brush and pen live as long as the window
     SelectObject(hdc, oldBrush);
     SelectObject(hdc, oldPen);
-    DeleteObject(brush);
-    DeleteObject(pen);
 }
 
 LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
@@ -337,7 +480,8 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         // Set current window text with version info
         SetWindowTextW(hwnd, L"Keyboard Sounds v1.0");
         
-        // Create fonts
+        // Create fonts, brushes and pen; all of them go with the window
+        app->createPaintResources();
         HFONT titleFont = app->createFont(28, true, false);
         HFONT labelFont = app->createFont(16, true, false);
         HFONT controlFont = app->createFont(15, false, false);
@@ -393,16 +537,18 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         SendMessage(app->comboBox_, WM_SETFONT, reinterpret_cast<WPARAM>(controlFont), TRUE);
 
         // Fill the combobox with sound packs
-        for (const auto &pack : app->soundPacks_)
         {
-            // Extract just the folder name, not the full path
-            std::filesystem::path p(pack);
-            std::wstring name = Utils::toWideString(p.filename().string());
-            SendMessageW(app->comboBox_, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(name.c_str()));
+            for (const auto &pack : app->engine_->getSoundPacks())
+            {
+                // Extract just the folder name, not the full path
+                std::filesystem::path p(pack);
+                std::wstring name = Utils::toWideString(p.filename().string());
+                SendMessageW(app->comboBox_, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(name.c_str()));
+            }
         }
 
-        // Select the first item
-        SendMessage(app->comboBox_, CB_SETCURSEL, 0, 0);
+        // Select the pack in use; a window recreated from the tray may find another than the first
+        SendMessage(app->comboBox_, CB_SETCURSEL, std::max(app->engine_->getCurrentPackIndex(), 0), 0);
         
         yPos += CONTROL_HEIGHT + SPACING;
         
@@ -430,7 +576,7 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         // Configure volume slider
         SendMessage(app->volumeSlider_, TBM_SETRANGE, TRUE, MAKELPARAM(0, 100));
         SendMessage(app->volumeSlider_, TBM_SETTICFREQ, 10, 0);
-        SendMessage(app->volumeSlider_, TBM_SETPOS, TRUE, app->volume_);
+        SendMessage(app->volumeSlider_, TBM_SETPOS, TRUE, app->engine_->getVolume());
         
         // Create volume value label
         app->volumeValueLabel_ = CreateWindowW(
@@ -473,7 +619,7 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         SendMessageW(app->optimizationCombo_, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Maximum (lowest latency)"));
         
         // Select the default optimization level
-        SendMessage(app->optimizationCombo_, CB_SETCURSEL, app->latencyOptimizationLevel_, 0);
+        SendMessage(app->optimizationCombo_, CB_SETCURSEL, app->engine_->getLatencyOptimization(), 0);
         
         yPos += CONTROL_HEIGHT + SPACING * 1.5;
         
@@ -531,19 +677,16 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
         
-        // Set background color
-        RECT rcClient;
-        GetClientRect(hwnd, &rcClient);
-        HBRUSH hbrBackground = CreateSolidBrush(APP_BG_COLOR);
-        FillRect(hdc, &rcClient, hbrBackground);
-        DeleteObject(hbrBackground);
-        
-        // Add visual styling if needed
+        // Set background color and add visual styling with the brushes made in WM_CREATE
         if (app) {
+            RECT rcClient;
+            GetClientRect(hwnd, &rcClient);
+            FillRect(hdc, &rcClient, app->backgroundBrush_);
+
             // Create a rounded rectangle for the entire client area
             RECT rcRounded = rcClient;
             InflateRect(&rcRounded, -5, -5);
-            app->drawRoundedRect(hdc, rcRounded, APP_HIGHLIGHT_COLOR, 15);
+            app->drawRoundedRect(hdc, rcRounded, app->highlightBrush_, app->highlightPen_, 15);
         }
         
         EndPaint(hwnd, &ps);
@@ -558,9 +701,10 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         if (id == 1 && event == CBN_SELCHANGE) // Sound pack combobox
         {
             int selectedIndex = SendMessage(app->comboBox_, CB_GETCURSEL, 0, 0);
-            if (selectedIndex != CB_ERR && selectedIndex < static_cast<int>(app->soundPacks_.size()))
+            std::string folder = app->engine_->getSoundPack(selectedIndex);
+            if (!folder.empty())
             {
-                app->updateSoundPack(app->soundPacks_[selectedIndex]);
+                app->updateSoundPack(folder);
             }
         }
         else if (id == 7 && event == CBN_SELCHANGE) // Optimization combobox
@@ -584,11 +728,71 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         return 0;
     }
 
+    case WM_APP_CONTROL: // Changes the engine made on its own threads
+    {
+        if (!app)
+            return 0;
+
+        int value = static_cast<int>(lParam);
+        switch (wParam)
+        {
+        case CONTROL_SELECT_PACK:
+            SendMessage(app->comboBox_, CB_SETCURSEL, value, 0);
+            break;
+        case CONTROL_SET_VOLUME:
+            app->setVolume(value);
+            break;
+        case CONTROL_SET_PROFILE:
+            app->setLatencyOptimization(value);
+            break;
+        case CONTROL_ADD_PACK:
+        {
+            std::string folder = app->engine_->getSoundPack(value);
+            if (!folder.empty())
+            {
+                std::wstring name = Utils::toWideString(std::filesystem::path(folder).filename().string());
+                SendMessageW(app->comboBox_, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(name.c_str()));
+            }
+            break;
+        }
+        }
+        return 0;
+    }
+
+    case WM_SYSCOMMAND:
+    {
+        // Minimizing to the tray releases the window instead of keeping it in the taskbar
+        if ((wParam & 0xFFF0) == SC_MINIMIZE && app && app->trayHwnd_)
+        {
+            app->hideToTray();
+            return 0;
+        }
+        break;
+    }
+
     case WM_DESTROY:
-        PostQuitMessage(0);
+        if (app)
+        {
+            app->releaseUiResources();
+            app->hwnd_ = nullptr;
+            app->comboBox_ = nullptr;
+            app->volumeSlider_ = nullptr;
+            app->volumeValueLabel_ = nullptr;
+            app->optimizationCombo_ = nullptr;
+        }
+        // In tray mode the session ends with the tray window
+        if (!app || !app->trayHwnd_)
+        {
+            PostQuitMessage(0);
+        }
         return 0;
 
     case WM_CLOSE:
+        if (app && app->trayHwnd_)
+        {
+            app->hideToTray();
+            return 0;
+        }
         DestroyWindow(hwnd);
         return 0;
         
@@ -599,21 +803,101 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
 }
 
+LRESULT CALLBACK Application::TrayWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+    Application *app = nullptr;
+
+    // Get the Application instance associated with this window
+    if (uMsg == WM_CREATE)
+    {
+        CREATESTRUCT *pCreate = reinterpret_cast<CREATESTRUCT *>(lParam);
+        app = reinterpret_cast<Application *>(pCreate->lpCreateParams);
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(app));
+        return 0;
+    }
+    app = reinterpret_cast<Application *>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    if (!app)
+    {
+        return DefWindowProc(hwnd, uMsg, wParam, lParam);
+    }
+
+    // Explorer restarted and lost every tray icon
+    if (app->taskbarCreatedMessage_ != 0 && uMsg == app->taskbarCreatedMessage_)
+    {
+        app->addTrayIcon();
+        return 0;
+    }
+
+    switch (uMsg)
+    {
+    case WM_APP_TRAY:
+        switch (LOWORD(lParam))
+        {
+        case WM_LBUTTONUP:
+        case WM_LBUTTONDBLCLK:
+            app->showWindow();
+            break;
+        case WM_RBUTTONUP:
+        case WM_CONTEXTMENU:
+            app->showTrayMenu();
+            break;
+        }
+        return 0;
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == TRAY_OPEN)
+        {
+            app->showWindow();
+        }
+        else if (LOWORD(wParam) == TRAY_EXIT)
+        {
+            if (app->hwnd_)
+            {
+                DestroyWindow(app->hwnd_);
+            }
+            DestroyWindow(hwnd);
+        }
+        return 0;
+
+    case WM_APP_CONTROL:
+        // The engine already applied the change; only a live window needs to show it
+        if (app->hwnd_)
+        {
+            SendMessage(app->hwnd_, WM_APP_CONTROL, wParam, lParam);
+        }
+        return 0;
+
+    case WM_DESTROY:
+    {
+        NOTIFYICONDATAW data = {};
+        data.cbSize = sizeof(data);
+        data.hWnd = hwnd;
+        data.uID = TRAY_ICON_ID;
+        Shell_NotifyIconW(NIM_DELETE, &data);
+        app->trayHwnd_ = nullptr;
+        PostQuitMessage(0);
+        return 0;
+    }
+    }
+
+    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
 void Application::SetControlColors(HWND hwnd)
 {
     // Set colors for comboboxes
     if (comboBox_) {
-        SendMessage(comboBox_, CB_SETCURSEL, 0, 0);
+        SendMessage(comboBox_, CB_SETCURSEL, std::max(engine_->getCurrentPackIndex(), 0), 0);
     }
     
     if (optimizationCombo_) {
-        SendMessage(optimizationCombo_, CB_SETCURSEL, latencyOptimizationLevel_, 0);
+        SendMessage(optimizationCombo_, CB_SETCURSEL, engine_->getLatencyOptimization(), 0);
     }
     
     // Set volume text
     if (volumeValueLabel_) {
         wchar_t volumeText[16];
-        swprintf_s(volumeText, L"%d%%", volume_);
+        swprintf_s(volumeText, L"%d%%", engine_->getVolume());
         SetWindowTextW(volumeValueLabel_, volumeText);
     }
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+/**
+ * @file AudioBackend.cpp
+ * @brief Backend factory and shared defaults
+ */
+#include "AudioBackend.h"
+#include "ClickSynth.h"
+#include "SFMLSoundBackend.h"
+#include "SFMLStreamBackend.h"
+#include "NullAudioBackend.h"
+
+std::unique_ptr<AudioBackend> AudioBackend::create(const std::string &name)
+{
+    if (name.empty() || name == "sfml-sound") {
+        return std::make_unique<SFMLSoundBackend>();
+    }
+    if (name == "sfml-stream") {
+        return std::make_unique<SFMLStreamBackend>();
+    }
+    if (name == "null") {
+        return std::make_unique<NullAudioBackend>();
+    }
+    return nullptr;
+}
+
+std::shared_ptr<AudioVoice> AudioBackend::startSynthVoice(const ClickParams &params, float volume,
+                                                          std::chrono::steady_clock::time_point onset)
+{
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    if (!ClickSynth::renderBuffer(params, 44100, *buffer)) {
+        return nullptr;
+    }
+    return startVoice(buffer, volume, onset);
+}
+
+std::shared_ptr<AudioVoice> AudioBackend::armSynthVoice(const ClickParams &params, float volume)
+{
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    if (!ClickSynth::renderBuffer(params, 44100, *buffer)) {
+        return nullptr;
+    }
+    return armVoice(buffer, volume);
+}
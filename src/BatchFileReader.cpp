@@ -0,0 +1,317 @@
+/**
+ * @file BatchFileReader.cpp
+ * @brief Implementation of the BatchFileReader class
+ */
+#include "BatchFileReader.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define KS_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#endif
+
+#ifdef KS_HAVE_IO_URING
+
+namespace {
+
+/**
+ * @brief Minimal io_uring instance driven through the raw system calls
+ */
+class Ring
+{
+public:
+    explicit Ring(unsigned int entries)
+    {
+        io_uring_params params = {};
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            return;
+        }
+
+        sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+
+        sq_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        cq_ = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+        void *sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sq_ == MAP_FAILED || cq_ == MAP_FAILED || sqes == MAP_FAILED) {
+            sqes_ = sqes == MAP_FAILED ? nullptr : static_cast<io_uring_sqe *>(sqes);
+            release();
+            return;
+        }
+
+        auto *sq = static_cast<char *>(sq_);
+        auto *cq = static_cast<char *>(cq_);
+        sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+        entries_ = params.sq_entries;
+    }
+
+    ~Ring()
+    {
+        release();
+    }
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    bool isValid() const
+    {
+        return sqes_ != nullptr && fd_ >= 0;
+    }
+
+    unsigned int getEntries() const
+    {
+        return entries_;
+    }
+
+    /**
+     * @brief Queue a read; the caller keeps the number queued within getEntries()
+     */
+    void queueRead(int fd, char *buffer, unsigned int length, std::uint64_t offset, std::uint64_t userData)
+    {
+        unsigned tail = *sqTail_;
+        unsigned index = tail & sqMask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++queued_;
+    }
+
+    /**
+     * @brief Submit queued reads and wait for at least one completion
+     * @return false on a system call error
+     */
+    bool submitAndWait()
+    {
+        for (;;) {
+            long result = syscall(__NR_io_uring_enter, fd_, queued_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0) {
+                queued_ -= static_cast<unsigned>(result);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief Pop one completion
+     * @return false if none is ready
+     */
+    bool popCompletion(std::uint64_t &userData, int &result)
+    {
+        unsigned head = *cqHead_;
+        if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe &cqe = cqes_[head & cqMask_];
+        userData = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    void release()
+    {
+        if (sqes_) munmap(sqes_, sqesSize_);
+        if (cq_ && cq_ != MAP_FAILED) munmap(cq_, cqSize_);
+        if (sq_ && sq_ != MAP_FAILED) munmap(sq_, sqSize_);
+        if (fd_ >= 0) close(fd_);
+        sqes_ = nullptr;
+        cq_ = sq_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    void *sq_ = nullptr;
+    void *cq_ = nullptr;
+    std::size_t sqSize_ = 0;
+    std::size_t cqSize_ = 0;
+    std::size_t sqesSize_ = 0;
+    unsigned *sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned *sqArray_ = nullptr;
+    unsigned *cqHead_ = nullptr;
+    unsigned *cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+    unsigned entries_ = 0;
+    unsigned queued_ = 0;
+};
+
+} // namespace
+
+bool BatchFileReader::readWithIoUring(std::vector<FileRead> &files)
+{
+    unsigned int entries = 1;
+    while (entries < files.size() && entries < MAX_IN_FLIGHT) {
+        entries <<= 1;
+    }
+    Ring ring(entries);
+    if (!ring.isValid()) {
+        KS_LOG_DEBUG("io_uring unavailable: " << std::strerror(errno));
+        return false;
+    }
+
+    // Opens stay synchronous: the read size is needed before the read can be queued
+    std::vector<int> fds(files.size(), -1);
+    std::vector<std::size_t> done(files.size(), 0);
+    std::deque<std::size_t> waiting;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        FileRead &file = files[i];
+        file.ok = false;
+        file.data.clear();
+        fds[i] = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fds[i] < 0 || fstat(fds[i], &info) != 0) {
+            continue;
+        }
+        file.data.resize(static_cast<std::size_t>(info.st_size));
+        if (file.data.empty()) {
+            file.ok = true;
+        } else {
+            waiting.push_back(i);
+        }
+    }
+
+    bool succeeded = true;
+    unsigned int inFlight = 0;
+    while (!waiting.empty() || inFlight > 0) {
+        while (!waiting.empty() && inFlight < ring.getEntries()) {
+            std::size_t i = waiting.front();
+            waiting.pop_front();
+            FileRead &file = files[i];
+            std::size_t remaining = file.data.size() - done[i];
+            ring.queueRead(fds[i], file.data.data() + done[i],
+                           static_cast<unsigned int>(std::min<std::size_t>(remaining, 1u << 30)), done[i], i);
+            ++inFlight;
+        }
+
+        if (!ring.submitAndWait()) {
+            KS_LOG_WARNING("io_uring submission failed: " << std::strerror(errno));
+            succeeded = false;
+            break;
+        }
+
+        std::uint64_t i;
+        int result;
+        while (ring.popCompletion(i, result)) {
+            --inFlight;
+            FileRead &file = files[i];
+            if (result < 0) {
+                // Left for the thread pool; -EINVAL here means a kernel without IORING_OP_READ
+                continue;
+            }
+            done[i] += static_cast<std::size_t>(result);
+            if (result == 0 || done[i] == file.data.size()) {
+                // A file that shrank since fstat is returned as read
+                file.data.resize(done[i]);
+                file.ok = true;
+            } else {
+                waiting.push_back(i); // Short read
+            }
+        }
+    }
+
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    return succeeded;
+}
+
+#else
+
+bool BatchFileReader::readWithIoUring(std::vector<FileRead> &)
+{
+    return false;
+}
+
+#endif // KS_HAVE_IO_URING
+
+void BatchFileReader::readWithThreadPool(std::vector<FileRead> &files)
+{
+    std::atomic<std::size_t> next(0);
+    auto worker = [&files, &next]() {
+        for (std::size_t i = next++; i < files.size(); i = next++) {
+            FileRead &file = files[i];
+            if (file.ok) {
+                continue;
+            }
+            std::ifstream in(file.path, std::ios::binary | std::ios::ate);
+            if (!in) {
+                continue;
+            }
+            file.data.resize(static_cast<std::size_t>(in.tellg()));
+            in.seekg(0);
+            file.ok = static_cast<bool>(in.read(file.data.data(), static_cast<std::streamsize>(file.data.size())));
+        }
+    };
+
+    unsigned int threads = std::min<unsigned int>(std::max(1u, std::thread::hardware_concurrency()), MAX_THREADS);
+    threads = std::min<unsigned int>(threads, static_cast<unsigned int>(files.size()));
+    std::vector<std::future<void>> workers;
+    for (unsigned int t = 1; t < threads; ++t) {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for (auto &future : workers) {
+        future.get();
+    }
+}
+
+BatchFileReader::Method BatchFileReader::readAll(std::vector<FileRead> &files, Method preferred)
+{
+    if (files.empty()) {
+        return preferred;
+    }
+
+    Method method = Method::THREAD_POOL;
+    if (preferred == Method::IO_URING && readWithIoUring(files)) {
+        method = Method::IO_URING;
+    }
+
+    // Anything io_uring could not read, or everything when it is unavailable
+    bool incomplete = std::any_of(files.begin(), files.end(), [](const FileRead &file) { return !file.ok; });
+    if (incomplete) {
+        readWithThreadPool(files);
+    }
+    return method;
+}
+
+const char *BatchFileReader::getMethodName(Method method)
+{
+    return method == Method::IO_URING ? "io_uring" : "thread_pool";
+}
@@ -0,0 +1,580 @@
+/**
+ * @file BusEffects.cpp
+ * @brief Implementation of the BusEffectChain class
+ */
+#include "BusEffects.h"
+#include "Config.h"
+#include "Logger.h"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr float PI = 3.14159265359f;
+constexpr float LN_1000 = 6.90775527898f; // -60 dB
+constexpr float LIMITER_KNEE = 0.8f;        // Soft clipping starts here, relative to the ceiling
+constexpr float LIMITER_ATTACK_MS = 1.0f;
+
+bool parseFloat(const std::string &value, float &out)
+{
+    try {
+        size_t consumed = 0;
+        float parsed = std::stof(value, &consumed);
+        if (consumed != value.size() || !std::isfinite(parsed)) {
+            return false;
+        }
+        out = parsed;
+        return true;
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+/**
+ * @brief Transposed direct form II biquad coefficients (a0 normalized to 1)
+ */
+struct Biquad
+{
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    enum class Shape
+    {
+        LOW_SHELF,
+        PEAK,
+        HIGH_SHELF
+    };
+
+    /**
+     * @brief Audio EQ cookbook filters (R. Bristow-Johnson), shelves with slope 1
+     */
+    static Biquad design(Shape shape, float frequency, float gainDb, float q, float sampleRate)
+    {
+        float A = std::pow(10.0f, gainDb / 40.0f);
+        float w0 = 2.0f * PI * std::min(frequency, 0.45f * sampleRate) / sampleRate;
+        float cosW = std::cos(w0);
+        float sinW = std::sin(w0);
+        float b0, b1, b2, a0, a1, a2;
+
+        if (shape == Shape::PEAK) {
+            float alpha = sinW / (2.0f * q);
+            b0 = 1.0f + alpha * A;
+            b1 = -2.0f * cosW;
+            b2 = 1.0f - alpha * A;
+            a0 = 1.0f + alpha / A;
+            a1 = -2.0f * cosW;
+            a2 = 1.0f - alpha / A;
+        } else {
+            float shelf = 2.0f * std::sqrt(A) * sinW / std::sqrt(2.0f);
+            float sign = shape == Shape::LOW_SHELF ? 1.0f : -1.0f;
+            b0 = A * ((A + 1.0f) - sign * (A - 1.0f) * cosW + shelf);
+            b1 = sign * 2.0f * A * ((A - 1.0f) - sign * (A + 1.0f) * cosW);
+            b2 = A * ((A + 1.0f) - sign * (A - 1.0f) * cosW - shelf);
+            a0 = (A + 1.0f) + sign * (A - 1.0f) * cosW + shelf;
+            a1 = -sign * 2.0f * ((A - 1.0f) + sign * (A + 1.0f) * cosW);
+            a2 = (A + 1.0f) + sign * (A - 1.0f) * cosW - shelf;
+        }
+
+        Biquad filter;
+        filter.b0 = b0 / a0;
+        filter.b1 = b1 / a0;
+        filter.b2 = b2 / a0;
+        filter.a1 = a1 / a0;
+        filter.a2 = a2 / a0;
+        return filter;
+    }
+};
+
+/**
+ * @brief In-place iterative radix-2 FFT of a fixed size
+ */
+class Fft
+{
+public:
+    explicit Fft(std::size_t size)
+        : size_(size), cos_(size / 2), sin_(size / 2), reversed_(size)
+    {
+        for (std::size_t i = 0; i < size / 2; ++i) {
+            cos_[i] = std::cos(2.0f * PI * static_cast<float>(i) / static_cast<float>(size));
+            sin_[i] = std::sin(2.0f * PI * static_cast<float>(i) / static_cast<float>(size));
+        }
+        std::size_t bits = 0;
+        while ((std::size_t(1) << bits) < size) {
+            ++bits;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            std::size_t r = 0;
+            for (std::size_t b = 0; b < bits; ++b) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed_[i] = r;
+        }
+    }
+
+    /**
+     * @brief Transform in place; the inverse is left unscaled
+     */
+    void transform(float *re, float *im, bool inverse) const
+    {
+        for (std::size_t i = 0; i < size_; ++i) {
+            std::size_t j = reversed_[i];
+            if (i < j) {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+
+        const float direction = inverse ? 1.0f : -1.0f;
+        for (std::size_t span = 2; span <= size_; span <<= 1) {
+            std::size_t half = span / 2;
+            std::size_t step = size_ / span;
+            for (std::size_t start = 0; start < size_; start += span) {
+                for (std::size_t k = 0; k < half; ++k) {
+                    float wr = cos_[k * step];
+                    float wi = direction * sin_[k * step];
+                    std::size_t a = start + k;
+                    std::size_t b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+
+private:
+    std::size_t size_;
+    std::vector<float> cos_;
+    std::vector<float> sin_;
+    std::vector<std::size_t> reversed_;
+};
+
+/**
+ * @brief Uniformly partitioned overlap-save convolution, mono in, stereo out
+ *
+ * The left and right impulse responses are packed into one complex
+ * spectrum per partition (H_L + i H_R). Because the input is real, one
+ * complex multiply-accumulate pass and one inverse FFT per block yield
+ * both output channels. The wet signal lags the dry one by one block.
+ */
+class Convolver
+{
+public:
+    static constexpr std::size_t BLOCK = BusEffectChain::REVERB_BLOCK;
+    static constexpr std::size_t SIZE = 2 * BLOCK;
+
+    Convolver(const std::vector<float> &left, const std::vector<float> &right)
+        : partitions_(std::max<std::size_t>(1, (std::max(left.size(), right.size()) + BLOCK - 1) / BLOCK)),
+          filterRe_(partitions_ * SIZE, 0.0f), filterIm_(partitions_ * SIZE, 0.0f),
+          historyRe_(partitions_ * SIZE, 0.0f), historyIm_(partitions_ * SIZE, 0.0f),
+          input_(SIZE, 0.0f), output_(2 * BLOCK, 0.0f),
+          workRe_(SIZE), workIm_(SIZE), fft_(SIZE)
+    {
+        for (std::size_t p = 0; p < partitions_; ++p) {
+            float *re = &filterRe_[p * SIZE];
+            float *im = &filterIm_[p * SIZE];
+            for (std::size_t i = 0; i < BLOCK; ++i) {
+                std::size_t n = p * BLOCK + i;
+                re[i] = n < left.size() ? left[n] : 0.0f;
+                im[i] = n < right.size() ? right[n] : 0.0f;
+            }
+            fft_.transform(re, im, false);
+        }
+    }
+
+    std::size_t getPartitions() const
+    {
+        return partitions_;
+    }
+
+    void process(float *mix, std::size_t frames, float wet)
+    {
+        for (std::size_t i = 0; i < frames; ++i) {
+            input_[BLOCK + position_] = 0.5f * (mix[i * 2] + mix[i * 2 + 1]);
+            mix[i * 2] += output_[position_ * 2] * wet;
+            mix[i * 2 + 1] += output_[position_ * 2 + 1] * wet;
+            if (++position_ == BLOCK) {
+                runBlock();
+                position_ = 0;
+            }
+        }
+    }
+
+private:
+    void runBlock()
+    {
+        // Spectrum of the last two blocks goes into the frequency-domain delay line
+        float *re = &historyRe_[head_ * SIZE];
+        float *im = &historyIm_[head_ * SIZE];
+        std::copy(input_.begin(), input_.end(), re);
+        std::fill(im, im + SIZE, 0.0f);
+        fft_.transform(re, im, false);
+
+        // Each partition of the filter meets the input spectrum from as many blocks ago
+        std::fill(workRe_.begin(), workRe_.end(), 0.0f);
+        std::fill(workIm_.begin(), workIm_.end(), 0.0f);
+        float *accRe = workRe_.data();
+        float *accIm = workIm_.data();
+        for (std::size_t p = 0; p < partitions_; ++p) {
+            std::size_t slot = (head_ + partitions_ - p) % partitions_;
+            const float *xRe = &historyRe_[slot * SIZE];
+            const float *xIm = &historyIm_[slot * SIZE];
+            const float *hRe = &filterRe_[p * SIZE];
+            const float *hIm = &filterIm_[p * SIZE];
+            for (std::size_t k = 0; k < SIZE; ++k) {
+                accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+                accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+            }
+        }
+        fft_.transform(accRe, accIm, true);
+
+        // The second half is free of circular wrap-around; real part left, imaginary part right
+        const float scale = 1.0f / static_cast<float>(SIZE);
+        for (std::size_t i = 0; i < BLOCK; ++i) {
+            output_[i * 2] = accRe[BLOCK + i] * scale;
+            output_[i * 2 + 1] = accIm[BLOCK + i] * scale;
+        }
+
+        std::copy(input_.begin() + BLOCK, input_.end(), input_.begin());
+        head_ = (head_ + 1) % partitions_;
+    }
+
+    std::size_t partitions_;
+    std::vector<float> filterRe_;
+    std::vector<float> filterIm_;
+    std::vector<float> historyRe_;
+    std::vector<float> historyIm_;
+    std::vector<float> input_;
+    std::vector<float> output_;
+    std::vector<float> workRe_;
+    std::vector<float> workIm_;
+    Fft fft_;
+    std::size_t head_ = 0;
+    std::size_t position_ = 0;
+};
+
+/**
+ * @brief Scale an impulse response to unit energy so reverbMix means the same for any room
+ */
+void normalize(std::vector<float> &response)
+{
+    double energy = 0.0;
+    for (float sample : response) {
+        energy += static_cast<double>(sample) * sample;
+    }
+    if (energy > 0.0) {
+        float scale = static_cast<float>(1.0 / std::sqrt(energy));
+        for (float &sample : response) {
+            sample *= scale;
+        }
+    }
+}
+
+/**
+ * @brief Built-in room: decaying noise that darkens as it decays, decorrelated per channel
+ */
+void buildRoom(const BusEffectSettings &settings, unsigned int sampleRate, std::vector<float> &left,
+               std::vector<float> &right)
+{
+    float seconds = std::clamp(settings.reverbTimeMs / 1000.0f, 0.05f, BusEffectChain::MAX_REVERB_SECONDS);
+    std::size_t length = static_cast<std::size_t>(seconds * static_cast<float>(sampleRate));
+    float damping = std::clamp(settings.reverbDamping, 0.0f, 1.0f);
+
+    std::vector<float> *channels[] = {&left, &right};
+    std::uint32_t state = 0x2545F491u;
+    for (std::vector<float> *response : channels) {
+        response->resize(length);
+        float smoothed = 0.0f;
+        for (std::size_t n = 0; n < length; ++n) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            float noise = static_cast<float>(static_cast<std::int32_t>(state)) / 2147483648.0f;
+            float progress = static_cast<float>(n) / static_cast<float>(length);
+            float pole = 0.95f * damping * progress;
+            smoothed = (1.0f - pole) * noise + pole * smoothed;
+            (*response)[n] = smoothed * std::exp(-LN_1000 * progress);
+        }
+        normalize(*response);
+    }
+}
+
+/**
+ * @brief Load an impulse response file, resampled to the mix rate
+ */
+bool loadImpulse(const std::string &path, unsigned int sampleRate, std::vector<float> &left,
+                 std::vector<float> &right)
+{
+    sf::SoundBuffer buffer;
+    if (!buffer.loadFromFile(path) || buffer.getChannelCount() == 0 || buffer.getSampleCount() == 0) {
+        return false;
+    }
+
+    const std::int16_t *samples = buffer.getSamples();
+    unsigned int channels = buffer.getChannelCount();
+    std::uint64_t frames = buffer.getSampleCount() / channels;
+    double step = static_cast<double>(buffer.getSampleRate()) / sampleRate;
+    std::size_t length = std::min(static_cast<std::size_t>(static_cast<double>(frames) / step),
+                                  static_cast<std::size_t>(BusEffectChain::MAX_REVERB_SECONDS * sampleRate));
+
+    left.resize(length);
+    right.resize(length);
+    for (std::size_t n = 0; n < length; ++n) {
+        double position = static_cast<double>(n) * step;
+        std::uint64_t index = std::min<std::uint64_t>(static_cast<std::uint64_t>(position), frames - 1);
+        std::uint64_t next = std::min<std::uint64_t>(index + 1, frames - 1);
+        float frac = static_cast<float>(position - static_cast<double>(index));
+        for (unsigned int c = 0; c < 2; ++c) {
+            unsigned int source = std::min(c, channels - 1);
+            float a = samples[index * channels + source];
+            float b = samples[next * channels + source];
+            (c == 0 ? left : right)[n] = a + (b - a) * frac;
+        }
+    }
+    normalize(left);
+    normalize(right);
+    return true;
+}
+
+} // namespace
+
+bool BusEffectSettings::set(const std::string &name, const std::string &value)
+{
+    struct FloatSetting
+    {
+        const char *name;
+        float BusEffectSettings::*field;
+        float minValue;
+        float maxValue;
+    };
+    static const FloatSetting FLOAT_SETTINGS[] = {
+        {"lowGainDb", &BusEffectSettings::lowGainDb, -24.0f, 24.0f},
+        {"lowFrequency", &BusEffectSettings::lowFrequency, 20.0f, 20000.0f},
+        {"midGainDb", &BusEffectSettings::midGainDb, -24.0f, 24.0f},
+        {"midFrequency", &BusEffectSettings::midFrequency, 20.0f, 20000.0f},
+        {"midQ", &BusEffectSettings::midQ, 0.1f, 20.0f},
+        {"highGainDb", &BusEffectSettings::highGainDb, -24.0f, 24.0f},
+        {"highFrequency", &BusEffectSettings::highFrequency, 20.0f, 20000.0f},
+        {"reverbMix", &BusEffectSettings::reverbMix, 0.0f, 1.0f},
+        {"reverbTimeMs", &BusEffectSettings::reverbTimeMs, 50.0f, BusEffectChain::MAX_REVERB_SECONDS * 1000.0f},
+        {"reverbDamping", &BusEffectSettings::reverbDamping, 0.0f, 1.0f},
+        {"thresholdDb", &BusEffectSettings::thresholdDb, -60.0f, 0.0f},
+        {"ratio", &BusEffectSettings::ratio, 1.0f, 100.0f},
+        {"attackMs", &BusEffectSettings::attackMs, 0.01f, 1000.0f},
+        {"releaseMs", &BusEffectSettings::releaseMs, 1.0f, 5000.0f},
+        {"makeupDb", &BusEffectSettings::makeupDb, -24.0f, 24.0f},
+        {"limiterCeilingDb", &BusEffectSettings::limiterCeilingDb, -24.0f, 0.0f},
+        {"limiterReleaseMs", &BusEffectSettings::limiterReleaseMs, 1.0f, 5000.0f},
+    };
+
+    if (name == "eq") {
+        return AppConfig::parseBool(value, eq);
+    }
+    if (name == "reverb") {
+        return AppConfig::parseBool(value, reverb);
+    }
+    if (name == "compressor") {
+        return AppConfig::parseBool(value, compressor);
+    }
+    if (name == "limiter") {
+        return AppConfig::parseBool(value, limiter);
+    }
+    if (name == "reverbImpulse") {
+        reverbImpulse = value;
+        return true;
+    }
+    for (const auto &setting : FLOAT_SETTINGS) {
+        if (name == setting.name) {
+            float parsed;
+            if (!parseFloat(value, parsed) || parsed < setting.minValue || parsed > setting.maxValue) {
+                return false;
+            }
+            this->*setting.field = parsed;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Everything process() needs, prepared by configure()
+ */
+struct BusEffectChain::Program
+{
+    bool eq = false;
+    Biquad bands[3];
+
+    std::unique_ptr<Convolver> reverb;
+    float reverbMix = 0.0f;
+
+    bool compressor = false;
+    float threshold = 1.0f;
+    float slope = 0.0f;
+    float attack = 0.0f;
+    float release = 0.0f;
+    float makeup = 1.0f;
+
+    bool limiter = false;
+    float ceiling = 1.0f;
+    float knee = 1.0f;
+    float limiterAttack = 0.0f;
+    float limiterRelease = 0.0f;
+};
+
+BusEffectChain::BusEffectChain(unsigned int sampleRate)
+    : sampleRate_(sampleRate > 0 ? sampleRate : 44100),
+      active_(nullptr),
+      pending_(nullptr),
+      retired_(nullptr),
+      eqState_{},
+      envelope_(0.0f),
+      limiterGain_(1.0f)
+{
+}
+
+BusEffectChain::~BusEffectChain()
+{
+    delete active_;
+    delete pending_.load();
+    delete retired_.load();
+}
+
+bool BusEffectChain::configure(const BusEffectSettings &settings)
+{
+    std::lock_guard<std::mutex> lock(configureMutex_);
+
+    const float rate = static_cast<float>(sampleRate_);
+    auto program = std::make_unique<Program>();
+    bool loaded = true;
+
+    program->eq = settings.eq;
+    program->bands[0] = Biquad::design(Biquad::Shape::LOW_SHELF, settings.lowFrequency, settings.lowGainDb, 1.0f, rate);
+    program->bands[1] = Biquad::design(Biquad::Shape::PEAK, settings.midFrequency, settings.midGainDb, settings.midQ, rate);
+    program->bands[2] = Biquad::design(Biquad::Shape::HIGH_SHELF, settings.highFrequency, settings.highGainDb, 1.0f, rate);
+
+    if (settings.reverb) {
+        std::vector<float> left;
+        std::vector<float> right;
+        if (!settings.reverbImpulse.empty() && !loadImpulse(settings.reverbImpulse, sampleRate_, left, right)) {
+            KS_LOG_WARNING("Failed to load impulse response " << settings.reverbImpulse << ", using the built-in room");
+            loaded = false;
+        }
+        if (left.empty()) {
+            buildRoom(settings, sampleRate_, left, right);
+        }
+        program->reverb = std::make_unique<Convolver>(left, right);
+        program->reverbMix = std::clamp(settings.reverbMix, 0.0f, 1.0f);
+        KS_LOG_DEBUG("Reverb: " << left.size() << " frames in " << program->reverb->getPartitions() << " partitions");
+    }
+
+    program->compressor = settings.compressor;
+    program->threshold = std::pow(10.0f, settings.thresholdDb / 20.0f);
+    program->slope = 1.0f - 1.0f / std::max(settings.ratio, 1.0f);
+    program->attack = std::exp(-1.0f / (std::max(settings.attackMs, 0.01f) * 0.001f * rate));
+    program->release = std::exp(-1.0f / (std::max(settings.releaseMs, 1.0f) * 0.001f * rate));
+    program->makeup = std::pow(10.0f, settings.makeupDb / 20.0f);
+
+    program->limiter = settings.limiter;
+    program->ceiling = std::pow(10.0f, std::min(settings.limiterCeilingDb, 0.0f) / 20.0f);
+    program->knee = LIMITER_KNEE * program->ceiling;
+    program->limiterAttack = std::exp(-1.0f / (LIMITER_ATTACK_MS * 0.001f * rate));
+    program->limiterRelease = std::exp(-1.0f / (std::max(settings.limiterReleaseMs, 1.0f) * 0.001f * rate));
+
+    // Free what the device thread has let go of, then offer the new setup
+    delete retired_.exchange(nullptr, std::memory_order_acquire);
+    delete pending_.exchange(program.release(), std::memory_order_acq_rel);
+    return loaded;
+}
+
+void BusEffectChain::process(float *mix, std::size_t frames)
+{
+    // Adopt a new setup only once the previous hand-over has been collected
+    if (retired_.load(std::memory_order_acquire) == nullptr) {
+        Program *next = pending_.exchange(nullptr, std::memory_order_acq_rel);
+        if (next) {
+            retired_.store(active_, std::memory_order_release);
+            active_ = next;
+        }
+    }
+
+    const Program *program = active_;
+    if (!program) {
+        return;
+    }
+
+    if (program->eq) {
+        for (std::size_t i = 0; i < frames; ++i) {
+            for (std::size_t band = 0; band < 3; ++band) {
+                const Biquad &f = program->bands[band];
+                for (std::size_t c = 0; c < 2; ++c) {
+                    float *z = eqState_[band][c];
+                    float x = mix[i * 2 + c];
+                    float y = f.b0 * x + z[0];
+                    z[0] = f.b1 * x - f.a1 * y + z[1];
+                    z[1] = f.b2 * x - f.a2 * y;
+                    mix[i * 2 + c] = y;
+                }
+            }
+        }
+
+        // Let silent filters settle to zero rather than into denormals
+        for (auto &band : eqState_) {
+            for (auto &channel : band) {
+                for (float &z : channel) {
+                    z = std::fabs(z) < 1e-15f ? 0.0f : z;
+                }
+            }
+        }
+    }
+
+    if (program->reverb) {
+        program->reverb->process(mix, frames, program->reverbMix);
+    }
+
+    if (program->compressor) {
+        // Stereo-linked peak follower; the gain curve is only evaluated above the threshold
+        float envelope = envelope_;
+        for (std::size_t i = 0; i < frames; ++i) {
+            float peak = std::max(std::fabs(mix[i * 2]), std::fabs(mix[i * 2 + 1]));
+            float coefficient = peak > envelope ? program->attack : program->release;
+            envelope = peak + coefficient * (envelope - peak);
+
+            float gain = program->makeup;
+            if (envelope > program->threshold) {
+                gain *= std::pow(envelope / program->threshold, -program->slope);
+            }
+            mix[i * 2] *= gain;
+            mix[i * 2 + 1] *= gain;
+        }
+        envelope_ = envelope < 1e-15f ? 0.0f : envelope;
+    }
+
+    if (program->limiter) {
+        // Gain follower aiming the peak at the knee, then a soft clip between the knee and the ceiling
+        const float knee = program->knee;
+        const float range = program->ceiling - knee;
+        float gain = limiterGain_;
+        for (std::size_t i = 0; i < frames; ++i) {
+            float peak = std::max(std::fabs(mix[i * 2]), std::fabs(mix[i * 2 + 1]));
+            float target = peak > knee ? knee / peak : 1.0f;
+            float coefficient = target < gain ? program->limiterAttack : program->limiterRelease;
+            gain = target + coefficient * (gain - target);
+
+            for (std::size_t c = 0; c < 2; ++c) {
+                float x = mix[i * 2 + c] * gain;
+                float magnitude = std::fabs(x);
+                if (magnitude > knee) {
+                    x = std::copysign(knee + range * std::tanh((magnitude - knee) / range), x);
+                }
+                mix[i * 2 + c] = x;
+            }
+        }
+        limiterGain_ = gain;
+    }
+}
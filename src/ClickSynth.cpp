@@ -0,0 +1,239 @@
+/**
+ * @file ClickSynth.cpp
+ * @brief Implementation of the ClickVoice and ClickSynth classes
+ */
+#include "ClickSynth.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KS_CLICK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr const char *MODEL_NAME = "click";
+constexpr float TWO_PI = 6.28318530718f;
+constexpr float LN_1000 = 6.90775527898f; // -60 dB
+
+/**
+ * @brief Base click of one key category (key down)
+ */
+struct CategoryModel
+{
+    const char *name;
+    float frequency[ClickParams::MODES];
+    float decay[ClickParams::MODES];
+    float gain[ClickParams::MODES];
+    float noiseGain;
+    float noiseDecay;
+    float noiseCutoff;
+};
+
+// Larger keys ring lower and longer, and their stabilizer spring is louder
+const CategoryModel CATEGORY_MODELS[] = {
+    {"alpha", {1900.0f, 3300.0f, 5400.0f, 4200.0f}, {0.018f, 0.012f, 0.008f, 0.020f},
+     {0.30f, 0.18f, 0.10f, 0.02f}, 0.35f, 0.006f, 7000.0f},
+    {"alt", {1500.0f, 2800.0f, 4700.0f, 3900.0f}, {0.022f, 0.014f, 0.009f, 0.030f},
+     {0.30f, 0.18f, 0.10f, 0.04f}, 0.30f, 0.007f, 6000.0f},
+    {"enter", {700.0f, 1600.0f, 3100.0f, 3600.0f}, {0.040f, 0.025f, 0.015f, 0.090f},
+     {0.32f, 0.20f, 0.10f, 0.10f}, 0.35f, 0.009f, 5000.0f},
+    {"space", {320.0f, 950.0f, 2100.0f, 3400.0f}, {0.060f, 0.035f, 0.020f, 0.140f},
+     {0.34f, 0.20f, 0.10f, 0.14f}, 0.30f, 0.012f, 4000.0f},
+    {"other", {1700.0f, 3000.0f, 5000.0f, 4000.0f}, {0.020f, 0.013f, 0.008f, 0.025f},
+     {0.30f, 0.18f, 0.10f, 0.03f}, 0.32f, 0.007f, 6500.0f},
+};
+
+std::uint32_t mix(std::uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Uniform value in [-1, 1] drawn from a hash state
+ */
+float jitter(std::uint32_t &state)
+{
+    state = mix(state + 0x9E3779B9u);
+    return static_cast<float>(state) / 2147483648.0f - 1.0f;
+}
+
+} // namespace
+
+void ClickVoice::start(const ClickParams &params, unsigned int sampleRate)
+{
+    const float rate = static_cast<float>(sampleRate);
+    float longest = params.noiseDecay;
+
+    for (std::size_t m = 0; m < ClickParams::MODES; ++m) {
+        // Damped sine starting at zero phase: y[n] = 2r cos(w) y[n-1] - r^2 y[n-2]
+        float w = TWO_PI * std::min(params.modeFrequency[m], 0.45f * rate) / rate;
+        float r = std::exp(-LN_1000 / (std::max(params.modeDecay[m], 0.001f) * rate));
+        coef1_[m] = 2.0f * r * std::cos(w);
+        coef2_[m] = r * r;
+        y1_[m] = 0.0f;
+        y2_[m] = -params.modeGain[m] * std::sin(w) / r;
+        longest = std::max(longest, params.modeDecay[m]);
+    }
+
+    noiseLevel_ = params.noiseGain;
+    noiseDecay_ = std::exp(-LN_1000 / (std::max(params.noiseDecay, 0.001f) * rate));
+    noiseCoef_ = 1.0f - std::exp(-TWO_PI * std::min(params.noiseCutoff, 0.45f * rate) / rate);
+    noiseState_ = 0.0f;
+    rng_ = params.seed | 1u;
+    remaining_ = static_cast<std::uint64_t>(std::min(longest, ClickSynth::MAX_DURATION) * rate);
+}
+
+bool ClickVoice::render(float *mix, std::size_t frames, float gain)
+{
+    const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(frames, remaining_));
+
+#ifdef KS_CLICK_SSE2
+    const __m128 c1 = _mm_load_ps(coef1_);
+    const __m128 c2 = _mm_load_ps(coef2_);
+    __m128 y1 = _mm_load_ps(y1_);
+    __m128 y2 = _mm_load_ps(y2_);
+#endif
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float sample;
+#ifdef KS_CLICK_SSE2
+        // All modes advance together, then their lanes are summed
+        __m128 y = _mm_sub_ps(_mm_mul_ps(c1, y1), _mm_mul_ps(c2, y2));
+        y2 = y1;
+        y1 = y;
+        __m128 sum = _mm_add_ps(y, _mm_movehl_ps(y, y));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        sample = _mm_cvtss_f32(sum);
+#else
+        sample = 0.0f;
+        for (std::size_t m = 0; m < ClickParams::MODES; ++m) {
+            float y = coef1_[m] * y1_[m] - coef2_[m] * y2_[m];
+            y2_[m] = y1_[m];
+            y1_[m] = y;
+            sample += y;
+        }
+#endif
+
+        // Contact noise: xorshift white noise through a one-pole low-pass
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        float white = static_cast<float>(static_cast<std::int32_t>(rng_)) * (1.0f / 2147483648.0f);
+        noiseState_ += noiseCoef_ * (white - noiseState_);
+        sample += noiseState_ * noiseLevel_;
+        noiseLevel_ *= noiseDecay_;
+
+        sample *= gain;
+        mix[i * 2] += sample;
+        mix[i * 2 + 1] += sample;
+    }
+
+#ifdef KS_CLICK_SSE2
+    _mm_store_ps(y1_, y1);
+    _mm_store_ps(y2_, y2);
+#endif
+
+    remaining_ -= count;
+    return remaining_ > 0;
+}
+
+std::string ClickSynth::getFolderPath()
+{
+    return std::string(PATH_PREFIX) + MODEL_NAME;
+}
+
+bool ClickSynth::isSynthPath(const std::string &path)
+{
+    return path.compare(0, std::strlen(PATH_PREFIX), PATH_PREFIX) == 0;
+}
+
+std::string ClickSynth::getSoundPath(const std::string &categoryName, bool keyDown, std::size_t variant)
+{
+    return getFolderPath() + "/" + categoryName + (keyDown ? "/down/" : "/up/") + std::to_string(variant);
+}
+
+bool ClickSynth::getParams(const std::string &path, std::uint32_t keystroke, ClickParams &params)
+{
+    // "synth:click/<category>/<down|up>/<variant>"
+    const std::string folder = getFolderPath() + "/";
+    if (path.compare(0, folder.size(), folder) != 0) {
+        return false;
+    }
+    std::size_t categoryEnd = path.find('/', folder.size());
+    std::size_t directionEnd = categoryEnd == std::string::npos ? categoryEnd : path.find('/', categoryEnd + 1);
+    if (directionEnd == std::string::npos) {
+        return false;
+    }
+    std::string category = path.substr(folder.size(), categoryEnd - folder.size());
+    std::string direction = path.substr(categoryEnd + 1, directionEnd - categoryEnd - 1);
+    std::string variantText = path.substr(directionEnd + 1);
+    if ((direction != "down" && direction != "up") || variantText.empty() || variantText.size() > 6 ||
+        variantText.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+
+    const CategoryModel *model = nullptr;
+    for (const auto &candidate : CATEGORY_MODELS) {
+        if (category == candidate.name) {
+            model = &candidate;
+        }
+    }
+    if (!model) {
+        return false;
+    }
+
+    // Key up is the lighter, higher release click
+    const bool keyDown = direction == "down";
+    const float pitch = keyDown ? 1.0f : 1.12f;
+    const float level = keyDown ? 1.0f : 0.55f;
+    const float length = keyDown ? 1.0f : 0.8f;
+
+    // The variant fixes the character of the sound, the keystroke adds a little life on top
+    std::uint32_t variantState = mix(static_cast<std::uint32_t>(std::stoul(variantText)) * 131u +
+                                     static_cast<std::uint32_t>(model - CATEGORY_MODELS) * 7u + (keyDown ? 1u : 0u));
+    std::uint32_t strokeState = mix(variantState ^ keystroke);
+    const float strokePitch = 1.0f + 0.02f * jitter(strokeState);
+
+    for (std::size_t m = 0; m < ClickParams::MODES; ++m) {
+        params.modeFrequency[m] = model->frequency[m] * pitch * (1.0f + 0.06f * jitter(variantState)) * strokePitch;
+        params.modeDecay[m] = model->decay[m] * length;
+        params.modeGain[m] = model->gain[m] * level * (1.0f + 0.2f * jitter(variantState));
+    }
+    params.noiseGain = model->noiseGain * level * (1.0f + 0.15f * jitter(strokeState));
+    params.noiseDecay = model->noiseDecay * length;
+    params.noiseCutoff = model->noiseCutoff * pitch;
+    params.seed = mix(strokeState);
+    return true;
+}
+
+bool ClickSynth::renderBuffer(const ClickParams &params, unsigned int sampleRate, sf::SoundBuffer &buffer)
+{
+    ClickVoice voice;
+    voice.start(params, sampleRate);
+
+    // Render in blocks until the click has died away
+    constexpr std::size_t BLOCK_FRAMES = 256;
+    std::vector<float> mixed;
+    bool sounding = true;
+    while (sounding) {
+        std::size_t offset = mixed.size();
+        mixed.resize(offset + BLOCK_FRAMES * 2, 0.0f);
+        sounding = voice.render(mixed.data() + offset, BLOCK_FRAMES, 1.0f);
+    }
+
+    std::vector<std::int16_t> samples(mixed.size());
+    for (std::size_t i = 0; i < mixed.size(); ++i) {
+        samples[i] = static_cast<std::int16_t>(std::lrint(std::clamp(mixed[i], -1.0f, 1.0f) * 32767.0f));
+    }
+    return buffer.loadFromSamples(samples.data(), samples.size(), 2, sampleRate,
+                                  {sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight});
+}
@@ -0,0 +1,217 @@
+/**
+ * @file Config.cpp
+ * @brief Implementation of the AppConfig loader
+ */
+#include "Config.h"
+#include "Logger.h"
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+namespace {
+
+std::string trim(const std::string &str)
+{
+    auto begin = std::find_if_not(str.begin(), str.end(), [](unsigned char c) { return std::isspace(c); });
+    auto end = std::find_if_not(str.rbegin(), str.rend(), [](unsigned char c) { return std::isspace(c); }).base();
+    return begin < end ? std::string(begin, end) : std::string();
+}
+
+constexpr unsigned int MIN_SAMPLE_RATE = 8000;
+constexpr unsigned int MAX_SAMPLE_RATE = 384000;
+constexpr unsigned int MAX_PERIOD_FRAMES = 65536;
+
+bool parseUnsigned(const std::string &value, unsigned int &out)
+{
+    // std::stoul would accept a sign and wrap "-1" around to the maximum
+    if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0]))) {
+        return false;
+    }
+
+    try {
+        size_t consumed = 0;
+        unsigned long parsed = std::stoul(value, &consumed);
+        if (consumed != value.size() || parsed > std::numeric_limits<unsigned int>::max()) {
+            return false;
+        }
+        out = static_cast<unsigned int>(parsed);
+        return true;
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+} // namespace
+
+bool AppConfig::parseBool(const std::string &value, bool &out)
+{
+    if (value == "true" || value == "1" || value == "yes" || value == "on") {
+        out = true;
+        return true;
+    }
+    if (value == "false" || value == "0" || value == "no" || value == "off") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+AppConfig AppConfig::loadFromFile(const std::string &path)
+{
+    AppConfig config;
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        KS_LOG_WARNING("No configuration file at " << path << ", using defaults");
+        return config;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        // Strip comments and surrounding whitespace
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        auto separator = line.find('=');
+        if (separator == std::string::npos) {
+            KS_LOG_WARNING(path << ":" << lineNumber << ": expected key = value");
+            continue;
+        }
+
+        std::string key = trim(line.substr(0, separator));
+        std::string value = trim(line.substr(separator + 1));
+        if (!config.set(key, value)) {
+            KS_LOG_WARNING(path << ":" << lineNumber << ": invalid setting '" << key << "'");
+        }
+    }
+
+    KS_LOG_INFO("Loaded configuration from " << path);
+    return config;
+}
+
+bool AppConfig::set(const std::string &key, const std::string &value)
+{
+    if (key == "audio.backend") {
+        if (value != "sfml-sound" && value != "sfml-stream" && value != "null") {
+            return false;
+        }
+        audio.backend = value;
+        return true;
+    }
+    if (key == "audio.device") {
+        audio.device = value;
+        return true;
+    }
+    if (key == "audio.sampleRate") {
+        unsigned int rate = 0;
+        if (!parseUnsigned(value, rate) || rate < MIN_SAMPLE_RATE || rate > MAX_SAMPLE_RATE) {
+            return false;
+        }
+        audio.sampleRate = rate;
+        return true;
+    }
+    if (key == "audio.periodFrames") {
+        unsigned int frames = 0;
+        if (!parseUnsigned(value, frames) || frames == 0 || frames > MAX_PERIOD_FRAMES) {
+            return false;
+        }
+        audio.periodFrames = frames;
+        return true;
+    }
+    if (key == "audio.outputFile") {
+        audio.outputFile = value;
+        return true;
+    }
+    if (key == "audio.scheduleLatencyMs") {
+        unsigned int ms = 0;
+        if (!parseUnsigned(value, ms) || ms > 1000) {
+            return false;
+        }
+        audio.scheduleLatencyMs = ms;
+        return true;
+    }
+    if (key == "audio.overloadPolicy") {
+        if (value != "limit" && value != "drop") {
+            return false;
+        }
+        audio.overloadPolicy = value == "drop" ? OverloadPolicy::DROP : OverloadPolicy::LIMIT;
+        return true;
+    }
+    if (key.rfind("effects.", 0) == 0) {
+        return audio.effects.set(key.substr(8), value);
+    }
+    if (key == "power.idleTimeoutMs") {
+        unsigned int ms = 0;
+        if (!parseUnsigned(value, ms)) {
+            return false;
+        }
+        idleTimeout = std::chrono::milliseconds(ms);
+        return true;
+    }
+    if (key == "power.keepDeviceWarm") {
+        return parseBool(value, keepDeviceWarm);
+    }
+    if (key == "input.stream") {
+        inputStream = value;
+        return true;
+    }
+    if (key == "input.streamFormat") {
+        if (value != "text" && value != "binary") {
+            return false;
+        }
+        inputStreamFormat = value;
+        return true;
+    }
+    if (key == "input.evdev") {
+        return parseBool(value, evdevInput);
+    }
+    if (key == "control.endpoint") {
+        controlEndpoint = value;
+        return true;
+    }
+    if (key == "telemetry.enabled") {
+        return parseBool(value, telemetryEnabled);
+    }
+    if (key == "telemetry.name") {
+        if (value.empty()) {
+            return false;
+        }
+        telemetryName = value;
+        return true;
+    }
+    if (key == "log.level") {
+        return Logger::parseLevel(value, logLevel);
+    }
+    if (key == "log.file") {
+        logFile = value;
+        return true;
+    }
+    if (key == "trace.file") {
+        traceFile = value;
+        return true;
+    }
+    if (key == "packs.watch") {
+        return parseBool(value, watchPacks);
+    }
+    if (key == "packs.watchDebounceMs") {
+        unsigned int ms = 0;
+        if (!parseUnsigned(value, ms)) {
+            return false;
+        }
+        watchDebounce = std::chrono::milliseconds(ms);
+        return true;
+    }
+    if (key == "ui.tray") {
+        return parseBool(value, trayMode);
+    }
+    if (key == "ui.startHidden") {
+        return parseBool(value, startHidden);
+    }
+    return false;
+}
@@ -0,0 +1,325 @@
+/**
+ * @file ControlServer.cpp
+ * @brief Implementation of the ControlServer class
+ */
+#include "ControlServer.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utils.h"
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t MAX_REQUEST_LENGTH = 4096;
+
+// A client silent for this long is disconnected so it cannot hold up the others
+constexpr int CLIENT_TIMEOUT_MS = 5000;
+
+} // namespace
+
+ControlServer::ControlServer(const std::string &endpoint, Handler handler)
+    : endpoint_(endpoint),
+      handler_(std::move(handler)),
+      running_(false),
+#ifdef _WIN32
+      handle_(nullptr),
+      stopEvent_(nullptr)
+#else
+      listenFd_(-1),
+      wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+#endif
+{
+}
+
+ControlServer::~ControlServer()
+{
+    stop();
+#ifndef _WIN32
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+#endif
+}
+
+std::string ControlServer::handleRequest(const std::string &line)
+{
+    std::string request = line;
+    if (!request.empty() && request.back() == '\r') {
+        request.pop_back();
+    }
+
+    auto space = request.find(' ');
+    std::string command = request.substr(0, space);
+    std::string argument = space == std::string::npos ? std::string() : request.substr(space + 1);
+
+    try {
+        std::string payload = handler_(command, argument);
+        if (!payload.empty() && payload.back() != '\n') {
+            payload.push_back('\n');
+        }
+        return payload + "OK\n";
+    } catch (const std::invalid_argument &e) {
+        return std::string("ERR ") + e.what() + "\n";
+    } catch (const std::exception &e) {
+        KS_LOG_ERROR("Control request '" << command << "' failed: " << e.what());
+        return std::string("ERR internal error\n");
+    }
+}
+
+#ifdef _WIN32
+
+bool ControlServer::start()
+{
+    if (running_ || endpoint_.rfind("pipe:", 0) != 0) {
+        KS_LOG_WARNING("Unsupported control endpoint on Windows: " << endpoint_);
+        return false;
+    }
+
+    // Overlapped, so every wait can also watch the stop event and a client timeout
+    std::wstring pipeName = L"\\\\.\\pipe\\" + Utils::toWideString(endpoint_.substr(5));
+    HANDLE pipe = CreateNamedPipeW(pipeName.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                   PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                   1, 64 * 1024, static_cast<DWORD>(MAX_REQUEST_LENGTH), 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) {
+        DWORD error = GetLastError();
+        KS_LOG_ERROR("Failed to create control pipe " << endpoint_ << ", error " << error);
+        return false;
+    }
+
+    HANDLE stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stopEvent) {
+        DWORD error = GetLastError();
+        KS_LOG_ERROR("Failed to create control stop event, error " << error);
+        CloseHandle(pipe);
+        return false;
+    }
+
+    handle_ = pipe;
+    stopEvent_ = stopEvent;
+    running_ = true;
+    thread_ = std::thread(&ControlServer::serve, this);
+    KS_LOG_INFO("Control server listening on " << endpoint_);
+    return true;
+}
+
+void ControlServer::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // Unlike cancelling the I/O, the event stays set if the server thread is not waiting yet
+    SetEvent(static_cast<HANDLE>(stopEvent_));
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    CloseHandle(static_cast<HANDLE>(handle_));
+    CloseHandle(static_cast<HANDLE>(stopEvent_));
+    handle_ = nullptr;
+    stopEvent_ = nullptr;
+}
+
+void ControlServer::serve()
+{
+    Tracer::setThreadName("control");
+    HANDLE pipe = static_cast<HANDLE>(handle_);
+    HANDLE stopEvent = static_cast<HANDLE>(stopEvent_);
+    char buffer[1024];
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!overlapped.hEvent) {
+        KS_LOG_ERROR("Failed to create control I/O event, error " << GetLastError());
+        return;
+    }
+
+    // Finish an overlapped call that returned `started`; false on failure, timeout or stop()
+    auto complete = [&](BOOL started, DWORD timeout, DWORD &bytes) {
+        if (!started && GetLastError() != ERROR_IO_PENDING) {
+            return false;
+        }
+        if (!started) {
+            HANDLE handles[2] = {stopEvent, overlapped.hEvent};
+            if (WaitForMultipleObjects(2, handles, FALSE, timeout) != WAIT_OBJECT_0 + 1) {
+                CancelIoEx(pipe, &overlapped);
+                GetOverlappedResult(pipe, &overlapped, &bytes, TRUE); // The buffer is in use until then
+                return false;
+            }
+        }
+        return GetOverlappedResult(pipe, &overlapped, &bytes, FALSE) != 0;
+    };
+
+    while (running_) {
+        DWORD bytes = 0;
+        BOOL connected = ConnectNamedPipe(pipe, &overlapped);
+        if (!connected && GetLastError() == ERROR_PIPE_CONNECTED) {
+            connected = TRUE; // Client arrived between CreateNamedPipe/DisconnectNamedPipe and here
+        } else if (!complete(connected, INFINITE, bytes)) {
+            if (running_) {
+                KS_LOG_ERROR("Control pipe stopped accepting clients, error " << GetLastError());
+            }
+            break;
+        }
+
+        std::string pending;
+        bool open = true;
+        while (running_ && open) {
+            BOOL started = ReadFile(pipe, buffer, sizeof(buffer), nullptr, &overlapped);
+            if (!complete(started, CLIENT_TIMEOUT_MS, bytes) || bytes == 0) {
+                break;
+            }
+            pending.append(buffer, bytes);
+
+            std::size_t newline;
+            while (open && (newline = pending.find('\n')) != std::string::npos) {
+                std::string response = handleRequest(pending.substr(0, newline));
+                pending.erase(0, newline + 1);
+
+                started = WriteFile(pipe, response.data(), static_cast<DWORD>(response.size()), nullptr, &overlapped);
+                open = complete(started, CLIENT_TIMEOUT_MS, bytes) && bytes == response.size();
+            }
+
+            if (pending.size() > MAX_REQUEST_LENGTH) {
+                break;
+            }
+        }
+
+        DisconnectNamedPipe(pipe);
+    }
+
+    CloseHandle(overlapped.hEvent);
+}
+
+#else
+
+bool ControlServer::start()
+{
+    if (running_ || endpoint_.rfind("unix:", 0) != 0) {
+        KS_LOG_WARNING("Unsupported control endpoint: " << endpoint_);
+        return false;
+    }
+
+    std::string path = endpoint_.substr(5);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        KS_LOG_WARNING("Control socket path too long: " << path);
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // Replace a socket left behind by a previous run, but never some other file
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            KS_LOG_ERROR("Control socket path exists and is not a socket: " << path);
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listenFd_, 8) < 0) {
+        KS_LOG_ERROR("Failed to listen on control socket " << path << ": " << std::strerror(errno));
+        if (listenFd_ >= 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+        }
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&ControlServer::serve, this);
+    KS_LOG_INFO("Control server listening on " << path);
+    return true;
+}
+
+void ControlServer::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    std::uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    close(listenFd_);
+    listenFd_ = -1;
+    unlink(endpoint_.substr(5).c_str());
+}
+
+void ControlServer::serve()
+{
+    Tracer::setThreadName("control");
+    char buffer[1024];
+
+    // Wait for fd to become readable; false when stop() fired or the timeout ran out
+    auto waitReadable = [this](int fd, int timeout) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+        for (;;) {
+            int result = poll(fds, 2, timeout);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            return result > 0 && fds[1].revents == 0;
+        }
+    };
+
+    while (running_ && waitReadable(listenFd_, -1)) {
+        int client = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+
+        // A client that stops reading must not block the server on a full socket buffer either
+        timeval sendTimeout = {CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+        std::string pending;
+        bool connected = true;
+        while (connected && running_ && waitReadable(client, CLIENT_TIMEOUT_MS)) {
+            ssize_t bytes = read(client, buffer, sizeof(buffer));
+            if (bytes <= 0) {
+                break;
+            }
+            pending.append(buffer, static_cast<std::size_t>(bytes));
+
+            std::size_t newline;
+            while (connected && (newline = pending.find('\n')) != std::string::npos) {
+                std::string response = handleRequest(pending.substr(0, newline));
+                pending.erase(0, newline + 1);
+                connected = send(client, response.data(), response.size(), MSG_NOSIGNAL) ==
+                            static_cast<ssize_t>(response.size());
+            }
+
+            if (pending.size() > MAX_REQUEST_LENGTH) {
+                break;
+            }
+        }
+
+        close(client);
+    }
+}
+
+#endif
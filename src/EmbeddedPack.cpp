@@ -0,0 +1,88 @@
+/**
+ * @file EmbeddedPack.cpp
+ * @brief Implementation of the EmbeddedPack class
+ */
+#include "EmbeddedPack.h"
+#include <cstdlib>
+#include <vector>
+
+#ifdef KS_EMBEDDED_PACK
+// Generated by tools/pack_embedder.cpp: PACK_NAME, SAMPLES[] and SOUNDS[]
+#include "embedded_pack_data.inc"
+#endif
+
+namespace {
+
+#ifdef KS_EMBEDDED_PACK
+constexpr const EmbeddedSound *SOUND_TABLE = embedded_pack::SOUNDS;
+constexpr std::size_t SOUND_COUNT = sizeof(embedded_pack::SOUNDS) / sizeof(embedded_pack::SOUNDS[0]);
+constexpr std::size_t SAMPLE_BYTES = sizeof(embedded_pack::SAMPLES);
+constexpr const char *PACK_NAME = embedded_pack::PACK_NAME;
+#else
+constexpr const EmbeddedSound *SOUND_TABLE = nullptr;
+constexpr std::size_t SOUND_COUNT = 0;
+constexpr std::size_t SAMPLE_BYTES = 0;
+constexpr const char *PACK_NAME = "";
+#endif
+
+} // namespace
+
+bool EmbeddedPack::isAvailable()
+{
+    return SOUND_COUNT > 0;
+}
+
+std::string EmbeddedPack::getFolderPath()
+{
+    return isAvailable() ? std::string(PATH_PREFIX) + PACK_NAME : std::string();
+}
+
+bool EmbeddedPack::isEmbeddedPath(const std::string &path)
+{
+    return path.rfind(PATH_PREFIX, 0) == 0;
+}
+
+std::size_t EmbeddedPack::getSoundCount()
+{
+    return SOUND_COUNT;
+}
+
+const EmbeddedSound &EmbeddedPack::getSound(std::size_t index)
+{
+    return SOUND_TABLE[index];
+}
+
+std::string EmbeddedPack::getSoundPath(std::size_t index)
+{
+    const EmbeddedSound &sound = SOUND_TABLE[index];
+    return getFolderPath() + "/" + sound.category + (sound.keyDown ? "/down/" : "/up/") + std::to_string(index);
+}
+
+std::size_t EmbeddedPack::getByteSize()
+{
+    return SAMPLE_BYTES;
+}
+
+bool EmbeddedPack::loadBuffer(const std::string &path, sf::SoundBuffer &buffer)
+{
+    if (!isAvailable() || !isEmbeddedPath(path)) {
+        return false;
+    }
+
+    // The index is the last path component
+    auto separator = path.find_last_of('/');
+    if (separator == std::string::npos || separator + 1 >= path.size()) {
+        return false;
+    }
+    char *end = nullptr;
+    unsigned long index = std::strtoul(path.c_str() + separator + 1, &end, 10);
+    if (*end != '\0' || index >= SOUND_COUNT) {
+        return false;
+    }
+
+    const EmbeddedSound &sound = SOUND_TABLE[index];
+    std::vector<sf::SoundChannel> channelMap =
+        sound.channels == 1 ? std::vector<sf::SoundChannel>{sf::SoundChannel::Mono}
+                            : std::vector<sf::SoundChannel>{sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight};
+    return buffer.loadFromSamples(sound.samples, sound.sampleCount, sound.channels, sound.sampleRate, channelMap);
+}
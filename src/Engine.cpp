@@ -0,0 +1,572 @@
+/**
+ * @file Engine.cpp
+ * @brief Implementation of the Engine class
+ */
+#include "Engine.h"
+#include "ClickSynth.h"
+#include "EmbeddedPack.h"
+#include "ProcessMemory.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "StreamInputSource.h"
+#include "EvdevInputSource.h"
+#include <filesystem>
+#include <stdexcept>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+Engine::Engine(const std::string &soundFolder, const AppConfig &config, std::chrono::steady_clock::time_point startTime)
+    : soundFolder_(soundFolder),
+      config_(config),
+      volume_(DEFAULT_VOLUME),
+      latencyOptimizationLevel_(DEFAULT_OPTIMIZATION),
+      startTime_(startTime),
+      lastSwitchPeakRssBytes_(0),
+      effectSettings_(config.audio.effects)
+{
+    // Publish live telemetry for external overlays when enabled
+    if (config_.telemetryEnabled)
+    {
+        telemetry_ = TelemetryRing::create(config_.telemetryName);
+        TelemetryRing::setGlobal(telemetry_.get());
+    }
+
+    soundManager_ = std::make_unique<SoundManager>(soundFolder);
+    soundPlayer_ = std::make_unique<SFMLSoundPlayer>(config.audio);
+
+    // Create the hook manager after we have the sound manager and player
+    hookManager_ = std::make_unique<KeyboardHookManager>(*soundManager_, *soundPlayer_);
+
+    // Set initial volume and idle behaviour
+    soundPlayer_->setVolume(volume_);
+    soundPlayer_->setIdleTimeout(config.idleTimeout);
+    soundPlayer_->setKeepDeviceWarm(config.keepDeviceWarm);
+
+    // Set initial optimization level
+    hookManager_->setLatencyOptimization(latencyOptimizationLevel_);
+    hookManager_->setOverloadPolicy(config.audio.overloadPolicy);
+}
+
+Engine::~Engine()
+{
+    // Stop serving control requests and pack reloads before tearing down what they touch
+    stopServices();
+
+    // Ensure hook is uninstalled when the engine is destroyed
+    if (hookManager_)
+    {
+        hookManager_->uninstallHook();
+    }
+
+    // Writers are stopped with the engine members; detach before the ring goes
+    TelemetryRing::setGlobal(nullptr);
+}
+
+void Engine::setChangeListener(ChangeListener listener)
+{
+    listener_ = std::move(listener);
+}
+
+void Engine::addStartupTasks(StartupOrchestrator &startup, bool installHook, const std::string &packName)
+{
+    using Affinity = StartupOrchestrator::Affinity;
+
+    // The hook goes in first and stays silent until a pack and the device are ready
+    if (installHook)
+    {
+        startup.addTask("install_hook", {}, Affinity::CALLER, [this]() {
+            return hookManager_->installHook();
+        });
+    }
+    startup.addTask("open_device", {}, Affinity::WORKER, [this]() {
+        return soundPlayer_->open();
+    });
+    startup.addTask("scan_packs", {}, Affinity::WORKER, [this]() {
+        return loadSoundPacks();
+    });
+    // A built-in pack needs no directory scan, so it loads alongside scan_packs
+    bool embedded = EmbeddedPack::isAvailable() && packName.empty();
+    std::vector<std::string> loadPackDependencies;
+    if (!embedded)
+    {
+        loadPackDependencies.push_back("scan_packs");
+    }
+    startup.addTask("load_pack", loadPackDependencies, Affinity::WORKER, [this, embedded, packName]() {
+        // Use the first sound pack by default
+        std::string folder = EmbeddedPack::getFolderPath();
+        if (!packName.empty())
+        {
+            if (findSoundPack(packName, folder) < 0)
+            {
+                KS_LOG_ERROR("Unknown sound pack: " << packName);
+                return false;
+            }
+        }
+        else if (!embedded)
+        {
+            std::lock_guard<std::mutex> lock(packsMutex_);
+            folder = soundPacks_[0];
+        }
+        soundManager_->setFolderPath(folder);
+        KS_LOG_INFO("Setting default sound pack: " << folder);
+        return soundManager_->loadSounds();
+    });
+    startup.addTask("decode_common", {"load_pack"}, Affinity::WORKER, [this]() {
+        hookManager_->preloadCommonSounds();
+        return true;
+    });
+    std::vector<std::string> inputDependencies;
+    if (installHook)
+    {
+        inputDependencies.push_back("install_hook");
+    }
+    startup.addTask("attach_inputs", inputDependencies, Affinity::CALLER, [this]() {
+        attachInputSources();
+        return true;
+    });
+}
+
+void Engine::finishStartup(const StartupOrchestrator &startup)
+{
+    // The first keystroke can sound once the input, the device and the pack are all in
+    std::chrono::microseconds firstPlayable(0);
+    for (const char *task : {"install_hook", "attach_inputs", "open_device", "load_pack"})
+    {
+        firstPlayable = std::max(firstPlayable, startup.getFinishOffset(task));
+    }
+    std::ostringstream report;
+    report << startup.formatReport() << "startup_first_playable_ms=" << firstPlayable.count() / 1000.0 << "\n";
+    startupReport_ = report.str();
+    KS_LOG_INFO("Time to first playable keystroke: " << firstPlayable.count() / 1000.0 << " ms");
+}
+
+void Engine::startServices()
+{
+    // Start the control endpoint once everything it drives is ready
+    if (!config_.controlEndpoint.empty() && !controlServer_)
+    {
+        controlServer_ = std::make_unique<ControlServer>(config_.controlEndpoint,
+            [this](const std::string &command, const std::string &argument) {
+                return handleControlCommand(command, argument);
+            });
+        if (!controlServer_->start())
+        {
+            controlServer_.reset();
+        }
+    }
+
+    // Pick up pack edits without a restart
+    if (config_.watchPacks && !packWatcher_)
+    {
+        packWatcher_ = std::make_unique<PackWatcher>(soundFolder_, config_.watchDebounce,
+            [this](const std::set<std::string> &paths) {
+                handlePackChanges(paths);
+            });
+        if (!packWatcher_->start())
+        {
+            packWatcher_.reset();
+        }
+    }
+}
+
+void Engine::stopServices()
+{
+    if (controlServer_)
+    {
+        controlServer_->stop();
+    }
+    if (packWatcher_)
+    {
+        packWatcher_->stop();
+    }
+}
+
+void Engine::attachInputSources()
+{
+    if (!config_.inputStream.empty())
+    {
+        StreamInputSource::Format format = StreamInputSource::Format::TEXT;
+        StreamInputSource::parseFormat(config_.inputStreamFormat, format);
+        hookManager_->addInputSource(std::make_unique<StreamInputSource>(config_.inputStream, format));
+    }
+
+#ifdef __linux__
+    if (config_.evdevInput)
+    {
+        hookManager_->addInputSource(std::make_unique<EvdevInputSource>());
+    }
+#endif
+}
+
+std::vector<std::string> Engine::getSoundPacks() const
+{
+    std::lock_guard<std::mutex> lock(packsMutex_);
+    return soundPacks_;
+}
+
+std::string Engine::getSoundPack(int index) const
+{
+    std::lock_guard<std::mutex> lock(packsMutex_);
+    if (index < 0 || index >= static_cast<int>(soundPacks_.size()))
+    {
+        return "";
+    }
+    return soundPacks_[index];
+}
+
+int Engine::getCurrentPackIndex() const
+{
+    std::string folder = soundManager_->getFolderPath();
+    std::lock_guard<std::mutex> lock(packsMutex_);
+    auto it = std::find(soundPacks_.begin(), soundPacks_.end(), folder);
+    return it != soundPacks_.end() ? static_cast<int>(it - soundPacks_.begin()) : -1;
+}
+
+int Engine::findSoundPack(const std::string &name, std::string &folder) const
+{
+    std::lock_guard<std::mutex> lock(packsMutex_);
+    for (size_t i = 0; i < soundPacks_.size(); ++i)
+    {
+        if (std::filesystem::path(soundPacks_[i]).filename().string() == name)
+        {
+            folder = soundPacks_[i];
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void Engine::handlePackChanges(const std::set<std::string> &paths)
+{
+    const char *categoryNames[] = {"alpha", "alt", "enter", "space", "other"};
+
+    // Pack folder -> touched categories; an empty name stands for the whole pack
+    std::map<std::string, std::set<std::string>> touched;
+    std::vector<std::string> files;
+    for (const auto &path : paths)
+    {
+        if (path.empty())
+        {
+            // Changes were lost: treat every pack folder as touched
+            std::error_code ec;
+            for (const auto &entry : std::filesystem::directory_iterator(soundFolder_, ec))
+            {
+                touched[entry.path().string()].insert("");
+            }
+            continue;
+        }
+
+        std::vector<std::string> parts;
+        std::stringstream stream(path);
+        for (std::string part; std::getline(stream, part, '/');)
+        {
+            parts.push_back(part);
+        }
+
+        // Built the same way as the paths produced by loadSoundPacks() and SoundManager
+        std::string folder = (std::filesystem::path(soundFolder_) / parts[0]).string();
+        touched[folder].insert(parts.size() >= 2 ? parts[1] : "");
+        if (parts.size() == 4)
+        {
+            files.push_back((std::filesystem::path(folder + "/" + parts[1] + "/" + parts[2]) / parts[3]).string());
+        }
+    }
+
+    // New pack folders join the list; existing ones are not rescanned
+    size_t added = 0;
+    for (const auto &[folder, categories] : touched)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(folder, ec))
+        {
+            continue;
+        }
+
+        int index = -1;
+        {
+            std::lock_guard<std::mutex> lock(packsMutex_);
+            if (std::find(soundPacks_.begin(), soundPacks_.end(), folder) == soundPacks_.end())
+            {
+                soundPacks_.push_back(folder);
+                index = static_cast<int>(soundPacks_.size() - 1);
+            }
+        }
+        if (index >= 0)
+        {
+            notify(Change::PACK_ADDED, index);
+            KS_LOG_INFO("Found new sound pack: " << folder);
+            ++added;
+        }
+    }
+
+    // Re-list only the touched categories of the pack in use
+    auto current = touched.find(soundManager_->getFolderPath());
+    if (current != touched.end())
+    {
+        std::vector<std::string> categories;
+        bool wholePack = current->second.count("") > 0;
+        for (const char *name : categoryNames)
+        {
+            if (wholePack || current->second.count(name) > 0)
+            {
+                categories.push_back(name);
+            }
+        }
+        if (!categories.empty())
+        {
+            soundManager_->refreshCategories(current->first, categories);
+        }
+    }
+
+    // Re-decode changed files that are cached; the rest decode on first use
+    size_t redecoded = 0;
+    for (const auto &file : files)
+    {
+        redecoded += soundPlayer_->refreshSound(file) ? 1 : 0;
+    }
+
+    KS_LOG_INFO("Applied " << paths.size() << " pack changes: " << added << " new packs, "
+                << redecoded << " sounds re-decoded");
+}
+
+std::string Engine::handleControlCommand(const std::string &command, const std::string &argument)
+{
+    // Parse an integer argument within a range or reject the request
+    auto parseLevel = [&argument](int minValue, int maxValue) {
+        try
+        {
+            size_t consumed = 0;
+            int value = std::stoi(argument, &consumed);
+            if (consumed == argument.size() && value >= minValue && value <= maxValue)
+            {
+                return value;
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        throw std::invalid_argument("expected a number between " + std::to_string(minValue) +
+                                    " and " + std::to_string(maxValue));
+    };
+
+    if (command == "pack")
+    {
+        std::string folder;
+        int index = findSoundPack(argument, folder);
+        if (index < 0)
+        {
+            throw std::invalid_argument("unknown pack '" + argument + "'");
+        }
+
+        // Scanned here and swapped atomically; the hook keeps playing the old pack meanwhile
+        if (!switchSoundPack(folder))
+        {
+            throw std::invalid_argument("failed to load pack '" + argument + "'");
+        }
+        notify(Change::PACK_SELECTED, index);
+        return "";
+    }
+
+    if (command == "volume")
+    {
+        int volume = parseLevel(0, 100);
+        setVolume(volume);
+        notify(Change::VOLUME, volume);
+        return "";
+    }
+
+    if (command == "profile")
+    {
+        // Hook settings are published as a snapshot, so any thread may change them
+        int level = parseLevel(0, 3);
+        setLatencyOptimization(level);
+        notify(Change::PROFILE, level);
+        return "";
+    }
+
+    if (command == "preload")
+    {
+        std::string folder;
+        int index = findSoundPack(argument, folder);
+        std::shared_ptr<SoundPack> pack = index >= 0 ? SoundManager::scanPack(folder) : nullptr;
+        if (!pack)
+        {
+            throw std::invalid_argument("unknown pack '" + argument + "'");
+        }
+
+        // One batched read of the whole pack, decoded on this thread
+        std::vector<std::string> paths;
+        for (const auto &[type, category] : pack->categories)
+        {
+            paths.insert(paths.end(), category.down.begin(), category.down.end());
+            paths.insert(paths.end(), category.up.begin(), category.up.end());
+        }
+        return "preloaded=" + std::to_string(soundPlayer_->preloadSounds(paths));
+    }
+
+    if (command == "effect")
+    {
+        // "<name> <value>" with the names of the effects.* configuration keys
+        auto separator = argument.find(' ');
+        BusEffectSettings settings = effectSettings_;
+        if (separator == std::string::npos ||
+            !settings.set(argument.substr(0, separator), argument.substr(separator + 1)))
+        {
+            throw std::invalid_argument("expected '<setting> <value>' with a valid effects setting");
+        }
+        if (!soundPlayer_->setEffects(settings))
+        {
+            throw std::invalid_argument("effects unavailable or impulse response not loaded");
+        }
+        effectSettings_ = settings;
+        return "";
+    }
+
+    if (command == "metrics")
+    {
+        return dumpMetrics();
+    }
+
+    if (command == "histograms")
+    {
+        return soundPlayer_->dumpLatencyHistograms();
+    }
+
+    if (command == "trace")
+    {
+        if (argument == "start")
+        {
+            Tracer::start();
+            return "";
+        }
+        if (argument.rfind("stop ", 0) == 0 && argument.size() > 5)
+        {
+            if (!Tracer::stop(argument.substr(5)))
+            {
+                throw std::invalid_argument("failed to write '" + argument.substr(5) + "'");
+            }
+            return "";
+        }
+        throw std::invalid_argument("expected 'start' or 'stop <file>'");
+    }
+
+    if (command == "help")
+    {
+        return "pack <name>\nvolume <0-100>\nprofile <0-3>\npreload <name>\neffect <setting> <value>\nmetrics\nhistograms\n"
+               "trace start\ntrace stop <file>";
+    }
+
+    throw std::invalid_argument("unknown command '" + command + "'");
+}
+
+std::string Engine::dumpMetrics() const
+{
+    std::ostringstream out;
+    out << "pack=" << std::filesystem::path(soundManager_->getFolderPath()).filename().string() << "\n"
+        << "profile=" << latencyOptimizationLevel_ << "\n"
+        << soundPlayer_->dumpMetrics()
+        << "resident_bytes=" << ProcessMemory::getResidentBytes() << "\n"
+        << "pack_switch_peak_rss_delta_bytes=" << lastSwitchPeakRssBytes_ << "\n"
+        << startupReport_;
+    return out.str();
+}
+
+bool Engine::loadSoundPacks()
+{
+    std::lock_guard<std::mutex> lock(packsMutex_);
+    soundPacks_.clear();
+
+    // The built-in pack needs no disk access and is listed first
+    if (EmbeddedPack::isAvailable())
+    {
+        soundPacks_.push_back(EmbeddedPack::getFolderPath());
+    }
+
+    try
+    {
+        // Validate sounds folder exists
+        if (std::filesystem::exists(soundFolder_))
+        {
+            // Find all subdirectories in the sounds folder
+            for (const auto &entry : std::filesystem::directory_iterator(soundFolder_))
+            {
+                if (entry.is_directory())
+                {
+                    soundPacks_.push_back(entry.path().string());
+                    KS_LOG_DEBUG("Found sound pack: " << entry.path().string());
+                }
+            }
+        }
+        else
+        {
+            KS_LOG_ERROR("Sounds folder does not exist: " << soundFolder_);
+        }
+    }
+    catch (const std::filesystem::filesystem_error &e)
+    {
+        KS_LOG_ERROR("Error scanning sound packs directory: " << e.what());
+    }
+
+    if (soundPacks_.empty())
+    {
+        KS_LOG_WARNING("No sound packs found in: " << soundFolder_ << ", using synthesized clicks");
+    }
+
+    // The synthesized pack is always available; it is the default only when nothing else is
+    soundPacks_.push_back(ClickSynth::getFolderPath());
+
+    KS_LOG_INFO("Loaded " << soundPacks_.size() << " sound packs");
+    return true;
+}
+
+bool Engine::switchSoundPack(const std::string &folder)
+{
+    ProcessMemory::resetPeak();
+    std::size_t before = ProcessMemory::getResidentBytes();
+
+    if (!soundManager_->switchPack(folder))
+    {
+        return false;
+    }
+    // Key-ups armed for held keys would still play the old pack
+    soundPlayer_->releaseArmedVoices();
+    hookManager_->preloadCommonSounds();
+
+    std::size_t peak = ProcessMemory::getPeakResidentBytes();
+    lastSwitchPeakRssBytes_ = peak > before ? peak - before : 0;
+    KS_LOG_INFO("Pack switch peak resident set growth: " << lastSwitchPeakRssBytes_ / 1024 << " KB");
+    return true;
+}
+
+void Engine::setVolume(int volume)
+{
+    // Clamp volume between 0 and 100
+    volume_ = (volume < 0) ? 0 : ((volume > 100) ? 100 : volume);
+    soundPlayer_->setVolume(volume_);
+}
+
+int Engine::getVolume() const
+{
+    return volume_;
+}
+
+void Engine::setLatencyOptimization(int level)
+{
+    // Clamp level between 0 and 3
+    latencyOptimizationLevel_ = (level < 0) ? 0 : ((level > 3) ? 3 : level);
+    hookManager_->setLatencyOptimization(latencyOptimizationLevel_);
+}
+
+int Engine::getLatencyOptimization() const
+{
+    return latencyOptimizationLevel_;
+}
+
+void Engine::notify(Change change, int value)
+{
+    if (listener_)
+    {
+        listener_(change, value);
+    }
+}
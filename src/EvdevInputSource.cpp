@@ -0,0 +1,439 @@
+/**
+ * @file EvdevInputSource.cpp
+ * @brief Implementation of the EvdevInputSource class
+ */
+#ifdef __linux__
+
+#include "EvdevInputSource.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+static_assert(sizeof(input_event) <= 32, "Device::partial must hold one input_event");
+
+namespace {
+
+constexpr int MAX_EPOLL_EVENTS = 16;
+constexpr std::size_t READ_BATCH = 64;
+
+bool testBit(const unsigned long *bits, unsigned int bit)
+{
+    constexpr unsigned int BITS_PER_LONG = sizeof(unsigned long) * 8;
+    return (bits[bit / BITS_PER_LONG] >> (bit % BITS_PER_LONG)) & 1UL;
+}
+
+/**
+ * @brief Convert a CLOCK_MONOTONIC kernel event time to a steady_clock time point
+ */
+std::chrono::steady_clock::time_point eventTime(const input_event &ev)
+{
+    auto sinceEpoch = std::chrono::seconds(ev.input_event_sec) + std::chrono::microseconds(ev.input_event_usec);
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(sinceEpoch));
+}
+
+bool isEventNode(const std::string &name)
+{
+    return name.rfind("event", 0) == 0;
+}
+
+/**
+ * @brief Kernel KEY_* code to virtual-key code table
+ */
+const std::array<std::uint16_t, KEY_MAX + 1> &keyTable()
+{
+    static const std::array<std::uint16_t, KEY_MAX + 1> table = []() {
+        std::array<std::uint16_t, KEY_MAX + 1> t{};
+
+        const char *rows[] = {"QWERTYUIOP", "ASDFGHJKL", "ZXCVBNM"};
+        const int rowStart[] = {KEY_Q, KEY_A, KEY_Z};
+        for (int row = 0; row < 3; ++row) {
+            for (int i = 0; rows[row][i] != '\0'; ++i) {
+                t[rowStart[row] + i] = static_cast<std::uint16_t>(rows[row][i]);
+            }
+        }
+        for (int i = 0; i < 9; ++i) {
+            t[KEY_1 + i] = static_cast<std::uint16_t>('1' + i);
+        }
+        t[KEY_0] = '0';
+        for (int i = 0; i < 10; ++i) {
+            t[KEY_F1 + i] = static_cast<std::uint16_t>(0x70 + i); // VK_F1..VK_F10
+        }
+        t[KEY_F11] = 0x7A;
+        t[KEY_F12] = 0x7B;
+
+        t[KEY_ESC] = 0x1B;        // VK_ESCAPE
+        t[KEY_BACKSPACE] = 0x08;  // VK_BACK
+        t[KEY_TAB] = 0x09;        // VK_TAB
+        t[KEY_ENTER] = 0x0D;      // VK_RETURN
+        t[KEY_KPENTER] = 0x0D;
+        t[KEY_SPACE] = 0x20;      // VK_SPACE
+        t[KEY_CAPSLOCK] = 0x14;   // VK_CAPITAL
+        t[KEY_LEFTSHIFT] = 0xA0;  // VK_LSHIFT
+        t[KEY_RIGHTSHIFT] = 0xA1; // VK_RSHIFT
+        t[KEY_LEFTCTRL] = 0xA2;   // VK_LCONTROL
+        t[KEY_RIGHTCTRL] = 0xA3;  // VK_RCONTROL
+        t[KEY_LEFTALT] = 0x12;    // VK_MENU, the code the ALT category is mapped to
+        t[KEY_RIGHTALT] = 0x12;
+        t[KEY_LEFTMETA] = 0x5B;   // VK_LWIN
+        t[KEY_RIGHTMETA] = 0x5C;  // VK_RWIN
+        t[KEY_COMPOSE] = 0x5D;    // VK_APPS
+
+        t[KEY_MINUS] = 0xBD;      // VK_OEM_MINUS
+        t[KEY_EQUAL] = 0xBB;      // VK_OEM_PLUS
+        t[KEY_LEFTBRACE] = 0xDB;  // VK_OEM_4
+        t[KEY_RIGHTBRACE] = 0xDD; // VK_OEM_6
+        t[KEY_SEMICOLON] = 0xBA;  // VK_OEM_1
+        t[KEY_APOSTROPHE] = 0xDE; // VK_OEM_7
+        t[KEY_GRAVE] = 0xC0;      // VK_OEM_3
+        t[KEY_BACKSLASH] = 0xDC;  // VK_OEM_5
+        t[KEY_COMMA] = 0xBC;      // VK_OEM_COMMA
+        t[KEY_DOT] = 0xBE;        // VK_OEM_PERIOD
+        t[KEY_SLASH] = 0xBF;      // VK_OEM_2
+        t[KEY_102ND] = 0xE2;      // VK_OEM_102
+
+        t[KEY_HOME] = 0x24;
+        t[KEY_END] = 0x23;
+        t[KEY_PAGEUP] = 0x21;
+        t[KEY_PAGEDOWN] = 0x22;
+        t[KEY_INSERT] = 0x2D;
+        t[KEY_DELETE] = 0x2E;
+        t[KEY_LEFT] = 0x25;
+        t[KEY_UP] = 0x26;
+        t[KEY_RIGHT] = 0x27;
+        t[KEY_DOWN] = 0x28;
+        t[KEY_SYSRQ] = 0x2C;      // VK_SNAPSHOT
+        t[KEY_PAUSE] = 0x13;
+        t[KEY_NUMLOCK] = 0x90;
+        t[KEY_SCROLLLOCK] = 0x91;
+
+        const int keypadDigits[] = {KEY_KP0, KEY_KP1, KEY_KP2, KEY_KP3, KEY_KP4,
+                                    KEY_KP5, KEY_KP6, KEY_KP7, KEY_KP8, KEY_KP9};
+        for (int i = 0; i < 10; ++i) {
+            t[keypadDigits[i]] = static_cast<std::uint16_t>(0x60 + i); // VK_NUMPAD0..9
+        }
+        t[KEY_KPASTERISK] = 0x6A;
+        t[KEY_KPPLUS] = 0x6B;
+        t[KEY_KPMINUS] = 0x6D;
+        t[KEY_KPDOT] = 0x6E;
+        t[KEY_KPSLASH] = 0x6F;
+        return t;
+    }();
+    return table;
+}
+
+} // namespace
+
+EvdevInputSource::EvdevInputSource(const std::string &inputDir)
+    : inputDir_(inputDir),
+      epollFd_(-1),
+      inotifyFd_(-1),
+      wakeFd_(-1),
+      running_(false)
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        KS_LOG_ERROR("Failed to create evdev event loop: " << std::strerror(errno));
+        return;
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+}
+
+EvdevInputSource::~EvdevInputSource()
+{
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        for (auto &[fd, device] : devices_) {
+            close(fd);
+        }
+        devices_.clear();
+    }
+
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+}
+
+bool EvdevInputSource::start(EventCallback callback)
+{
+    if (epollFd_ < 0 || running_) {
+        return false;
+    }
+
+    callback_ = std::move(callback);
+
+    // Watch the input directory for hotplugged keyboards; udev applies
+    // permissions after creating the node, hence IN_ATTRIB
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ >= 0 && inotify_add_watch(inotifyFd_, inputDir_.c_str(), IN_CREATE | IN_ATTRIB) >= 0) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = inotifyFd_;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, inotifyFd_, &ev);
+    } else {
+        KS_LOG_WARNING("Hotplug disabled, cannot watch " << inputDir_ << ": " << std::strerror(errno));
+    }
+
+    // Open the keyboards that are already present
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(inputDir_, ec)) {
+        if (isEventNode(entry.path().filename().string())) {
+            openDeviceIfKeyboard(entry.path().string());
+        }
+    }
+
+    KS_LOG_INFO("evdev input watching " << getDeviceCount() << " keyboard device(s)");
+
+    running_ = true;
+    thread_ = std::thread(&EvdevInputSource::eventLoop, this);
+    return true;
+}
+
+void EvdevInputSource::stop()
+{
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    std::uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::string EvdevInputSource::getName() const
+{
+    return "evdev";
+}
+
+bool EvdevInputSource::addDevice(int fd, const std::string &name)
+{
+    if (fd < 0 || epollFd_ < 0) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        Device &device = devices_[fd];
+        device.name = name;
+        device.partialSize = 0;
+        device.monotonicClock = false;
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        KS_LOG_ERROR("Failed to watch input device " << name << ": " << std::strerror(errno));
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        devices_.erase(fd);
+        close(fd);
+        return false;
+    }
+
+    return true;
+}
+
+std::size_t EvdevInputSource::getDeviceCount() const
+{
+    std::lock_guard<std::mutex> lock(devicesMutex_);
+    return devices_.size();
+}
+
+std::uint16_t EvdevInputSource::translateKeyCode(std::uint16_t code)
+{
+    return code <= KEY_MAX ? keyTable()[code] : 0;
+}
+
+void EvdevInputSource::openDeviceIfKeyboard(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        for (const auto &[fd, device] : devices_) {
+            if (device.path == path) {
+                return; // Already watched (IN_ATTRIB follows IN_CREATE)
+            }
+        }
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return; // Not readable (yet); a later IN_ATTRIB retries
+    }
+
+    // A keyboard reports EV_KEY with at least the letter row and space
+    unsigned long evBits[(EV_MAX + 1 + sizeof(unsigned long) * 8 - 1) / (sizeof(unsigned long) * 8)] = {};
+    unsigned long keyBits[(KEY_MAX + 1 + sizeof(unsigned long) * 8 - 1) / (sizeof(unsigned long) * 8)] = {};
+    bool isKeyboard = ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) >= 0 && testBit(evBits, EV_KEY) &&
+                      ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) >= 0 &&
+                      testBit(keyBits, KEY_A) && testBit(keyBits, KEY_Z) && testBit(keyBits, KEY_SPACE);
+    if (!isKeyboard) {
+        close(fd);
+        return;
+    }
+
+    char name[256] = "unknown";
+    ioctl(fd, EVIOCGNAME(sizeof(name)), name);
+
+    // Kernel timestamps default to CLOCK_REALTIME; ask for the clock steady_clock reads
+    int clockId = CLOCK_MONOTONIC;
+    bool monotonic = ioctl(fd, EVIOCSCLOCKID, &clockId) >= 0;
+
+    if (addDevice(fd, name)) {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        devices_[fd].path = path;
+        devices_[fd].monotonicClock = monotonic;
+        KS_LOG_INFO("Keyboard attached: " << name << " (" << path << ")");
+    }
+}
+
+void EvdevInputSource::removeDevice(int fd)
+{
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+
+    std::lock_guard<std::mutex> lock(devicesMutex_);
+    auto it = devices_.find(fd);
+    if (it != devices_.end()) {
+        KS_LOG_INFO("Keyboard detached: " << it->second.name);
+        devices_.erase(it);
+    }
+    close(fd);
+}
+
+void EvdevInputSource::eventLoop()
+{
+    Tracer::setThreadName("evdev-input");
+    epoll_event events[MAX_EPOLL_EVENTS];
+
+    while (running_) {
+        int count = epoll_wait(epollFd_, events, MAX_EPOLL_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            KS_LOG_ERROR("evdev epoll_wait failed: " << std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd_) {
+                continue; // stop() requested
+            }
+            if (fd == inotifyFd_) {
+                handleHotplug();
+                continue;
+            }
+            if (!readDevice(fd)) {
+                removeDevice(fd);
+            }
+        }
+    }
+}
+
+bool EvdevInputSource::readDevice(int fd)
+{
+    Device *device = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        auto it = devices_.find(fd);
+        if (it == devices_.end()) {
+            return false;
+        }
+        device = &it->second;
+    }
+
+    unsigned char buffer[READ_BATCH * sizeof(input_event)];
+
+    for (;;) {
+        // Restore any record split by the previous read
+        std::size_t offset = device->partialSize;
+        std::memcpy(buffer, device->partial, offset);
+
+        ssize_t bytes = read(fd, buffer + offset, sizeof(buffer) - offset);
+        if (bytes < 0) {
+            return errno == EAGAIN || errno == EINTR; // ENODEV: unplugged
+        }
+        if (bytes == 0) {
+            return false; // Writer closed (pipe or socket)
+        }
+
+        std::size_t available = offset + static_cast<std::size_t>(bytes);
+        std::size_t records = available / sizeof(input_event);
+
+        // Pipes and sockets (tests) carry no usable kernel time; stamp them on arrival
+        auto now = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < records; ++i) {
+            input_event ev;
+            std::memcpy(&ev, buffer + i * sizeof(input_event), sizeof(ev));
+
+            // value 2 is kernel autorepeat; the hook manager ignores repeats anyway
+            if (ev.type != EV_KEY || ev.value == 2) {
+                continue;
+            }
+
+            KeyEvent keyEvent;
+            keyEvent.keyCode = translateKeyCode(ev.code);
+            if (keyEvent.keyCode == 0) {
+                continue;
+            }
+            keyEvent.keyDown = ev.value != 0;
+            keyEvent.timestamp = device->monotonicClock ? eventTime(ev) : now;
+            callback_(keyEvent);
+        }
+
+        device->partialSize = available - records * sizeof(input_event);
+        std::memcpy(device->partial, buffer + records * sizeof(input_event), device->partialSize);
+
+        if (static_cast<std::size_t>(bytes) < sizeof(buffer) - offset) {
+            return true; // Drained
+        }
+    }
+}
+
+void EvdevInputSource::handleHotplug()
+{
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+        ssize_t bytes = read(inotifyFd_, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+            return;
+        }
+
+        for (ssize_t offset = 0; offset < bytes;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            if (event->len > 0 && isEventNode(event->name)) {
+                openDeviceIfKeyboard(inputDir_ + "/" + event->name);
+            }
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,57 @@
+/**
+ * @file KeyPredictor.cpp
+ * @brief Implementation of the KeyPredictor class
+ */
+#include "KeyPredictor.h"
+
+void KeyPredictor::observe(std::uint16_t keyCode, int level, std::vector<std::uint16_t> &predicted)
+{
+    predicted.clear();
+
+    // Adjust the learned state when the optimization level changed
+    if (level != level_)
+    {
+        if (level == 0)
+        {
+            // Minimum optimization: no predictions, forget what was learned
+            clear();
+        }
+        level_ = level;
+    }
+    if (level == 0)
+    {
+        return;
+    }
+
+    // Update predictive cache - learn key sequences
+    if (!recentKeys_.empty())
+    {
+        std::uint16_t previousKey = recentKeys_.back();
+        keyFollowers_[previousKey].insert(keyCode);
+
+        // Keys that often follow the current key; how many depends on the level
+        auto it = keyFollowers_.find(keyCode);
+        if (it != keyFollowers_.end())
+        {
+            for (std::uint16_t nextKey : it->second)
+            {
+                if (predicted.size() >= static_cast<std::size_t>(level)) break;
+                predicted.push_back(nextKey);
+            }
+        }
+    }
+
+    // Add to recent keys; low optimization keeps a shorter history
+    std::size_t historyLength = level == 1 ? 3 : KEY_HISTORY_LENGTH;
+    recentKeys_.push_back(keyCode);
+    while (recentKeys_.size() > historyLength)
+    {
+        recentKeys_.pop_front();
+    }
+}
+
+void KeyPredictor::clear()
+{
+    keyFollowers_.clear();
+    recentKeys_.clear();
+}
@@ -0,0 +1,52 @@
+/**
+ * @file KeyThrottle.cpp
+ * @brief Implementation of the KeyThrottle class
+ */
+#include "KeyThrottle.h"
+
+KeyThrottle::KeyThrottle()
+    : dropped_(0)
+{
+    for (auto &time : lastKeyDown_) {
+        time.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool KeyThrottle::allowKeyDown(std::uint16_t keyCode, Clock::time_point now, OverloadPolicy policy)
+{
+    if (keyCode >= KEY_CODE_COUNT) {
+        return true;
+    }
+
+    // The press time is tracked under both policies so switching is seamless
+    Clock::rep last = lastKeyDown_[keyCode].exchange(now.time_since_epoch().count(), std::memory_order_relaxed);
+    bool tooSoon = last != 0 && now - Clock::time_point(Clock::duration(last)) < REPEAT_INTERVAL;
+
+    if (tooSoon && policy == OverloadPolicy::DROP) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool KeyThrottle::allowKeyUp(std::uint16_t keyCode, Clock::time_point now, OverloadPolicy policy)
+{
+    if (keyCode >= KEY_CODE_COUNT) {
+        return true;
+    }
+
+    // A very short hold means very fast typing; DROP keeps the down sound and skips the up sound
+    Clock::rep last = lastKeyDown_[keyCode].load(std::memory_order_relaxed);
+    bool tooShort = last != 0 && now - Clock::time_point(Clock::duration(last)) < MIN_HOLD;
+
+    if (tooShort && policy == OverloadPolicy::DROP) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t KeyThrottle::getDroppedCount() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
@@ -3,9 +3,11 @@
  * @brief Implementation of the KeyboardHookManager class
  */
 #include "KeyboardHookManager.h"
+#include "Logger.h"
+#include "Tracer.h"
 #include "SoundManager.h"
 #include "SFMLSoundPlayer.h"
-#include <iostream>
+#include "TelemetryRing.h"
 #include <unordered_set>
 #include <chrono>
 #include <unordered_map>
@@ -16,128 +18,204 @@
 
 // Initialize static members
 KeyboardHookManager *KeyboardHookManager::instance_ = nullptr;
-std::unordered_set<WORD> KeyboardHookManager::pressedKeys_;
 
-// For fast typing - keep track of key timings
-static std::unordered_map<WORD, std::chrono::steady_clock::time_point> keyTimestamps;
-static constexpr auto KEY_PROCESSING_INTERVAL = std::chrono::milliseconds(25); // Reduced from 40ms for lower latency
-
-// Predictive cache - keep track of common key sequences to prefetch sounds
-static std::deque<WORD> recentKeys;
-static constexpr size_t KEY_HISTORY_LENGTH = 5;
-static std::unordered_map<WORD, std::unordered_set<WORD>> keyFollowers;
+// A lost wakeup only delays learning, so the hook path never takes the wake mutex
+static constexpr auto LEARN_POLL_INTERVAL = std::chrono::milliseconds(100);
 
 KeyboardHookManager::KeyboardHookManager(SoundManager &soundManager, SFMLSoundPlayer &soundPlayer)
     : soundManager_(soundManager),
       soundPlayer_(soundPlayer),
+#ifdef _WIN32
       hook_(nullptr),
-      keyFilteringEnabled_(false),
-      latencyOptimizationLevel_(2) // Default to medium optimization
+      foregroundHook_(nullptr),
+#endif
+      settings_(nullptr),
+      settingsReaders_(0),
+      currentSettings_(std::make_unique<HookSettings>()), // Defaults to medium optimization
+      learnWriteIndex_(0),
+      learnPending_(false),
+      learnRunning_(true),
+      learnCursor_(0)
 {
+    settings_.store(currentSettings_.get(), std::memory_order_seq_cst);
+    for (auto &pressed : pressedKeys_)
+    {
+        pressed.store(false, std::memory_order_relaxed);
+    }
+
     // Set the singleton instance for the hook callback
     if (instance_ != nullptr)
     {
-        std::cerr << "Warning: Multiple KeyboardHookManager instances created." << std::endl;
+        KS_LOG_WARNING("Multiple KeyboardHookManager instances created.");
     }
     instance_ = this;
-    
-    // Preload common keys in advance
-    preloadCommonSounds();
+
+    learnThread_ = std::thread(&KeyboardHookManager::learnLoop, this);
+}
+
+KeyboardHookManager::SettingsReader::SettingsReader(KeyboardHookManager &manager)
+    : readers_(manager.settingsReaders_)
+{
+    // Announce the reader before loading, so an updater that misses it cannot free what we load
+    readers_.fetch_add(1, std::memory_order_seq_cst);
+    settings_ = manager.settings_.load(std::memory_order_seq_cst);
+}
+
+KeyboardHookManager::SettingsReader::~SettingsReader()
+{
+    readers_.fetch_sub(1, std::memory_order_release);
+}
+
+void KeyboardHookManager::updateSettings(const std::function<void(HookSettings &)> &edit)
+{
+    std::lock_guard<ProfiledMutex> lock(settingsMutex_);
+
+    auto next = std::make_unique<HookSettings>(*currentSettings_);
+    edit(*next);
+    retiredSettings_.push_back(std::move(currentSettings_));
+    currentSettings_ = std::move(next);
+    settings_.store(currentSettings_.get(), std::memory_order_seq_cst);
+
+    // Readers arriving from now on see the new snapshot; with none active, nobody holds an old one
+    if (settingsReaders_.load(std::memory_order_seq_cst) == 0)
+    {
+        retiredSettings_.clear();
+    }
 }
 
 void KeyboardHookManager::preloadCommonSounds()
 {
     // Preload sounds for common keys with high priority
-    const std::vector<WORD> commonKeys = {
+    const std::vector<std::uint16_t> commonKeys = {
         'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
         'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
         '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
-        VK_SPACE, VK_RETURN, VK_BACK, VK_TAB, VK_LSHIFT, VK_RSHIFT,
-        VK_LCONTROL, VK_RCONTROL, VK_ESCAPE, VK_CAPITAL
+        0x20, 0x0D, 0x08, 0x09, // VK_SPACE, VK_RETURN, VK_BACK, VK_TAB
+        0xA0, 0xA1, 0xA2, 0xA3, // VK_LSHIFT, VK_RSHIFT, VK_LCONTROL, VK_RCONTROL
+        0x1B, 0x14              // VK_ESCAPE, VK_CAPITAL
     };
     
-    // Preload by making requests to the sound manager and explicitly preloading
-    for (WORD key : commonKeys)
+    // Pick the sounds through the sound manager, then read and decode them as one batch
+    std::vector<std::string> sounds;
+    for (std::uint16_t key : commonKeys)
     {
-        std::string downSound = soundManager_.getRandomSoundForKey(key, true);
-        std::string upSound = soundManager_.getRandomSoundForKey(key, false);
-        
-        if (!downSound.empty())
-        {
-            soundPlayer_.preloadSound(downSound, true); // High priority preload
-        }
-        
-        if (!upSound.empty())
-        {
-            soundPlayer_.preloadSound(upSound, true); // High priority preload
-        }
+        sounds.push_back(soundManager_.getRandomSoundForKey(key, true));
+        sounds.push_back(soundManager_.getRandomSoundForKey(key, false));
     }
+    soundPlayer_.preloadSounds(sounds);
 }
 
 void KeyboardHookManager::setLatencyOptimization(int level)
 {
-    // Clamp level to valid range (0-3)
-    latencyOptimizationLevel_ = std::clamp(level, 0, 3);
-    
-    // Adjust behavior based on optimization level
-    switch (latencyOptimizationLevel_) {
-        case 0: // Minimum optimization
-            // Don't preload predicted keys, use longer processing intervals
-            keyFollowers.clear();
-            recentKeys.clear();
+    // Clamp level to valid range (0-3); the input worker adapts its learned state on its next key
+    level = std::clamp(level, 0, 3);
+    updateSettings([level](HookSettings &settings) { settings.latencyOptimizationLevel = level; });
+
+    if (level == 3)
+    {
+        // Maximum optimization: preload the most common keys again with high priority
+        preloadCommonSounds();
+    }
+}
+
+void KeyboardHookManager::setOverloadPolicy(OverloadPolicy policy)
+{
+    updateSettings([policy](HookSettings &settings) { settings.overloadPolicy = policy; });
+}
+
+void KeyboardHookManager::postKeyToLearn(std::uint16_t vkCode)
+{
+    std::uint64_t index = learnWriteIndex_.fetch_add(1, std::memory_order_relaxed);
+    LearnSlot &slot = learnSlots_[index & (LEARN_CAPACITY - 1)];
+
+    // Odd sequence marks the slot as being written
+    slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.keyCode.store(vkCode, std::memory_order_relaxed);
+    slot.sequence.store(index * 2 + 2, std::memory_order_release);
+
+    // Only the first key after the worker went idle pays for a wakeup
+    if (!learnPending_.exchange(true, std::memory_order_acq_rel))
+    {
+        learnWakeCv_.notify_one();
+    }
+}
+
+void KeyboardHookManager::learnLoop()
+{
+    std::unique_lock<std::mutex> lock(learnWakeMutex_);
+    while (learnRunning_.load(std::memory_order_acquire))
+    {
+        learnWakeCv_.wait_for(lock, LEARN_POLL_INTERVAL, [this] {
+            return !learnRunning_.load(std::memory_order_acquire) || learnPending_.load(std::memory_order_acquire);
+        });
+        if (!learnRunning_.load(std::memory_order_acquire))
+        {
             break;
-            
-        case 1: // Low optimization
-            // Keep shorter history for predictions
-            while (recentKeys.size() > 3) {
-                recentKeys.pop_front();
+        }
+
+        learnPending_.store(false, std::memory_order_release);
+        lock.unlock();
+
+        std::uint64_t head = learnWriteIndex_.load(std::memory_order_acquire);
+
+        // Skip what the hook path has already lapped; predictions only need recent keys
+        if (head > LEARN_CAPACITY && learnCursor_ < head - LEARN_CAPACITY)
+        {
+            learnCursor_ = head - LEARN_CAPACITY;
+        }
+
+        SettingsReader settings(*this);
+        while (learnCursor_ < head)
+        {
+            const LearnSlot &slot = learnSlots_[learnCursor_ & (LEARN_CAPACITY - 1)];
+            const std::uint64_t expected = learnCursor_ * 2 + 2;
+
+            std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before < expected)
+            {
+                // Claimed but not yet published; pick it up on the next round
+                learnPending_.store(true, std::memory_order_release);
+                break;
             }
-            break;
-            
-        case 2: // Medium optimization (default)
-            // Default settings are fine
-            break;
-            
-        case 3: // Maximum optimization
-            // Prefetch more aggressively
-            // Preload the most common keys again with high priority
-            preloadCommonSounds();
-            break;
+            std::uint16_t vkCode = slot.keyCode.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (before == expected && slot.sequence.load(std::memory_order_relaxed) == before)
+            {
+                learnKey(vkCode, settings->latencyOptimizationLevel);
+            }
+            ++learnCursor_;
+        }
+
+        lock.lock();
     }
 }
 
-void KeyboardHookManager::preloadPredictedKeys(WORD baseKey)
+void KeyboardHookManager::learnKey(std::uint16_t vkCode, int level)
 {
-    // Skip if optimization level is too low
-    if (latencyOptimizationLevel_ < 1) {
-        return;
+    predictor_.observe(vkCode, level, predictedKeys_);
+    if (!predictedKeys_.empty())
+    {
+        // Preload sounds for keys that often follow the current key
+        preloadPredictedKeys(predictedKeys_, level);
     }
-    
-    // Preload the next likely keys based on learning history
-    auto it = keyFollowers.find(baseKey);
-    if (it != keyFollowers.end()) {
-        // Number of keys to preload depends on optimization level
-        size_t keysToPreload = latencyOptimizationLevel_;
+}
+
+void KeyboardHookManager::preloadPredictedKeys(const std::vector<std::uint16_t> &keys, int level)
+{
+    // Preload with priority based on optimization level
+    bool highPriority = (level >= 3);
+
+    for (std::uint16_t nextKey : keys) {
+        std::string nextDownSound = soundManager_.getRandomSoundForKey(nextKey, true);
+        std::string nextUpSound = soundManager_.getRandomSoundForKey(nextKey, false);
         
-        size_t count = 0;
-        for (WORD nextKey : it->second) {
-            if (count >= keysToPreload) break;
-            
-            // Preload with priority based on optimization level
-            bool highPriority = (latencyOptimizationLevel_ >= 3);
-            
-            std::string nextDownSound = soundManager_.getRandomSoundForKey(nextKey, true);
-            std::string nextUpSound = soundManager_.getRandomSoundForKey(nextKey, false);
-            
-            if (!nextDownSound.empty()) {
-                soundPlayer_.preloadSound(nextDownSound, highPriority);
-            }
-            
-            if (!nextUpSound.empty()) {
-                soundPlayer_.preloadSound(nextUpSound, highPriority);
-            }
-            
-            count++;
+        if (!nextDownSound.empty()) {
+            soundPlayer_.preloadSound(nextDownSound, highPriority);
+        }
+        
+        if (!nextUpSound.empty()) {
+            soundPlayer_.preloadSound(nextUpSound, highPriority);
         }
     }
 }
@@ -146,6 +224,17 @@ KeyboardHookManager::~KeyboardHookManager()
 {
     uninstallHook();
 
+    // No source dispatches any more, so the worker can go
+    {
+        std::lock_guard<std::mutex> lock(learnWakeMutex_);
+        learnRunning_.store(false, std::memory_order_release);
+    }
+    learnWakeCv_.notify_one();
+    if (learnThread_.joinable())
+    {
+        learnThread_.join();
+    }
+
     // Only clear the singleton if this instance is the current one
     if (instance_ == this)
     {
@@ -155,10 +244,12 @@ KeyboardHookManager::~KeyboardHookManager()
 
 bool KeyboardHookManager::installHook()
 {
-    // If a hook is already installed, uninstall it first
+#ifdef _WIN32
+    // If a hook is already installed, remove it first (attached sources keep running)
     if (hook_ != nullptr)
     {
-        uninstallHook();
+        UnhookWindowsHookEx(hook_);
+        hook_ = nullptr;
     }
 
     // Install the low-level keyboard hook
@@ -166,89 +257,156 @@ bool KeyboardHookManager::installHook()
     if (hook_ == nullptr)
     {
         DWORD error = GetLastError();
-        std::cerr << "Failed to install keyboard hook. Error code: " << error << std::endl;
+        KS_LOG_ERROR("Failed to install keyboard hook. Error code: " << error);
         return false;
     }
 
+    // Watch foreground changes: keys held across them may never be released to us
+    if (foregroundHook_ == nullptr)
+    {
+        foregroundHook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                          ForegroundChangedProc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        if (foregroundHook_ == nullptr)
+        {
+            KS_LOG_WARNING("Failed to watch foreground changes; armed key-up voices are only released on key up");
+        }
+    }
+
     return true;
+#else
+    KS_LOG_ERROR("No global keyboard hook on this platform; attach an input source instead");
+    return false;
+#endif
 }
 
 void KeyboardHookManager::uninstallHook()
 {
+    // Stop the other sources first so nothing dispatches while we clear state
+    for (auto &source : inputSources_)
+    {
+        source->stop();
+    }
+    inputSources_.clear();
+
+#ifdef _WIN32
     if (hook_ != nullptr)
     {
         UnhookWindowsHookEx(hook_);
         hook_ = nullptr;
+    }
 
-        // Clear the pressed keys set
-        pressedKeys_.clear();
+    if (foregroundHook_ != nullptr)
+    {
+        UnhookWinEvent(foregroundHook_);
+        foregroundHook_ = nullptr;
+    }
+#endif
+
+    // Clear the pressed keys and the voices armed for them
+    for (auto &pressed : pressedKeys_)
+    {
+        pressed.store(false, std::memory_order_relaxed);
+    }
+    soundPlayer_.releaseArmedVoices();
+}
+
+bool KeyboardHookManager::addInputSource(std::unique_ptr<InputSource> source)
+{
+    if (!source)
+    {
+        return false;
+    }
+
+    if (!source->start([this](const KeyEvent &event) { dispatchKeyEvent(event); }))
+    {
+        KS_LOG_ERROR("Failed to start input source: " << source->getName());
+        return false;
+    }
+
+    KS_LOG_DEBUG("Input source started: " << source->getName());
+    inputSources_.push_back(std::move(source));
+    return true;
+}
+
+void KeyboardHookManager::dispatchKeyEvent(const KeyEvent &event)
+{
+    TraceSpan span("dispatch_key", "vk", event.keyCode);
+
+    // Virtual-key codes are one byte; anything else has no sound
+    if (event.keyCode >= KEY_CODE_COUNT)
+    {
+        return;
+    }
+
+    // Check if we should process this key
+    SettingsReader settings(*this);
+    if (!shouldProcessKey(event.keyCode, *settings))
+    {
+        return;
+    }
+
+    // Ignore injected keystrokes which might be from other software
+    if (event.injected)
+    {
+        return;
+    }
+
+    if (event.keyDown)
+    {
+        // If the key is already pressed (key repeat), ignore this event
+        if (!pressedKeys_[event.keyCode].exchange(true, std::memory_order_relaxed))
+        {
+            TelemetryRing::publish(TelemetryType::KEY_EVENT, event.keyCode, 0.0f, 1);
+            handleKeyDown(event.keyCode, event.timestamp, *settings);
+        }
+    }
+    else
+    {
+        // Mark the key released and handle key up event
+        pressedKeys_[event.keyCode].store(false, std::memory_order_relaxed);
+        TelemetryRing::publish(TelemetryType::KEY_EVENT, event.keyCode, 0.0f, 0);
+        handleKeyUp(event.keyCode, event.timestamp, *settings);
     }
 }
 
 void KeyboardHookManager::setKeyFilteringEnabled(bool enabled)
 {
-    keyFilteringEnabled_ = enabled;
+    updateSettings([enabled](HookSettings &settings) { settings.keyFilteringEnabled = enabled; });
 }
 
-void KeyboardHookManager::addKeyToFilter(WORD vkCode)
+void KeyboardHookManager::addKeyToFilter(std::uint16_t vkCode)
 {
-    filteredKeys_.insert(vkCode);
+    if (vkCode < KEY_CODE_COUNT)
+    {
+        updateSettings([vkCode](HookSettings &settings) { settings.filteredKeys.set(vkCode); });
+    }
 }
 
-void KeyboardHookManager::removeKeyFromFilter(WORD vkCode)
+void KeyboardHookManager::removeKeyFromFilter(std::uint16_t vkCode)
 {
-    filteredKeys_.erase(vkCode);
+    if (vkCode < KEY_CODE_COUNT)
+    {
+        updateSettings([vkCode](HookSettings &settings) { settings.filteredKeys.reset(vkCode); });
+    }
 }
 
-bool KeyboardHookManager::shouldProcessKey(WORD vkCode) const
+bool KeyboardHookManager::shouldProcessKey(std::uint16_t vkCode, const HookSettings &settings)
 {
     // If filtering is disabled, process all keys
-    if (!keyFilteringEnabled_)
+    if (!settings.keyFilteringEnabled)
     {
         return true;
     }
 
     // If the key is in the filter list, don't process it
-    return filteredKeys_.find(vkCode) == filteredKeys_.end();
+    return !settings.filteredKeys.test(vkCode);
 }
 
-void KeyboardHookManager::handleKeyDown(WORD vkCode)
+void KeyboardHookManager::handleKeyDown(std::uint16_t vkCode, std::chrono::steady_clock::time_point timestamp,
+                                        const HookSettings &settings)
 {
-    // Rate limiting for repeated keys during fast typing
-    auto now = std::chrono::steady_clock::now();
-    auto it = keyTimestamps.find(vkCode);
-    
-    bool shouldPlay = true;
-    if (it != keyTimestamps.end())
-    {
-        auto timeSinceLastPress = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second);
-        if (timeSinceLastPress < KEY_PROCESSING_INTERVAL)
-        {
-            // Key pressed too quickly after last press, prioritize next key processing
-            shouldPlay = false;
-        }
-    }
-    
-    // Update timestamp for this key
-    keyTimestamps[vkCode] = now;
-    
-    // Update predictive cache - learn key sequences
-    if (latencyOptimizationLevel_ > 0 && !recentKeys.empty())
-    {
-        WORD previousKey = recentKeys.back();
-        keyFollowers[previousKey].insert(vkCode);
-        
-        // Preload sounds for keys that often follow the current key
-        preloadPredictedKeys(vkCode);
-    }
-    
-    // Add to recent keys and maintain fixed length
-    if (latencyOptimizationLevel_ > 0) {
-        recentKeys.push_back(vkCode);
-        while (recentKeys.size() > KEY_HISTORY_LENGTH) {
-            recentKeys.pop_front();
-        }
-    }
+    // Fast repeats only stay silent under the DROP overload policy
+    bool shouldPlay = throttle_.allowKeyDown(vkCode, timestamp, settings.overloadPolicy);
     
     // Play key down sound if we should
     if (shouldPlay)
@@ -257,43 +415,45 @@ void KeyboardHookManager::handleKeyDown(WORD vkCode)
         if (!soundFile.empty())
         {
             // Play the sound with high priority
-            soundPlayer_.playSound(soundFile, true);
+            soundPlayer_.playSound(soundFile, true, timestamp);
         }
     }
+
+    // The release sound is already known, so have its voice ready before the key comes up
+    if (settings.latencyOptimizationLevel > 0)
+    {
+        soundPlayer_.armKeyUp(vkCode, soundManager_.getRandomSoundForKey(vkCode, false));
+    }
+
+    // Learning key sequences and preloading what follows happens off the hook path
+    postKeyToLearn(vkCode);
 }
 
-void KeyboardHookManager::handleKeyUp(WORD vkCode)
+void KeyboardHookManager::handleKeyUp(std::uint16_t vkCode, std::chrono::steady_clock::time_point timestamp,
+                                      const HookSettings &settings)
 {
-    // Rate limiting for key up events during very fast typing
-    auto now = std::chrono::steady_clock::now();
-    auto it = keyTimestamps.find(vkCode);
-    
-    bool shouldPlay = true;
-    if (it != keyTimestamps.end())
+    // Very short holds only stay silent under the DROP overload policy
+    bool shouldPlay = throttle_.allowKeyUp(vkCode, timestamp, settings.overloadPolicy);
+
+    if (!shouldPlay)
     {
-        auto timeSinceKeyDown = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second);
-        
-        // If the key was released extremely quickly (less than 20ms), we may not want to play the up sound
-        // as this could indicate very fast typing where playing every sound would cause clipping
-        if (timeSinceKeyDown < std::chrono::milliseconds(20))
-        {
-            // For very fast typing, we prioritize down sounds over up sounds
-            shouldPlay = false;
-        }
+        soundPlayer_.releaseKeyUp(vkCode);
+        return;
     }
 
-    // Play key up sound if we should
-    if (shouldPlay)
+    // Start the voice armed at key down, or play the sound the usual way if it is not ready
+    if (!soundPlayer_.triggerKeyUp(vkCode, timestamp))
     {
         std::string soundFile = soundManager_.getRandomSoundForKey(vkCode, false);
         if (!soundFile.empty())
         {
             // Play with lower priority
-            soundPlayer_.playSound(soundFile, false);
+            soundPlayer_.playSound(soundFile, false, timestamp);
         }
     }
 }
 
+#ifdef _WIN32
 LRESULT CALLBACK KeyboardHookManager::KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
     // We must call the next hook in the chain, even if we process the message
@@ -303,50 +463,41 @@ LRESULT CALLBACK KeyboardHookManager::KeyboardHookProc(int nCode, WPARAM wParam,
     }
 
     KBDLLHOOKSTRUCT *pKey = reinterpret_cast<KBDLLHOOKSTRUCT *>(lParam);
-    WORD vkCode = pKey->vkCode;
 
-    // Check if we should process this key
-    if (!instance_->shouldProcessKey(vkCode))
-    {
-        return CallNextHookEx(instance_->hook_, nCode, wParam, lParam);
-    }
-
-    if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)
-    {
-        // Get injected flag - bit 4 (0x10) in flags
-        bool isInjected = (pKey->flags & 0x10) != 0;
-        
-        // Ignore injected keystrokes which might be from other software
-        if (!isInjected)
-        {
-            // If the key is already pressed (key repeat), ignore this event
-            if (pressedKeys_.find(vkCode) == pressedKeys_.end())
-            {
-                // Mark key as pressed
-                pressedKeys_.insert(vkCode);
-
-                // To minimize latency, handle directly in the hook thread for non-injected keystrokes
-                // This trades some potential UI responsiveness for sound latency
-                instance_->handleKeyDown(vkCode);
-            }
-        }
-    }
-    else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP)
+    if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN || wParam == WM_KEYUP || wParam == WM_SYSKEYUP)
     {
+        TraceSpan span("hook_callback", "vk", pKey->vkCode);
+        KeyEvent event;
+        event.keyCode = static_cast<std::uint16_t>(pKey->vkCode);
+        event.keyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
         // Get injected flag - bit 4 (0x10) in flags
-        bool isInjected = (pKey->flags & 0x10) != 0;
-        
-        // Ignore injected keystrokes
-        if (!isInjected)
-        {
-            // Remove key from pressed set
-            pressedKeys_.erase(vkCode);
+        event.injected = (pKey->flags & 0x10) != 0;
+        event.timestamp = std::chrono::steady_clock::now();
 
-            // Handle key up event
-            instance_->handleKeyUp(vkCode);
-        }
+        // To minimize latency, handle directly in the hook thread
+        // This trades some potential UI responsiveness for sound latency
+        instance_->dispatchKeyEvent(event);
     }
 
     // Pass the message to the next hook in the chain
     return CallNextHookEx(instance_->hook_, nCode, wParam, lParam);
-}
\ No newline at end of file
+}
+
+void CALLBACK KeyboardHookManager::ForegroundChangedProc(HWINEVENTHOOK hook, DWORD eventType, HWND hwnd, LONG idObject,
+                                                         LONG idChild, DWORD eventThread, DWORD eventTime)
+{
+    (void)hook;
+    (void)eventType;
+    (void)hwnd;
+    (void)idObject;
+    (void)idChild;
+    (void)eventThread;
+    (void)eventTime;
+
+    // Focus moved away from where the keys are held; their key-ups may go to a secure desktop instead
+    if (instance_ != nullptr)
+    {
+        instance_->soundPlayer_.releaseArmedVoices();
+    }
+}
+#endif
@@ -0,0 +1,419 @@
+/**
+ * @file Logger.cpp
+ * @brief Implementation of the Logger class
+ */
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+const char *levelName(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::DEBUG:
+        return "DEBUG";
+    case LogLevel::INFO:
+        return "INFO";
+    case LogLevel::WARNING:
+        return "WARN";
+    case LogLevel::ERR:
+        return "ERROR";
+    }
+    return "?";
+}
+
+std::uint64_t hashMessage(const char *text, std::size_t length)
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+/**
+ * @brief Keeps a thread's buffer registered and marks it retired on thread exit
+ */
+struct ThreadBufferHandle
+{
+    std::shared_ptr<Logger::ThreadBuffer> buffer;
+
+    ~ThreadBufferHandle()
+    {
+        if (buffer) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+Logger &Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+bool Logger::start(const std::string &path)
+{
+    stop();
+
+    if (path.empty()) {
+        out_ = &std::cerr;
+    } else {
+        file_.open(path, std::ios::out | std::ios::trunc);
+        if (!file_.is_open()) {
+            out_ = &std::cerr;
+            KS_LOG_ERROR("Failed to open log file " << path << ", logging to stderr");
+        } else {
+            out_ = &file_;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_ = true;
+    }
+    flusherThread_ = std::thread(&Logger::flushLoop, this);
+    return out_ == &file_ || path.empty();
+}
+
+void Logger::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    wakeCv_.notify_one();
+
+    if (flusherThread_.joinable()) {
+        flusherThread_.join();
+    }
+
+    // Pick up anything staged while the flusher was exiting, and report repeats no later message will
+    drain(true);
+    out_ = nullptr;
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void Logger::setLevel(LogLevel level)
+{
+    level_.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const
+{
+    return static_cast<LogLevel>(level_.load(std::memory_order_relaxed));
+}
+
+void Logger::write(LogLevel level, const char *text, std::size_t length)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    auto now = std::chrono::steady_clock::now();
+    length = std::min(length, MAX_MESSAGE);
+
+    // Rate-limit identical messages from this thread
+    std::uint64_t hash = hashMessage(text, length);
+    std::uint64_t tag = hash >> REPEAT_COUNT_BITS;
+    RepeatEntry &repeat = buffer.repeats[hash % buffer.repeats.size()];
+    std::uint64_t state = repeat.state.load(std::memory_order_relaxed);
+    std::uint64_t repeated = 0;
+    bool tracked = true;
+    if ((state >> REPEAT_COUNT_BITS) == tag) {
+        if (now - repeat.lastEmitted < SUPPRESS_WINDOW) {
+            // Only this thread counts up, so the check cannot race with another increment
+            if ((state & REPEAT_COUNT_MASK) < REPEAT_COUNT_MASK) {
+                repeat.state.fetch_add(1, std::memory_order_relaxed);
+            }
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        repeated = repeat.state.exchange(tag << REPEAT_COUNT_BITS, std::memory_order_relaxed) & REPEAT_COUNT_MASK;
+        repeat.lastEmitted = now;
+    } else if ((state & REPEAT_COUNT_MASK) == 0) {
+        repeat.state.store(tag << REPEAT_COUNT_BITS, std::memory_order_relaxed);
+        repeat.lastEmitted = now;
+    } else {
+        tracked = false; // Slot holds another message's unreported count until the flusher takes it
+    }
+
+    std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= THREAD_CAPACITY) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record &record = buffer.records[head & (THREAD_CAPACITY - 1)];
+    record.level = level;
+    record.wallTime = std::chrono::system_clock::now();
+    record.time = now;
+    record.hash = tracked ? hash : 0;
+    std::memcpy(record.text, text, length);
+    record.messageLength = static_cast<std::uint16_t>(length);
+    record.length = static_cast<std::uint16_t>(length);
+
+    if (repeated > 0) {
+        char suffix[48];
+        int written = std::snprintf(suffix, sizeof(suffix), " (repeated %llu times)",
+                                    static_cast<unsigned long long>(repeated));
+        std::size_t room = MAX_MESSAGE - length;
+        std::size_t count = std::min(room, static_cast<std::size_t>(written > 0 ? written : 0));
+        std::memcpy(record.text + length, suffix, count);
+        record.length = static_cast<std::uint16_t>(length + count);
+    }
+
+    buffer.head.store(head + 1, std::memory_order_release);
+    notifyFlusher();
+}
+
+std::uint64_t Logger::getDroppedCount() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Logger::getSuppressedCount() const
+{
+    return suppressed_.load(std::memory_order_relaxed);
+}
+
+bool Logger::parseLevel(const std::string &name, LogLevel &level)
+{
+    if (name == "debug") {
+        level = LogLevel::DEBUG;
+    } else if (name == "info") {
+        level = LogLevel::INFO;
+    } else if (name == "warning" || name == "warn") {
+        level = LogLevel::WARNING;
+    } else if (name == "error") {
+        level = LogLevel::ERR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Logger::ThreadBuffer &Logger::threadBuffer()
+{
+    thread_local ThreadBufferHandle handle;
+    if (!handle.buffer) {
+        handle.buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        buffers_.push_back(handle.buffer);
+    }
+    return *handle.buffer;
+}
+
+void Logger::notifyFlusher()
+{
+    // Only the first record after the flusher went idle pays for a wakeup. Notifying without
+    // wakeMutex_ can miss a flusher that is about to wait; its FLUSH_INTERVAL timeout covers that.
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    wakeCv_.notify_one();
+}
+
+void Logger::flushLoop()
+{
+    auto lastReport = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (running_) {
+        wakeCv_.wait_for(lock, FLUSH_INTERVAL, [this] { return !running_ || pending_.load(std::memory_order_acquire); });
+        if (!running_) {
+            break;
+        }
+
+        pending_.store(false, std::memory_order_release);
+        lock.unlock();
+
+        // Repeat counts are reported at most once per window, like the messages themselves
+        auto now = std::chrono::steady_clock::now();
+        bool report = now - lastReport >= SUPPRESS_WINDOW;
+        if (report) {
+            lastReport = now;
+        }
+        drain(report);
+        lock.lock();
+    }
+}
+
+std::size_t Logger::drain(bool reportAll)
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        buffers = buffers_;
+    }
+
+    std::vector<std::uint64_t> heads(buffers.size());
+    batch_.clear();
+
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        ThreadBuffer &buffer = *buffers[i];
+        std::uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+        heads[i] = buffer.head.load(std::memory_order_acquire);
+        for (std::uint64_t index = tail; index < heads[i]; ++index) {
+            const Record &record = buffer.records[index & (THREAD_CAPACITY - 1)];
+            batch_.push_back(&record);
+
+            // Keep the text of tracked messages, in ring order, to name them in later summaries
+            if (out_ && record.hash != 0) {
+                RepeatText &last = buffer.repeatTexts[record.hash % buffer.repeatTexts.size()];
+                last.tag = record.hash >> REPEAT_COUNT_BITS;
+                last.level = record.level;
+                last.length = record.messageLength;
+                std::memcpy(last.text, record.text, record.messageLength);
+            }
+        }
+    }
+
+    if (out_ && !batch_.empty()) {
+        // Interleave the per-thread rings back into one timeline
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Record *a, const Record *b) { return a->time < b->time; });
+
+        for (const Record *record : batch_) {
+            writeLine(record->level, record->wallTime, record->text, record->length);
+        }
+    } else if (!out_) {
+        // Not started yet: leave the records staged
+        return 0;
+    }
+
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        buffers[i]->tail.store(heads[i], std::memory_order_release);
+
+        // A retired ring is about to be forgotten, so its counts are reported now
+        if (reportAll || buffers[i]->retired.load(std::memory_order_acquire)) {
+            reportRepeats(*buffers[i]);
+        }
+    }
+    out_->flush();
+
+    // Forget rings whose threads have exited and that are now empty
+    {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                      [](const std::shared_ptr<ThreadBuffer> &buffer) {
+                                          return buffer->retired.load(std::memory_order_acquire) &&
+                                                 buffer->tail.load(std::memory_order_relaxed) ==
+                                                     buffer->head.load(std::memory_order_acquire);
+                                      }),
+                       buffers_.end());
+    }
+
+    return batch_.size();
+}
+
+void Logger::reportRepeats(ThreadBuffer &buffer)
+{
+    for (std::size_t i = 0; i < buffer.repeats.size(); ++i) {
+        // Take the count, leaving the tag so the owning thread keeps suppressing the message
+        std::uint64_t state = buffer.repeats[i].state.load(std::memory_order_relaxed);
+        while ((state & REPEAT_COUNT_MASK) != 0 &&
+               !buffer.repeats[i].state.compare_exchange_weak(state, state & ~REPEAT_COUNT_MASK,
+                                                              std::memory_order_relaxed)) {
+        }
+        std::uint64_t count = state & REPEAT_COUNT_MASK;
+        const RepeatText &last = buffer.repeatTexts[i];
+        if (count == 0 || last.tag != (state >> REPEAT_COUNT_BITS)) {
+            continue; // Nothing pending, or its first emission was dropped
+        }
+
+        char line[MAX_MESSAGE + 48];
+        std::memcpy(line, last.text, last.length);
+        int written = std::snprintf(line + last.length, sizeof(line) - last.length, " (repeated %llu times)",
+                                    static_cast<unsigned long long>(count));
+        writeLine(last.level, std::chrono::system_clock::now(), line, last.length + (written > 0 ? written : 0));
+    }
+}
+
+void Logger::writeLine(LogLevel level, std::chrono::system_clock::time_point wallTime, const char *text,
+                       std::size_t length)
+{
+    std::time_t seconds = std::chrono::system_clock::to_time_t(wallTime);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(wallTime.time_since_epoch()).count() % 1000;
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    *out_ << std::put_time(&local, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(3) << std::setfill('0') << millis
+          << " [" << levelName(level) << "] ";
+    out_->write(text, static_cast<std::streamsize>(length));
+    out_->put('\n');
+}
+
+void LogLine::FixedBuffer::reset()
+{
+    size_ = 0;
+}
+
+std::size_t LogLine::FixedBuffer::size() const
+{
+    return size_;
+}
+
+const char *LogLine::FixedBuffer::data() const
+{
+    return data_;
+}
+
+LogLine::FixedBuffer::int_type LogLine::FixedBuffer::overflow(int_type ch)
+{
+    if (ch != traits_type::eof() && size_ < sizeof(data_)) {
+        data_[size_++] = static_cast<char>(ch);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize LogLine::FixedBuffer::xsputn(const char *s, std::streamsize count)
+{
+    // Truncate instead of failing so the rest of the expression stays cheap
+    std::size_t copy = std::min(static_cast<std::size_t>(count), sizeof(data_) - size_);
+    std::memcpy(data_ + size_, s, copy);
+    size_ += copy;
+    return count;
+}
+
+LogLine::LogLine(LogLevel level)
+    : level_(level), scratch_(scratch())
+{
+    scratch_.buffer.reset();
+    scratch_.stream.clear();
+}
+
+LogLine::~LogLine()
+{
+    Logger::instance().write(level_, scratch_.buffer.data(), scratch_.buffer.size());
+}
+
+std::ostream &LogLine::stream()
+{
+    return scratch_.stream;
+}
+
+LogLine::Scratch &LogLine::scratch()
+{
+    thread_local Scratch scratch;
+    return scratch;
+}
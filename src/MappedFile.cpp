@@ -0,0 +1,90 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Implementation of the MappedFile class
+ */
+#include "MappedFile.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utils.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path)
+    : data_(nullptr),
+      size_(0),
+      mapping_(nullptr)
+{
+    HANDLE file = CreateFileW(Utils::toWideString(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        // The mapping keeps its own reference to the file
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            data_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data_) {
+                size_ = static_cast<std::size_t>(size.QuadPart);
+                mapping_ = mapping;
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path)
+    : data_(nullptr),
+      size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            // Decoders read front to back; advice values are not flags, so give each on its own
+            madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            madvise(data, static_cast<std::size_t>(info.st_size), MADV_WILLNEED);
+            data_ = data;
+            size_ = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        munmap(const_cast<void *>(data_), size_);
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the runtime metrics types
+ */
+#include "Metrics.h"
+#include <sstream>
+
+namespace {
+
+std::size_t bucketFor(std::uint64_t value)
+{
+    // Bucket i holds [2^i, 2^(i+1)) units; bucket 0 also holds 0
+    std::size_t bucket = 0;
+    while (value > 1 && bucket + 1 < LatencyHistogram::BUCKET_COUNT) {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::uint64_t bucketUpperBound(std::size_t bucket)
+{
+    return (std::uint64_t{1} << (bucket + 1)) - 1;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram(const std::string &name, const char *unit)
+    : name_(name),
+      unit_(unit),
+      count_(0),
+      sum_(0),
+      max_(0)
+{
+    for (auto &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::microseconds duration)
+{
+    recordValue(duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0);
+}
+
+void LatencyHistogram::recordValue(std::uint64_t value)
+{
+    buckets_[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t previous = max_.load(std::memory_order_relaxed);
+    while (value > previous && !max_.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::getCount() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::getPercentile(double percentile) const
+{
+    std::uint64_t total = getCount();
+    if (total == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<std::uint64_t>(static_cast<double>(total) * percentile / 100.0);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen > target) {
+            return bucketUpperBound(i);
+        }
+    }
+    return getMax();
+}
+
+std::uint64_t LatencyHistogram::getMax() const
+{
+    return max_.load(std::memory_order_relaxed);
+}
+
+const std::string &LatencyHistogram::getName() const
+{
+    return name_;
+}
+
+std::string LatencyHistogram::formatSummary() const
+{
+    std::uint64_t count = getCount();
+    std::ostringstream out;
+    out << name_ << ": count=" << count
+        << " mean=" << (count > 0 ? sum_.load(std::memory_order_relaxed) / count : 0) << unit_
+        << " p50<=" << getPercentile(50) << unit_
+        << " p99<=" << getPercentile(99) << unit_
+        << " max=" << getMax() << unit_;
+    return out.str();
+}
+
+std::string LatencyHistogram::format() const
+{
+    std::ostringstream out;
+    out << formatSummary() << "\n";
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+        std::uint64_t count = buckets_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << "  <=" << bucketUpperBound(i) << unit_ << " " << count << "\n";
+        }
+    }
+    return out.str();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
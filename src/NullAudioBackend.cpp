@@ -0,0 +1,196 @@
+/**
+ * @file NullAudioBackend.cpp
+ * @brief Implementation of the NullAudioBackend class
+ */
+#include "NullAudioBackend.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+NullAudioBackend::NullAudioBackend()
+    : running_(false),
+      suspended_(false),
+      periodFrames_(0)
+{
+}
+
+NullAudioBackend::~NullAudioBackend()
+{
+    close();
+}
+
+bool NullAudioBackend::open(const AudioBackendConfig &config)
+{
+    close();
+
+    periodFrames_ = std::clamp<unsigned int>(config.periodFrames, 32,
+                                             static_cast<unsigned int>(SoftwareMixer::MAX_PERIOD_FRAMES));
+    mixer_ = std::make_unique<SoftwareMixer>(config.sampleRate);
+    mixer_->configureEffects(config.effects);
+
+    if (!config.outputFile.empty()) {
+        output_.open(config.outputFile, std::ios::binary | std::ios::trunc);
+        if (!output_.is_open()) {
+            KS_LOG_ERROR("Failed to open audio output file: " << config.outputFile);
+            mixer_.reset();
+            return false;
+        }
+    }
+
+    running_ = true;
+    suspended_ = false;
+    renderThread_ = std::thread(&NullAudioBackend::renderLoop, this);
+    return true;
+}
+
+void NullAudioBackend::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        running_ = false;
+    }
+    stateCv_.notify_all();
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+
+    if (output_.is_open()) {
+        output_.close();
+    }
+    mixer_.reset();
+}
+
+void NullAudioBackend::suspend()
+{
+    if (mixer_) {
+        mixer_->stopAllVoices();
+    }
+    suspended_ = true;
+}
+
+void NullAudioBackend::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        suspended_ = false;
+    }
+    stateCv_.notify_all();
+}
+
+std::shared_ptr<AudioVoice> NullAudioBackend::startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                                         std::chrono::steady_clock::time_point onset)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->startVoice(buffer, volume, onset);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> NullAudioBackend::startSynthVoice(const ClickParams &params, float volume,
+                                                              std::chrono::steady_clock::time_point onset)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->startSynthVoice(params, volume, onset);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> NullAudioBackend::armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->armVoice(buffer, volume);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> NullAudioBackend::armSynthVoice(const ClickParams &params, float volume)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->armSynthVoice(params, volume);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+bool NullAudioBackend::configureEffects(const BusEffectSettings &settings)
+{
+    return mixer_ && mixer_->configureEffects(settings);
+}
+
+void NullAudioBackend::releaseFinishedVoices()
+{
+    if (mixer_) {
+        mixer_->releaseFinishedVoices();
+    }
+}
+
+std::string NullAudioBackend::getName() const
+{
+    return "null";
+}
+
+std::string NullAudioBackend::describeLatency() const
+{
+    if (!mixer_) {
+        return "closed";
+    }
+
+    std::ostringstream out;
+    out << periodFrames_ << " frames per period at " << mixer_->getSampleRate() << " Hz ("
+        << (periodFrames_ * 1000.0 / mixer_->getSampleRate()) << " ms), no device";
+    return out.str();
+}
+
+void NullAudioBackend::renderLoop()
+{
+    Tracer::setThreadName("null-render");
+    std::vector<std::int16_t> period(static_cast<std::size_t>(periodFrames_) * SoftwareMixer::CHANNELS);
+    const auto periodDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(periodFrames_) / mixer_->getSampleRate()));
+    auto nextPeriod = std::chrono::steady_clock::now();
+
+    while (running_) {
+        if (suspended_) {
+            // Mirror a paused device: block until resumed and restart the clock
+            std::unique_lock<std::mutex> lock(stateMutex_);
+            stateCv_.wait(lock, [this]() { return !running_ || !suspended_; });
+            nextPeriod = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        mixer_->render(period.data(), periodFrames_);
+        if (output_.is_open()) {
+            output_.write(reinterpret_cast<const char *>(period.data()),
+                          static_cast<std::streamsize>(period.size() * sizeof(std::int16_t)));
+        }
+
+        nextPeriod += periodDuration;
+        std::this_thread::sleep_until(nextPeriod);
+    }
+}
@@ -0,0 +1,305 @@
+/**
+ * @file PackWatcher.cpp
+ * @brief Implementation of the PackWatcher class
+ */
+#include "PackWatcher.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utils.h"
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+PackWatcher::PackWatcher(const std::string &root, std::chrono::milliseconds debounce, Callback callback)
+    : root_(root),
+      debounce_(debounce),
+      callback_(std::move(callback)),
+      running_(false),
+#ifdef _WIN32
+      directory_(nullptr),
+      stopEvent_(nullptr)
+#else
+      inotifyFd_(-1),
+      wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+#endif
+{
+}
+
+PackWatcher::~PackWatcher()
+{
+    stop();
+#ifndef _WIN32
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+#endif
+}
+
+#ifdef _WIN32
+
+bool PackWatcher::start()
+{
+    if (running_) {
+        return false;
+    }
+
+    HANDLE directory = CreateFileW(Utils::toWideString(root_).c_str(), FILE_LIST_DIRECTORY,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                   OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory == INVALID_HANDLE_VALUE) {
+        DWORD error = GetLastError();
+        KS_LOG_ERROR("Failed to watch " << root_ << ", error " << error);
+        return false;
+    }
+
+    directory_ = directory;
+    stopEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    running_ = true;
+    thread_ = std::thread(&PackWatcher::watch, this);
+    KS_LOG_INFO("Watching " << root_ << " for sound pack changes");
+    return true;
+}
+
+void PackWatcher::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    SetEvent(static_cast<HANDLE>(stopEvent_));
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    CloseHandle(static_cast<HANDLE>(directory_));
+    CloseHandle(static_cast<HANDLE>(stopEvent_));
+    directory_ = nullptr;
+    stopEvent_ = nullptr;
+}
+
+void PackWatcher::watch()
+{
+    Tracer::setThreadName("pack-watcher");
+    HANDLE directory = static_cast<HANDLE>(directory_);
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    alignas(DWORD) BYTE buffer[64 * 1024];
+
+    auto requestChanges = [&]() {
+        ResetEvent(overlapped.hEvent);
+        return ReadDirectoryChangesW(directory, buffer, sizeof(buffer), TRUE,
+                                     FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                         FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                                     nullptr, &overlapped, nullptr) != 0;
+    };
+
+    std::set<std::string> changes;
+    HANDLE handles[2] = {overlapped.hEvent, static_cast<HANDLE>(stopEvent_)};
+    bool pending = requestChanges();
+    if (!pending) {
+        DWORD error = GetLastError();
+        KS_LOG_ERROR("Failed to read changes under " << root_ << ", error " << error);
+    }
+
+    while (running_ && pending) {
+        // Each event restarts the quiet period
+        DWORD timeout = changes.empty() ? INFINITE : static_cast<DWORD>(debounce_.count());
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeout);
+        if (result == WAIT_TIMEOUT) {
+            callback_(changes);
+            changes.clear();
+            continue;
+        }
+        if (result != WAIT_OBJECT_0) {
+            break; // Stopped
+        }
+
+        DWORD bytes = 0;
+        pending = false;
+        if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE)) {
+            DWORD error = GetLastError();
+            KS_LOG_ERROR("Failed to read changes under " << root_ << ", error " << error);
+            break;
+        }
+
+        if (bytes == 0) {
+            // The notification buffer overflowed; report the whole tree
+            changes.insert("");
+        } else {
+            const BYTE *entry = buffer;
+            for (;;) {
+                auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(entry);
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                for (wchar_t &c : name) {
+                    c = c == L'\\' ? L'/' : c;
+                }
+                changes.insert(Utils::toUtf8String(name));
+                if (info->NextEntryOffset == 0) {
+                    break;
+                }
+                entry += info->NextEntryOffset;
+            }
+        }
+
+        pending = requestChanges();
+    }
+
+    if (pending) {
+        DWORD bytes = 0;
+        CancelIoEx(directory, &overlapped);
+        GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+}
+
+#else
+
+bool PackWatcher::start()
+{
+    if (running_ || wakeFd_ < 0) {
+        return false;
+    }
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        KS_LOG_ERROR("Failed to create inotify instance: " << std::strerror(errno));
+        return false;
+    }
+
+    addWatches("", nullptr);
+    if (watches_.empty()) {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        return false;
+    }
+
+    KS_LOG_INFO("Watching " << root_ << " for sound pack changes (" << watches_.size() << " directories)");
+    running_ = true;
+    thread_ = std::thread(&PackWatcher::watch, this);
+    return true;
+}
+
+void PackWatcher::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    std::uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    close(inotifyFd_);
+    inotifyFd_ = -1;
+    watches_.clear();
+}
+
+void PackWatcher::addWatches(const std::string &relative, std::set<std::string> *changes)
+{
+    std::string path = relative.empty() ? root_ : root_ + "/" + relative;
+    int wd = inotify_add_watch(inotifyFd_, path.c_str(),
+                               IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+    if (wd < 0) {
+        KS_LOG_WARNING("Cannot watch " << path << ": " << std::strerror(errno));
+        return;
+    }
+    watches_[wd] = relative;
+
+    // Files may have landed in a new directory before its watch existed
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+        std::string child = relative.empty() ? entry.path().filename().string()
+                                             : relative + "/" + entry.path().filename().string();
+        if (entry.is_directory(ec)) {
+            addWatches(child, changes);
+        } else if (changes) {
+            changes->insert(child);
+        }
+    }
+}
+
+void PackWatcher::watch()
+{
+    Tracer::setThreadName("pack-watcher");
+    alignas(inotify_event) char buffer[4096];
+    std::set<std::string> changes;
+
+    while (running_) {
+        // Each event restarts the quiet period
+        pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+        int result = poll(fds, 2, changes.empty() ? -1 : static_cast<int>(debounce_.count()));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            KS_LOG_ERROR("Pack watcher poll failed: " << std::strerror(errno));
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break; // Stopped
+        }
+        if (result == 0) {
+            callback_(changes);
+            changes.clear();
+            continue;
+        }
+
+        ssize_t bytes;
+        while ((bytes = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+            for (char *cursor = buffer; cursor < buffer + bytes;) {
+                auto *event = reinterpret_cast<inotify_event *>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    changes.insert("");
+                    continue;
+                }
+                auto it = watches_.find(event->wd);
+                if (it == watches_.end()) {
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watches_.erase(it);
+                    continue;
+                }
+                if (event->len == 0 || event->name[0] == '\0') {
+                    continue;
+                }
+
+                std::string relative = it->second.empty() ? std::string(event->name)
+                                                          : it->second + "/" + event->name;
+                changes.insert(relative);
+
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    addWatches(relative, &changes);
+                } else if ((event->mask & IN_ISDIR) && (event->mask & IN_MOVED_FROM)) {
+                    // The moved subtree is reported again under its new name, if still inside the root
+                    for (auto watch = watches_.begin(); watch != watches_.end();) {
+                        if (watch->second == relative || watch->second.rfind(relative + "/", 0) == 0) {
+                            inotify_rm_watch(inotifyFd_, watch->first);
+                            watch = watches_.erase(watch);
+                        } else {
+                            ++watch;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file ProcessMemory.cpp
+ * @brief Implementation of the ProcessMemory class
+ */
+#include "ProcessMemory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#endif
+
+#ifdef _WIN32
+
+std::size_t ProcessMemory::getResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+}
+
+std::size_t ProcessMemory::getPeakResidentBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
+bool ProcessMemory::resetPeak()
+{
+    return false;
+}
+
+#else
+
+namespace {
+
+/**
+ * @brief Read a "kB" field from /proc/self/status
+ * @param field Field name including the colon, e.g. "VmRSS:"
+ * @return Bytes, or 0 if unavailable
+ */
+std::size_t readStatusField(const char *field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string name;
+    std::size_t kilobytes = 0;
+    while (status >> name) {
+        if (name == field) {
+            status >> kilobytes;
+            return kilobytes * 1024;
+        }
+        status.ignore(256, '\n');
+    }
+    return 0;
+}
+
+} // namespace
+
+std::size_t ProcessMemory::getResidentBytes()
+{
+    return readStatusField("VmRSS:");
+}
+
+std::size_t ProcessMemory::getPeakResidentBytes()
+{
+    std::size_t peak = readStatusField("VmHWM:");
+    if (peak == 0) {
+        // No procfs: ru_maxrss is in kilobytes on Linux and bytes on macOS
+        struct rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        peak = static_cast<std::size_t>(usage.ru_maxrss);
+#else
+        peak = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+    return peak;
+}
+
+bool ProcessMemory::resetPeak()
+{
+    // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    return static_cast<bool>(clearRefs << "5") && static_cast<bool>(clearRefs.flush());
+}
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file ProfiledMutex.cpp
+ * @brief Implementation of the ProfiledMutex class
+ */
+#include "ProfiledMutex.h"
+#include "Tracer.h"
+#include <sstream>
+
+namespace {
+
+std::uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+} // namespace
+
+ProfiledMutex::ProfiledMutex(const char *name)
+    : name_(name),
+      waitTime_(std::string(name) + ".wait", "ns"),
+      holdTime_(std::string(name) + ".hold", "ns")
+{
+}
+
+void ProfiledMutex::lock()
+{
+    if (!mutex_.try_lock()) {
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        TraceSpan span(name_);
+        auto waitStart = std::chrono::steady_clock::now();
+        mutex_.lock();
+        waitTime_.recordValue(nanosecondsSince(waitStart));
+    }
+    acquired();
+}
+
+bool ProfiledMutex::try_lock()
+{
+    if (!mutex_.try_lock()) {
+        return false;
+    }
+    acquired();
+    return true;
+}
+
+void ProfiledMutex::unlock()
+{
+    holdTime_.recordValue(nanosecondsSince(lockedAt_));
+    mutex_.unlock();
+}
+
+void ProfiledMutex::acquired()
+{
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    lockedAt_ = std::chrono::steady_clock::now();
+}
+
+const char *ProfiledMutex::getName() const
+{
+    return name_;
+}
+
+std::uint64_t ProfiledMutex::getAcquisitions() const
+{
+    return acquisitions_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t ProfiledMutex::getContended() const
+{
+    return contended_.load(std::memory_order_relaxed);
+}
+
+const LatencyHistogram &ProfiledMutex::getWaitTime() const
+{
+    return waitTime_;
+}
+
+const LatencyHistogram &ProfiledMutex::getHoldTime() const
+{
+    return holdTime_;
+}
+
+std::string ProfiledMutex::formatSummary() const
+{
+    std::ostringstream out;
+    out << name_ << ": acquisitions=" << getAcquisitions() << " contended=" << getContended() << "\n"
+        << waitTime_.formatSummary() << "\n"
+        << holdTime_.formatSummary() << "\n";
+    return out.str();
+}
+
+std::string ProfiledMutex::format() const
+{
+    std::ostringstream out;
+    out << name_ << ": acquisitions=" << getAcquisitions() << " contended=" << getContended() << "\n"
+        << waitTime_.format() << holdTime_.format();
+    return out.str();
+}
@@ -0,0 +1,120 @@
+/**
+ * @file SFMLSoundBackend.cpp
+ * @brief Implementation of the SFMLSoundBackend class
+ */
+#include "SFMLSoundBackend.h"
+#include "Logger.h"
+
+namespace {
+
+/**
+ * @class SFMLSoundVoice
+ * @brief Voice backed by an sf::Sound that keeps its buffer alive
+ */
+class SFMLSoundVoice : public AudioVoice
+{
+public:
+    explicit SFMLSoundVoice(const std::shared_ptr<sf::SoundBuffer> &buffer)
+        : buffer_(buffer),
+          sound_(*buffer)
+    {
+    }
+
+    void play(float volume)
+    {
+        sound_.setVolume(volume);
+        sound_.play();
+    }
+
+    bool trigger(std::chrono::steady_clock::time_point onset) override
+    {
+        // sf::Sound cannot start at a given sample
+        (void)onset;
+        if (sound_.getStatus() != sf::Sound::Status::Stopped) {
+            return false;
+        }
+        sound_.play();
+        return true;
+    }
+
+    void stop() override
+    {
+        sound_.stop();
+    }
+
+    bool isPlaying() const override
+    {
+        return sound_.getStatus() != sf::Sound::Status::Stopped;
+    }
+
+    void setVolume(float volume) override
+    {
+        sound_.setVolume(volume);
+    }
+
+private:
+    std::shared_ptr<sf::SoundBuffer> buffer_;
+    sf::Sound sound_;
+};
+
+} // namespace
+
+bool selectSFMLPlaybackDevice(const std::string &device)
+{
+    if (device.empty()) {
+        return true;
+    }
+
+    if (!sf::PlaybackDevice::setDevice(device)) {
+        KS_LOG_WARNING("Playback device not available: " << device);
+        return false;
+    }
+
+    return true;
+}
+
+bool SFMLSoundBackend::open(const AudioBackendConfig &config)
+{
+    return selectSFMLPlaybackDevice(config.device);
+}
+
+void SFMLSoundBackend::close()
+{
+    // Voices own their sf::Sound; nothing is held at the backend level
+}
+
+std::shared_ptr<AudioVoice> SFMLSoundBackend::startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                                         std::chrono::steady_clock::time_point onset)
+{
+    // sf::Sound cannot start at a given sample, so every voice starts at once
+    (void)onset;
+    if (!buffer) {
+        return nullptr;
+    }
+
+    auto voice = std::make_shared<SFMLSoundVoice>(buffer);
+    voice->play(volume);
+    return voice;
+}
+
+std::shared_ptr<AudioVoice> SFMLSoundBackend::armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume)
+{
+    if (!buffer) {
+        return nullptr;
+    }
+
+    // The sound source is created and bound to the buffer now; trigger() only calls play()
+    auto voice = std::make_shared<SFMLSoundVoice>(buffer);
+    voice->setVolume(volume);
+    return voice;
+}
+
+std::string SFMLSoundBackend::getName() const
+{
+    return "sfml-sound";
+}
+
+std::string SFMLSoundBackend::describeLatency() const
+{
+    return "device period managed by SFML";
+}
@@ -3,22 +3,238 @@
  * @brief Implementation of the SFMLSoundPlayer class
  */
 #include "SFMLSoundPlayer.h"
-#include <iostream>
+#include "BatchFileReader.h"
+#include "ClickSynth.h"
+#include "EmbeddedPack.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "ProcessMemory.h"
+#include "TelemetryRing.h"
+#include "Tracer.h"
 #include <algorithm>
+#include <cstring>
 #include <future>
+#include <sstream>
 
-SFMLSoundPlayer::SFMLSoundPlayer()
-    : volume_(50),
-      running_(true)
+namespace {
+
+/**
+ * @brief The audio part of an encoded file
+ */
+struct AudioContent
+{
+    const unsigned char *bytes;
+    std::size_t size;
+};
+
+/**
+ * @brief Find the audio content of an encoded file
+ *
+ * ID3 tags are skipped so copies that differ only in their metadata
+ * still match.
+ */
+AudioContent findContent(const void *data, std::size_t size)
+{
+    auto bytes = static_cast<const unsigned char *>(data);
+    std::size_t begin = 0;
+    std::size_t end = size;
+    if (size >= 10 && bytes[0] == 'I' && bytes[1] == 'D' && bytes[2] == '3') {
+        // ID3v2 header: the tag size is a 28-bit syncsafe integer
+        std::size_t tagSize = (static_cast<std::size_t>(bytes[6] & 0x7F) << 21) |
+                              (static_cast<std::size_t>(bytes[7] & 0x7F) << 14) |
+                              (static_cast<std::size_t>(bytes[8] & 0x7F) << 7) |
+                              static_cast<std::size_t>(bytes[9] & 0x7F);
+        begin = std::min(size, 10 + tagSize);
+    }
+    if (end - begin >= 128 && bytes[end - 128] == 'T' && bytes[end - 127] == 'A' && bytes[end - 126] == 'G') {
+        end -= 128; // ID3v1 trailer
+    }
+    return {bytes + begin, end - begin};
+}
+
+/**
+ * @brief Hash audio content
+ *
+ * The size is mixed in to make collisions between different-length
+ * files even less likely.
+ */
+std::uint64_t hashContent(const AudioContent &content)
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < content.size; ++i) {
+        hash = (hash ^ content.bytes[i]) * 1099511628211ULL;
+    }
+    return hash ^ (content.size * 0x9E3779B97F4A7C15ULL);
+}
+
+/**
+ * @brief Check that a file still holds exactly the given audio content
+ *
+ * A hash match alone is not proof; a file that cannot be read does not match.
+ */
+bool hasContent(const std::string &path, const AudioContent &content)
+{
+    MappedFile file(path);
+    if (!file.isValid()) {
+        return false;
+    }
+    AudioContent other = findContent(file.data(), file.size());
+    return other.size == content.size && std::memcmp(other.bytes, content.bytes, content.size) == 0;
+}
+
+} // namespace
+
+std::shared_ptr<sf::SoundBuffer> SFMLSoundPlayer::decodeSound(const std::string &path)
+{
+    if (EmbeddedPack::isEmbeddedPath(path)) {
+        auto buffer = std::make_shared<sf::SoundBuffer>();
+        return EmbeddedPack::loadBuffer(path, *buffer) ? buffer : nullptr;
+    }
+
+    // Decode from the page cache in place; the mapping goes away with this scope
+    MappedFile file(path);
+    if (file.isValid()) {
+        return decodeSound(path, file.data(), file.size());
+    }
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    return buffer->loadFromFile(path) ? buffer : nullptr;
+}
+
+std::shared_ptr<sf::SoundBuffer> SFMLSoundPlayer::decodeSound(const std::string &path, const void *data,
+                                                              std::size_t size)
+{
+    AudioContent content = findContent(data, size);
+    std::uint64_t key = hashContent(content);
+
+    // Compare the bytes outside the lock; it maps the resident buffer's source file
+    std::shared_ptr<sf::SoundBuffer> resident;
+    std::string residentPath;
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        auto it = buffersByContent_.find(key);
+        if (it != buffersByContent_.end()) {
+            resident = it->second.buffer.lock();
+            if (resident) {
+                residentPath = it->second.sourcePath;
+            } else {
+                buffersByContent_.erase(it);
+            }
+        }
+    }
+    if (resident && hasContent(residentPath, content)) {
+        dedupHits_++;
+        return resident;
+    }
+
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    if (!buffer->loadFromMemory(data, size)) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        ContentEntry &entry = buffersByContent_[key];
+        resident = entry.buffer.lock();
+        if (!resident) {
+            entry.buffer = buffer;
+            entry.sourcePath = path;
+
+            // Forget buffers that are no longer cached or playing
+            if (buffersByContent_.size() > 2 * MAX_CACHE_SIZE) {
+                for (auto other = buffersByContent_.begin(); other != buffersByContent_.end();) {
+                    other = other->second.buffer.expired() ? buffersByContent_.erase(other) : std::next(other);
+                }
+            }
+            return buffer;
+        }
+        residentPath = entry.sourcePath;
+    }
+
+    // Decoded concurrently elsewhere, or a different file with the same hash; share only identical content
+    if (hasContent(residentPath, content)) {
+        dedupHits_++;
+        return resident;
+    }
+    return buffer;
+}
+
+SFMLSoundPlayer::SFMLSoundPlayer(const AudioBackendConfig &config)
+    : backendConfig_(config),
+      volume_(50),
+      running_(true),
+      opened_(false),
+      idle_(false),
+      keepDeviceWarm_(false),
+      idleTimeoutMs_(std::chrono::duration_cast<std::chrono::milliseconds>(DEFAULT_IDLE_TIMEOUT).count()),
+      lastWakeLatencyUs_(0),
+      wakeupCount_(0),
+      soundsPlayed_(0),
+      soundsDropped_(0),
+      voicesStolen_(0),
+      armedHits_(0),
+      armedMisses_(0),
+      cacheHits_(0),
+      cacheMisses_(0),
+      dedupHits_(0),
+      queueLatency_("queue_to_play"),
+      decodeLatency_("decode_on_miss")
+{
+}
+
+bool SFMLSoundPlayer::open()
 {
+    if (opened_) {
+        return true;
+    }
+    
+    // Open the configured output backend, falling back to plain SFML sounds
+    const AudioBackendConfig &config = backendConfig_;
+    backend_ = AudioBackend::create(config.backend);
+    if (!backend_) {
+        KS_LOG_WARNING("Unknown audio backend '" << config.backend << "', using sfml-sound");
+    }
+    if (!backend_ || !backend_->open(config)) {
+        if (backend_) {
+            KS_LOG_ERROR("Failed to open audio backend '" << config.backend << "', using sfml-sound");
+        }
+        AudioBackendConfig fallback = config;
+        fallback.backend = "sfml-sound";
+        fallback.device.clear();
+        backend_ = AudioBackend::create(fallback.backend);
+        if (!backend_->open(fallback)) {
+            KS_LOG_ERROR("Failed to open fallback audio backend");
+            backend_.reset();
+            return false;
+        }
+    }
+    KS_LOG_INFO("Audio backend '" << backend_->getName() << "' opened, buffer latency: "
+                << backend_->describeLatency());
+    if (backend_->getName() != "sfml-sound" && config.scheduleLatencyMs > 0 &&
+        static_cast<std::uint64_t>(config.scheduleLatencyMs) * config.sampleRate < 1000ull * config.periodFrames) {
+        KS_LOG_WARNING("audio.scheduleLatencyMs (" << config.scheduleLatencyMs
+                       << ") is shorter than one period; onsets will be late and uneven");
+    }
+    
     // Start the sound processing thread
     processingThread_ = std::thread(&SFMLSoundPlayer::processSoundQueue, this);
+    opened_ = true;
+    return true;
+}
+
+bool SFMLSoundPlayer::isOpen() const
+{
+    return opened_;
 }
 
 SFMLSoundPlayer::~SFMLSoundPlayer()
 {
-    // Signal the processing thread to stop
-    running_ = false;
+    // Signal the processing thread to stop (under the queue lock so a parked thread cannot miss it)
+    {
+        std::lock_guard<ProfiledMutex> lock(queueMutex_);
+        running_ = false;
+    }
+    queueCv_.notify_all();
     
     // Wait for the thread to finish
     if (processingThread_.joinable()) {
@@ -28,25 +244,34 @@ SFMLSoundPlayer::~SFMLSoundPlayer()
     // Stop and clear all sounds
     stopAllSounds();
     
+    // Release the device before the buffers it may still reference
+    if (backend_) {
+        backend_->close();
+    }
+    
     // Clear cache
     {
-        std::lock_guard<std::mutex> lock(cacheMutex_);
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
         soundBuffers_.clear();
     }
 }
 
-bool SFMLSoundPlayer::playSound(const std::string &filePath, bool highPriority)
+bool SFMLSoundPlayer::playSound(const std::string &filePath, bool highPriority,
+                                std::chrono::steady_clock::time_point eventTime)
 {
-    if (filePath.empty()) {
+    // Silent until the device is open, so nothing queues up during startup
+    if (filePath.empty() || !opened_) {
         return false;
     }
     
+    TraceSpan span("enqueue", "high_priority", highPriority);
+    
     // Add to the pending sounds queue
     {
-        std::lock_guard<std::mutex> lock(queueMutex_);
+        std::lock_guard<ProfiledMutex> lock(queueMutex_);
         
         // Create a pending sound with priority information
-        PendingSound pendingSound(filePath, highPriority);
+        PendingSound pendingSound(filePath, highPriority, eventTime);
         
         // High priority sounds go to the front of the queue
         if (highPriority) {
@@ -63,9 +288,9 @@ bool SFMLSoundPlayer::playSound(const std::string &filePath, bool highPriority)
         
         // Limit queue size to prevent memory issues during very fast typing
         if (pendingSounds_.size() > 64) {
-            // Remove low priority sounds first
+            // Remove low priority sounds first; key-up arming is left alone, it replaces a sound of its own
             auto it = std::find_if(pendingSounds_.begin(), pendingSounds_.end(), 
-                [](const PendingSound& sound) { return !sound.highPriority; });
+                [](const PendingSound& sound) { return !sound.highPriority && sound.armToken == 0; });
                 
             if (it != pendingSounds_.end()) {
                 pendingSounds_.erase(it);
@@ -73,21 +298,153 @@ bool SFMLSoundPlayer::playSound(const std::string &filePath, bool highPriority)
                 // If no low priority sounds, remove the oldest high priority sound
                 pendingSounds_.pop_back();
             }
+            soundsDropped_++;
         }
     }
     
+    // Wake the processing thread (it may be parked)
+    queueCv_.notify_one();
+    
     return true;
 }
 
+void SFMLSoundPlayer::armKeyUp(std::uint16_t keyCode, const std::string &filePath)
+{
+    if (filePath.empty() || !opened_) {
+        return;
+    }
+    
+    // Register the hold first, so a release arriving before the voice is ready finds it
+    std::uint64_t token;
+    {
+        std::lock_guard<ProfiledMutex> lock(armMutex_);
+        auto it = armedVoices_.find(keyCode);
+        if (it != armedVoices_.end()) {
+            if (it->second.voice) {
+                it->second.voice->stop();
+            }
+            armedVoices_.erase(it);
+        }
+        if (armedVoices_.size() >= MAX_ARMED_VOICES) {
+            return;
+        }
+        token = ++nextArmToken_;
+        armedVoices_[keyCode].token = token;
+    }
+    
+    // The processing thread resolves the buffer and reserves the voice
+    {
+        std::lock_guard<ProfiledMutex> lock(queueMutex_);
+        PendingSound pendingSound(filePath, false, {});
+        pendingSound.armKey = keyCode;
+        pendingSound.armToken = token;
+        pendingSounds_.push_back(pendingSound);
+    }
+    queueCv_.notify_one();
+}
+
+bool SFMLSoundPlayer::triggerKeyUp(std::uint16_t keyCode, std::chrono::steady_clock::time_point eventTime)
+{
+    ArmedVoice armed;
+    {
+        std::lock_guard<ProfiledMutex> lock(armMutex_);
+        auto it = armedVoices_.find(keyCode);
+        if (it == armedVoices_.end()) {
+            return false;
+        }
+        armed = std::move(it->second);
+        armedVoices_.erase(it);
+    }
+    
+    // Not reserved yet (or the reservation failed): the caller plays the sound the usual way
+    if (!armed.voice) {
+        armedMisses_++;
+        return false;
+    }
+    
+    std::chrono::steady_clock::time_point onset;
+    if (backendConfig_.scheduleLatencyMs > 0) {
+        onset = eventTime + std::chrono::milliseconds(backendConfig_.scheduleLatencyMs);
+    }
+    armed.voice->setVolume(static_cast<float>(volume_));
+    if (!armed.voice->trigger(onset)) {
+        armedMisses_++;
+        return false;
+    }
+    armedHits_++;
+    soundsPlayed_++;
+    
+    {
+        std::lock_guard<ProfiledMutex> lock(soundsMutex_);
+        activeSounds_.push_back({armed.voice, std::chrono::steady_clock::now() + armed.duration, armed.path, false});
+    }
+    return true;
+}
+
+void SFMLSoundPlayer::releaseKeyUp(std::uint16_t keyCode)
+{
+    std::lock_guard<ProfiledMutex> lock(armMutex_);
+    auto it = armedVoices_.find(keyCode);
+    if (it == armedVoices_.end()) {
+        return;
+    }
+    if (it->second.voice) {
+        it->second.voice->stop();
+    }
+    armedVoices_.erase(it);
+}
+
+void SFMLSoundPlayer::releaseArmedVoices()
+{
+    std::lock_guard<ProfiledMutex> lock(armMutex_);
+    for (auto &entry : armedVoices_) {
+        if (entry.second.voice) {
+            entry.second.voice->stop();
+        }
+    }
+    armedVoices_.clear();
+}
+
+void SFMLSoundPlayer::attachArmedVoice(std::uint16_t keyCode, std::uint64_t token,
+                                       const std::shared_ptr<AudioVoice> &voice, const std::string &path,
+                                       std::chrono::milliseconds duration)
+{
+    {
+        std::lock_guard<ProfiledMutex> lock(armMutex_);
+        auto it = armedVoices_.find(keyCode);
+        if (it != armedVoices_.end() && it->second.token == token && !it->second.voice) {
+            if (voice) {
+                it->second.voice = voice;
+                it->second.path = path;
+                it->second.duration = duration;
+            } else {
+                // No free voice; the release falls back to playSound()
+                armedVoices_.erase(it);
+            }
+            return;
+        }
+    }
+    
+    // The key was released, re-armed or cancelled while the voice was being prepared
+    if (voice) {
+        voice->stop();
+    }
+}
+
 bool SFMLSoundPlayer::preloadSound(const std::string &filePath, bool highPriority)
 {
     if (filePath.empty()) {
         return false;
     }
     
+    // Synthesized sounds have nothing to load
+    if (ClickSynth::isSynthPath(filePath)) {
+        return true;
+    }
+    
     // Check if already in cache
     {
-        std::lock_guard<std::mutex> lock(cacheMutex_);
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
         if (soundBuffers_.find(filePath) != soundBuffers_.end()) {
             return true; // Already cached
         }
@@ -95,9 +452,10 @@ bool SFMLSoundPlayer::preloadSound(const std::string &filePath, bool highPriorit
     
     // For high priority preloads, load synchronously to ensure immediate availability
     if (highPriority) {
-        auto buffer = std::make_shared<sf::SoundBuffer>();
-        if (buffer->loadFromFile(filePath)) {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
+        TraceSpan span("decode_preload");
+        auto buffer = decodeSound(filePath);
+        if (buffer) {
+            std::lock_guard<ProfiledMutex> lock(cacheMutex_);
             // Check cache size
             if (soundBuffers_.size() >= MAX_CACHE_SIZE) {
                 if (!soundBuffers_.empty()) {
@@ -107,16 +465,18 @@ bool SFMLSoundPlayer::preloadSound(const std::string &filePath, bool highPriorit
             soundBuffers_[filePath] = buffer;
             return true;
         } else {
-            std::cerr << "Failed to preload sound file: " << filePath << std::endl;
+            KS_LOG_ERROR("Failed to preload sound file: " << filePath);
             return false;
         }
     }
     
     // Low priority preloads can be done asynchronously
     auto future = std::async(std::launch::async, [this, filePath]() {
-        auto buffer = std::make_shared<sf::SoundBuffer>();
-        if (buffer->loadFromFile(filePath)) {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
+        Tracer::setThreadName("preload");
+        TraceSpan span("decode_preload");
+        auto buffer = decodeSound(filePath);
+        if (buffer) {
+            std::lock_guard<ProfiledMutex> lock(cacheMutex_);
             // Check cache size
             if (soundBuffers_.size() >= MAX_CACHE_SIZE) {
                 if (!soundBuffers_.empty()) {
@@ -124,13 +484,14 @@ bool SFMLSoundPlayer::preloadSound(const std::string &filePath, bool highPriorit
                 }
             }
             soundBuffers_[filePath] = buffer;
+            predictedPaths_.insert(filePath);
         } else {
-            std::cerr << "Failed to preload sound file: " << filePath << std::endl;
+            KS_LOG_ERROR("Failed to preload sound file: " << filePath);
         }
     });
     
     // Store the future to prevent the warning about discarding it
-    std::lock_guard<std::mutex> lock(queueMutex_); // Reuse an existing mutex
+    std::lock_guard<ProfiledMutex> lock(queueMutex_); // Reuse an existing mutex
     preloadFutures_.push_back(std::move(future));
     
     // Clean up completed futures to avoid memory buildup
@@ -145,18 +506,135 @@ bool SFMLSoundPlayer::preloadSound(const std::string &filePath, bool highPriorit
     return true;
 }
 
+std::size_t SFMLSoundPlayer::preloadSounds(const std::vector<std::string> &filePaths)
+{
+    // Only read what is not cached yet; embedded sounds need no I/O and synthesized ones no loading
+    std::vector<FileRead> files;
+    std::vector<std::string> embedded;
+    std::size_t cached = 0;
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        std::unordered_set<std::string> seen;
+        for (const auto &path : filePaths) {
+            if (path.empty() || !seen.insert(path).second) {
+                continue;
+            }
+            if (soundBuffers_.find(path) != soundBuffers_.end() || ClickSynth::isSynthPath(path)) {
+                ++cached;
+            } else if (EmbeddedPack::isEmbeddedPath(path)) {
+                embedded.push_back(path);
+            } else {
+                files.push_back(FileRead{path, {}, false});
+            }
+        }
+    }
+
+    auto readStart = std::chrono::steady_clock::now();
+    BatchFileReader::Method method;
+    {
+        TraceSpan span("batch_read", "files", static_cast<std::int64_t>(files.size()));
+        method = BatchFileReader::readAll(files);
+    }
+    auto readTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - readStart);
+
+    auto store = [this](const std::string &path, const std::shared_ptr<sf::SoundBuffer> &buffer) {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        // Check cache size
+        if (soundBuffers_.size() >= MAX_CACHE_SIZE && soundBuffers_.find(path) == soundBuffers_.end()) {
+            soundBuffers_.erase(soundBuffers_.begin());
+        }
+        soundBuffers_[path] = buffer;
+    };
+
+    for (const auto &path : embedded) {
+        if (auto buffer = decodeSound(path)) {
+            store(path, buffer);
+            ++cached;
+        }
+    }
+
+    for (FileRead &file : files) {
+        if (!file.ok) {
+            KS_LOG_ERROR("Failed to read sound file: " << file.path);
+            continue;
+        }
+
+        TraceSpan span("decode_preload");
+        auto buffer = decodeSound(file.path, file.data.data(), file.data.size());
+        if (!buffer) {
+            KS_LOG_ERROR("Failed to preload sound file: " << file.path);
+            continue;
+        }
+        store(file.path, buffer);
+        ++cached;
+
+        // Release the encoded bytes as soon as they are decoded
+        std::vector<char>().swap(file.data);
+    }
+
+    KS_LOG_INFO("Preloaded " << cached << " of " << filePaths.size() << " sounds; read " << files.size()
+                << " files via " << BatchFileReader::getMethodName(method) << " in " << readTime.count() << " us");
+    return cached;
+}
+
+bool SFMLSoundPlayer::refreshSound(const std::string &filePath)
+{
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        if (soundBuffers_.find(filePath) == soundBuffers_.end()) {
+            return false;
+        }
+    }
+
+    // Decode outside the lock; the old buffer keeps serving hits meanwhile
+    std::shared_ptr<sf::SoundBuffer> buffer;
+    {
+        TraceSpan span("decode_preload");
+        buffer = decodeSound(filePath);
+    }
+
+    std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+    auto it = soundBuffers_.find(filePath);
+    if (it == soundBuffers_.end()) {
+        return false; // Evicted while decoding
+    }
+    if (!buffer) {
+        // Deleted or not yet fully written; decode again on next use
+        soundBuffers_.erase(it);
+        predictedPaths_.erase(filePath);
+        return false;
+    }
+    it->second = buffer;
+    return true;
+}
+
 void SFMLSoundPlayer::processSoundQueue()
 {
+    Tracer::setThreadName("sound-queue");
     auto lastCleanupTime = std::chrono::steady_clock::now();
+    auto lastActivityTime = lastCleanupTime;
+    bool resuming = false;
     
     while (running_) {
         // Process pending sounds
-        PendingSound soundToPlay("", false);
+        PendingSound soundToPlay("", false, {});
         bool hasSound = false;
         
         {
-            std::lock_guard<std::mutex> lock(queueMutex_);
+            std::unique_lock<ProfiledMutex> lock(queueMutex_);
+            if (pendingSounds_.empty()) {
+                auto hasWork = [this]() { return !running_ || !pendingSounds_.empty(); };
+                if (idle_) {
+                    // Parked: sleep until the next sound arrives, no periodic wakeups
+                    queueCv_.wait(lock, hasWork);
+                } else {
+                    // Active: wake for new sounds or for the next cleanup pass
+                    queueCv_.wait_for(lock, CLEANUP_INTERVAL, hasWork);
+                }
+                wakeupCount_++;
+            }
             if (!pendingSounds_.empty()) {
+                TraceSpan span("dequeue", "depth", static_cast<std::int64_t>(pendingSounds_.size()));
                 soundToPlay = pendingSounds_.front();
                 pendingSounds_.pop_front();
                 hasSound = true;
@@ -164,83 +642,152 @@ void SFMLSoundPlayer::processSoundQueue()
         }
         
         if (hasSound) {
+            lastActivityTime = std::chrono::steady_clock::now();
+            if (idle_) {
+                // Follow what the park did; keepDeviceWarm_ may have changed since
+                if (suspended_) {
+                    backend_->resume();
+                    suspended_ = false;
+                }
+                idle_ = false;
+                resuming = true;
+                KS_LOG_DEBUG("Audio pipeline resumed");
+            }
+            
+            // An armed key-up reserves its voice without starting it
+            const bool arming = soundToPlay.armToken != 0;
+            
             // First check if we already have too many sounds playing
-            {
-                std::lock_guard<std::mutex> lock(soundsMutex_);
+            if (!arming) {
+                std::lock_guard<ProfiledMutex> lock(soundsMutex_);
                 if (activeSounds_.size() >= MAX_CONCURRENT_SOUNDS) {
-                    // If this is a high priority sound, remove a low priority sound to make room
-                    if (soundToPlay.highPriority) {
-                        // Find a low priority sound to remove
+                    // High priority sounds always make room; low priority ones only under the LIMIT policy
+                    if (soundToPlay.highPriority || backendConfig_.overloadPolicy == OverloadPolicy::LIMIT) {
+                        // Prefer stopping a low priority sound, otherwise the oldest one
                         auto it = std::find_if(activeSounds_.begin(), activeSounds_.end(),
                             [](const SoundInstance& instance) { return !instance.highPriority; });
-                            
-                        if (it != activeSounds_.end()) {
-                            // Found a low priority sound to stop
-                            it->sound->stop();
-                            activeSounds_.erase(it);
-                        } else {
-                            // Remove the oldest sound if no low priority sounds are found
-                            if (!activeSounds_.empty()) {
-                                activeSounds_.erase(activeSounds_.begin());
-                            }
+                        if (it == activeSounds_.end()) {
+                            it = activeSounds_.begin();
                         }
+                        it->voice->stop();
+                        activeSounds_.erase(it);
+                        voicesStolen_++;
                     } else {
                         // For low priority sounds, just skip if we're at capacity
+                        soundsDropped_++;
                         continue;
                     }
                 }
             }
             
-            // Check if buffer is in cache
-            std::shared_ptr<sf::SoundBuffer> buffer;
-            bool bufferFound = false;
-            
-            {
-                std::lock_guard<std::mutex> lock(cacheMutex_);
-                auto it = soundBuffers_.find(soundToPlay.path);
-                if (it != soundBuffers_.end()) {
-                    buffer = it->second;
-                    bufferFound = true;
-                }
+            // Mixing backends start the voice a fixed latency after the key event, not whenever we got here
+            std::chrono::steady_clock::time_point onset;
+            if (!arming && backendConfig_.scheduleLatencyMs > 0) {
+                onset = soundToPlay.eventTime + std::chrono::milliseconds(backendConfig_.scheduleLatencyMs);
             }
-            
-            // If not in cache, load it
-            if (!bufferFound) {
-                buffer = std::make_shared<sf::SoundBuffer>();
-                if (!buffer->loadFromFile(soundToPlay.path)) {
-                    std::cerr << "Failed to load sound file: " << soundToPlay.path << std::endl;
+
+            // Synthesized clicks have no buffer and never touch the cache
+            std::shared_ptr<AudioVoice> voice;
+            std::shared_ptr<sf::SoundBuffer> buffer;
+            if (ClickSynth::isSynthPath(soundToPlay.path)) {
+                ClickParams params;
+                if (!ClickSynth::getParams(soundToPlay.path, synthKeystrokes_++, params)) {
+                    KS_LOG_ERROR("Unknown synthesized sound: " << soundToPlay.path);
+                    soundsDropped_++;
                     continue;
                 }
+                TraceSpan span(arming ? "voice_arm" : "voice_start");
+                voice = arming ? backend_->armSynthVoice(params, static_cast<float>(volume_))
+                               : backend_->startSynthVoice(params, static_cast<float>(volume_), onset);
+            } else {
+                // Check if buffer is in cache
+                bool bufferFound = false;
                 
-                // Add to cache
                 {
-                    std::lock_guard<std::mutex> lock(cacheMutex_);
-                    // Clean up cache if needed
-                    if (soundBuffers_.size() >= MAX_CACHE_SIZE) {
-                        // Simple strategy: just remove a random entry
-                        if (!soundBuffers_.empty()) {
-                            soundBuffers_.erase(soundBuffers_.begin());
-                        }
+                    TraceSpan span("cache_lookup", "hit");
+                    std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+                    auto it = soundBuffers_.find(soundToPlay.path);
+                    span.setArg(it != soundBuffers_.end());
+                    if (it != soundBuffers_.end()) {
+                        buffer = it->second;
+                        bufferFound = true;
+                        // A played prediction is promoted out of the cold tier
+                        predictedPaths_.erase(soundToPlay.path);
                     }
+                }
+                
+                // If not in cache, load it
+                if (bufferFound) {
+                    cacheHits_++;
+                } else {
+                    cacheMisses_++;
+                    auto decodeStart = std::chrono::steady_clock::now();
+                    {
+                        TraceSpan span("decode");
+                        buffer = decodeSound(soundToPlay.path);
+                    }
+                    if (!buffer) {
+                        KS_LOG_ERROR("Failed to load sound file: " << soundToPlay.path);
+                        soundsDropped_++;
+                        continue;
+                    }
+                    decodeLatency_.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - decodeStart));
+                
+                    // Add to cache
+                    {
+                        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+                        // Clean up cache if needed
+                        if (soundBuffers_.size() >= MAX_CACHE_SIZE) {
+                            // Simple strategy: just remove a random entry
+                            if (!soundBuffers_.empty()) {
+                                soundBuffers_.erase(soundBuffers_.begin());
+                            }
+                        }
                     
-                    soundBuffers_[soundToPlay.path] = buffer;
+                        soundBuffers_[soundToPlay.path] = buffer;
+                    }
                 }
+                
+                // Start a voice on the output backend
+                TraceSpan span(arming ? "voice_arm" : "voice_start");
+                voice = arming ? backend_->armVoice(buffer, static_cast<float>(volume_))
+                               : backend_->startVoice(buffer, static_cast<float>(volume_), onset);
             }
+            if (arming) {
+                auto duration = std::chrono::milliseconds(
+                    (buffer ? static_cast<int>(buffer->getDuration().asMilliseconds())
+                            : static_cast<int>(ClickSynth::MAX_DURATION * 1000)) + 200);
+                attachArmedVoice(soundToPlay.armKey, soundToPlay.armToken, voice, soundToPlay.path, duration);
+                continue;
+            }
+            if (!voice) {
+                soundsDropped_++;
+                continue;
+            }
+            soundsPlayed_++;
             
-            // Create sound instance (SFML 3 requires a buffer for construction)
-            std::shared_ptr<sf::Sound> sound = std::make_shared<sf::Sound>(*buffer);
-            sound->setVolume(static_cast<float>(volume_));
-            sound->play();
+            auto queueLatency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - soundToPlay.enqueueTime);
+            queueLatency_.record(queueLatency);
+            TelemetryRing::publish(TelemetryType::LATENCY, 0, static_cast<float>(queueLatency.count()));
+            
+            // Measure what the first sound after a resume paid for the wakeup
+            if (resuming) {
+                lastWakeLatencyUs_ = queueLatency.count();
+                resuming = false;
+            }
             
             // Calculate expiration time (duration of sound + small buffer)
             auto duration = std::chrono::milliseconds(
-                static_cast<int>(buffer->getDuration().asMilliseconds()) + 200);
+                (buffer ? static_cast<int>(buffer->getDuration().asMilliseconds())
+                        : static_cast<int>(ClickSynth::MAX_DURATION * 1000)) + 200);
             auto expiration = std::chrono::steady_clock::now() + duration;
             
             // Add to active sounds
             {
-                std::lock_guard<std::mutex> lock(soundsMutex_);
-                activeSounds_.push_back({sound, expiration, soundToPlay.path, soundToPlay.highPriority});
+                std::lock_guard<ProfiledMutex> lock(soundsMutex_);
+                activeSounds_.push_back({voice, expiration, soundToPlay.path, soundToPlay.highPriority});
             }
         }
         
@@ -251,28 +798,70 @@ void SFMLSoundPlayer::processSoundQueue()
             lastCleanupTime = now;
         }
         
-        // Sleep a bit to avoid consuming too much CPU
-        // Use shorter sleep time for better responsiveness
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // Park the loop once nothing has been played for the idle timeout
+        auto idleTimeout = std::chrono::milliseconds(idleTimeoutMs_.load());
+        if (!hasSound && !idle_ && idleTimeout.count() > 0 && now - lastActivityTime >= idleTimeout) {
+            parkPipeline();
+        }
     }
 }
 
-void SFMLSoundPlayer::cleanupFinishedSounds()
+void SFMLSoundPlayer::parkPipeline()
 {
-    std::lock_guard<std::mutex> lock(soundsMutex_);
+    idle_ = true;
     
-    auto now = std::chrono::steady_clock::now();
+    // Keeping the device warm means resuming costs nothing beyond a thread wakeup
+    if (keepDeviceWarm_) {
+        KS_LOG_DEBUG("Audio pipeline parked (device kept warm)");
+        return;
+    }
     
-    // Remove finished sounds
-    activeSounds_.erase(
-        std::remove_if(activeSounds_.begin(), activeSounds_.end(),
-            [&now](const SoundInstance& instance) {
-                // Check if sound is finished or expired
-                return instance.sound->getStatus() == sf::Sound::Status::Stopped ||
-                       now >= instance.expirationTime;
-            }),
-        activeSounds_.end()
-    );
+    // Release all voices and let the backend stop pulling from the device
+    releaseArmedVoices();
+    {
+        std::lock_guard<ProfiledMutex> lock(soundsMutex_);
+        for (auto& instance : activeSounds_) {
+            instance.voice->stop();
+        }
+        activeSounds_.clear();
+    }
+    backend_->suspend();
+    suspended_ = true;
+    
+    // Drop speculative preloads that were never played; the common set stays resident
+    size_t dropped = 0;
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        for (const auto& path : predictedPaths_) {
+            dropped += soundBuffers_.erase(path);
+        }
+        predictedPaths_.clear();
+    }
+    
+    KS_LOG_DEBUG("Audio pipeline parked, dropped " << dropped << " predicted buffers");
+}
+
+void SFMLSoundPlayer::cleanupFinishedSounds()
+{
+    {
+        std::lock_guard<ProfiledMutex> lock(soundsMutex_);
+        
+        auto now = std::chrono::steady_clock::now();
+        
+        // Remove finished sounds
+        activeSounds_.erase(
+            std::remove_if(activeSounds_.begin(), activeSounds_.end(),
+                [&now](const SoundInstance& instance) {
+                    // Check if sound is finished or expired
+                    return !instance.voice->isPlaying() ||
+                           now >= instance.expirationTime;
+                }),
+            activeSounds_.end()
+        );
+    }
+    
+    // Let go of the buffers finished mixer voices still reference, so pack switches can free them
+    backend_->releaseFinishedVoices();
 }
 
 void SFMLSoundPlayer::setVolume(int volume)
@@ -281,9 +870,9 @@ void SFMLSoundPlayer::setVolume(int volume)
     volume_ = std::clamp(volume, 0, 100);
     
     // Update volume for all active sounds
-    std::lock_guard<std::mutex> lock(soundsMutex_);
+    std::lock_guard<ProfiledMutex> lock(soundsMutex_);
     for (auto& instance : activeSounds_) {
-        instance.sound->setVolume(static_cast<float>(volume_));
+        instance.voice->setVolume(static_cast<float>(volume_));
     }
 }
 
@@ -292,19 +881,149 @@ int SFMLSoundPlayer::getVolume() const
     return volume_;
 }
 
+bool SFMLSoundPlayer::setEffects(const BusEffectSettings &settings)
+{
+    // Prepared on this thread; the device thread picks it up at its next period
+    return opened_ && backend_->configureEffects(settings);
+}
+
+void SFMLSoundPlayer::setIdleTimeout(std::chrono::milliseconds timeout)
+{
+    idleTimeoutMs_ = std::max<long long>(0, timeout.count());
+}
+
+void SFMLSoundPlayer::setKeepDeviceWarm(bool keepWarm)
+{
+    keepDeviceWarm_ = keepWarm;
+}
+
+bool SFMLSoundPlayer::isIdle() const
+{
+    return idle_;
+}
+
+std::chrono::microseconds SFMLSoundPlayer::getLastWakeLatency() const
+{
+    return std::chrono::microseconds(lastWakeLatencyUs_.load());
+}
+
+std::uint64_t SFMLSoundPlayer::getWakeupCount() const
+{
+    return wakeupCount_;
+}
+
+std::uint64_t SFMLSoundPlayer::getDroppedCount() const
+{
+    return soundsDropped_;
+}
+
+SoundMemoryUsage SFMLSoundPlayer::getMemoryUsage() const
+{
+    SoundMemoryUsage usage;
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        usage.cachedBuffers = soundBuffers_.size();
+        std::unordered_set<const sf::SoundBuffer *> counted;
+        for (const auto &[path, buffer] : soundBuffers_) {
+            std::size_t bytes = static_cast<std::size_t>(buffer->getSampleCount()) * sizeof(std::int16_t);
+            (counted.insert(buffer.get()).second ? usage.cachedPcmBytes : usage.dedupSavedBytes) += bytes;
+        }
+    }
+    usage.dedupHits = dedupHits_;
+    usage.residentBytes = ProcessMemory::getResidentBytes();
+    usage.peakResidentBytes = ProcessMemory::getPeakResidentBytes();
+    return usage;
+}
+
+std::string SFMLSoundPlayer::dumpMetrics()
+{
+    size_t queueDepth = 0;
+    size_t activeVoices = 0;
+    size_t cachedBuffers = 0;
+    size_t predictedBuffers = 0;
+    
+    // Each lock is held only long enough to read a size
+    {
+        std::lock_guard<ProfiledMutex> lock(queueMutex_);
+        queueDepth = pendingSounds_.size();
+    }
+    {
+        std::lock_guard<ProfiledMutex> lock(soundsMutex_);
+        activeVoices = activeSounds_.size();
+    }
+    {
+        std::lock_guard<ProfiledMutex> lock(cacheMutex_);
+        cachedBuffers = soundBuffers_.size();
+        predictedBuffers = predictedPaths_.size();
+    }
+    
+    std::ostringstream out;
+    out << "backend=" << (opened_ ? backend_->getName() : std::string("closed")) << "\n"
+        << "backend_latency=" << (opened_ ? backend_->describeLatency() : std::string("n/a")) << "\n"
+        << "volume=" << volume_ << "\n"
+        << "idle=" << (idle_ ? 1 : 0) << "\n"
+        << "wakeups=" << wakeupCount_ << "\n"
+        << "last_wake_latency_us=" << lastWakeLatencyUs_ << "\n"
+        << "sounds_played=" << soundsPlayed_ << "\n"
+        << "sounds_dropped=" << soundsDropped_ << "\n"
+        << "voices_stolen=" << voicesStolen_ << "\n"
+        << "armed_key_ups=" << armedHits_ << "\n"
+        << "armed_key_up_misses=" << armedMisses_ << "\n"
+        << "overload_policy=" << (backendConfig_.overloadPolicy == OverloadPolicy::DROP ? "drop" : "limit") << "\n"
+        << "cache_hits=" << cacheHits_ << "\n"
+        << "cache_misses=" << cacheMisses_ << "\n"
+        << "cached_buffers=" << cachedBuffers << "\n"
+        << "predicted_buffers=" << predictedBuffers << "\n"
+        << "queue_depth=" << queueDepth << "\n"
+        << "active_voices=" << activeVoices << "\n";
+
+    SoundMemoryUsage memory = getMemoryUsage();
+    out << "cache_pcm_bytes=" << memory.cachedPcmBytes << "\n"
+        << "rss_bytes=" << memory.residentBytes << "\n"
+        << "peak_rss_bytes=" << memory.peakResidentBytes << "\n"
+        << "dedup_hits=" << memory.dedupHits << "\n"
+        << "dedup_saved_bytes=" << memory.dedupSavedBytes << "\n"
+        << dumpLockContention();
+    return out.str();
+}
+
+std::string SFMLSoundPlayer::dumpLockContention() const
+{
+    // Where callers (the hook thread in particular) wait on the player's locks
+    std::ostringstream out;
+    const ProfiledMutex *mutexes[] = {&queueMutex_, &soundsMutex_, &cacheMutex_, &armMutex_};
+    for (const ProfiledMutex *mutex : mutexes) {
+        out << mutex->getName() << "_acquisitions=" << mutex->getAcquisitions() << "\n"
+            << mutex->getName() << "_contended=" << mutex->getContended() << "\n"
+            << mutex->getName() << "_wait_p99_ns=" << mutex->getWaitTime().getPercentile(99) << "\n"
+            << mutex->getName() << "_wait_max_ns=" << mutex->getWaitTime().getMax() << "\n"
+            << mutex->getName() << "_hold_p99_ns=" << mutex->getHoldTime().getPercentile(99) << "\n"
+            << mutex->getName() << "_hold_max_ns=" << mutex->getHoldTime().getMax() << "\n";
+    }
+    return out.str();
+}
+
+std::string SFMLSoundPlayer::dumpLatencyHistograms() const
+{
+    return queueLatency_.format() + decodeLatency_.format() +
+           queueMutex_.format() + soundsMutex_.format() + cacheMutex_.format() + armMutex_.format();
+}
+
 void SFMLSoundPlayer::stopAllSounds()
 {
     // Clear pending sounds queue
     {
-        std::lock_guard<std::mutex> lock(queueMutex_);
+        std::lock_guard<ProfiledMutex> lock(queueMutex_);
         pendingSounds_.clear();
     }
     
+    releaseArmedVoices();
+    
     // Stop all active sounds
     {
-        std::lock_guard<std::mutex> lock(soundsMutex_);
+        std::lock_guard<ProfiledMutex> lock(soundsMutex_);
         for (auto& instance : activeSounds_) {
-            instance.sound->stop();
+            instance.voice->stop();
         }
         activeSounds_.clear();
     }
@@ -0,0 +1,168 @@
+/**
+ * @file SFMLStreamBackend.cpp
+ * @brief Implementation of the SFMLStreamBackend class
+ */
+#include "SFMLStreamBackend.h"
+#include "SFMLSoundBackend.h"
+#include <algorithm>
+#include <sstream>
+
+SFMLStreamBackend::MixerStream::MixerStream(SoftwareMixer &mixer, unsigned int periodFrames)
+    : mixer_(mixer),
+      period_(static_cast<std::size_t>(periodFrames) * SoftwareMixer::CHANNELS, 0)
+{
+    initialize(SoftwareMixer::CHANNELS, mixer_.getSampleRate(),
+               {sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight});
+}
+
+bool SFMLStreamBackend::MixerStream::onGetData(Chunk &data)
+{
+    // Called on SFML's audio thread: render exactly one period
+    mixer_.render(period_.data(), period_.size() / SoftwareMixer::CHANNELS);
+    data.samples = period_.data();
+    data.sampleCount = period_.size();
+    return true;
+}
+
+void SFMLStreamBackend::MixerStream::onSeek(sf::Time /* timeOffset */)
+{
+    // A live mix cannot be seeked
+}
+
+SFMLStreamBackend::SFMLStreamBackend()
+    : periodFrames_(0)
+{
+}
+
+SFMLStreamBackend::~SFMLStreamBackend()
+{
+    close();
+}
+
+bool SFMLStreamBackend::open(const AudioBackendConfig &config)
+{
+    close();
+
+    if (!selectSFMLPlaybackDevice(config.device)) {
+        return false;
+    }
+
+    periodFrames_ = std::clamp<unsigned int>(config.periodFrames, 32,
+                                             static_cast<unsigned int>(SoftwareMixer::MAX_PERIOD_FRAMES));
+    mixer_ = std::make_unique<SoftwareMixer>(config.sampleRate);
+    mixer_->configureEffects(config.effects);
+    stream_ = std::make_unique<MixerStream>(*mixer_, periodFrames_);
+    stream_->play();
+    return true;
+}
+
+void SFMLStreamBackend::close()
+{
+    if (stream_) {
+        stream_->stop();
+        stream_.reset();
+    }
+    mixer_.reset();
+}
+
+void SFMLStreamBackend::suspend()
+{
+    if (stream_) {
+        mixer_->stopAllVoices();
+        stream_->pause();
+    }
+}
+
+void SFMLStreamBackend::resume()
+{
+    if (stream_ && stream_->getStatus() != sf::SoundStream::Status::Playing) {
+        stream_->play();
+    }
+}
+
+std::shared_ptr<AudioVoice> SFMLStreamBackend::startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                                          std::chrono::steady_clock::time_point onset)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->startVoice(buffer, volume, onset);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> SFMLStreamBackend::startSynthVoice(const ClickParams &params, float volume,
+                                                               std::chrono::steady_clock::time_point onset)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->startSynthVoice(params, volume, onset);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> SFMLStreamBackend::armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->armVoice(buffer, volume);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+std::shared_ptr<AudioVoice> SFMLStreamBackend::armSynthVoice(const ClickParams &params, float volume)
+{
+    if (!mixer_) {
+        return nullptr;
+    }
+
+    std::int64_t handle = mixer_->armSynthVoice(params, volume);
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    return std::make_shared<MixerVoice>(*mixer_, handle);
+}
+
+bool SFMLStreamBackend::configureEffects(const BusEffectSettings &settings)
+{
+    return mixer_ && mixer_->configureEffects(settings);
+}
+
+void SFMLStreamBackend::releaseFinishedVoices()
+{
+    if (mixer_) {
+        mixer_->releaseFinishedVoices();
+    }
+}
+
+std::string SFMLStreamBackend::getName() const
+{
+    return "sfml-stream";
+}
+
+std::string SFMLStreamBackend::describeLatency() const
+{
+    if (!mixer_) {
+        return "closed";
+    }
+
+    std::ostringstream out;
+    out << periodFrames_ << " frames per period at " << mixer_->getSampleRate() << " Hz ("
+        << (periodFrames_ * 1000.0 / mixer_->getSampleRate()) << " ms) on top of the SFML device period";
+    return out.str();
+}
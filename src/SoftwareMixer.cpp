@@ -0,0 +1,414 @@
+/**
+ * @file SoftwareMixer.cpp
+ * @brief Implementation of the SoftwareMixer class
+ */
+#include "SoftwareMixer.h"
+#include "TelemetryRing.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int SLOT_BITS = 8;
+constexpr std::int64_t SLOT_MASK = (1 << SLOT_BITS) - 1;
+
+// Share of the render call timing error folded into the frame clock per period
+constexpr double CLOCK_SMOOTHING = 0.05;
+// Errors beyond this many periods (a stalled or restarted device) resynchronize the clock
+constexpr double CLOCK_RESYNC_PERIODS = 4.0;
+constexpr double MIN_RESYNC_NS = 20e6;
+// Onsets further ahead than this are taken as clock mix-ups and played at once
+constexpr double MAX_ONSET_DELAY_SECONDS = 1.0;
+
+double toNanoseconds(std::chrono::steady_clock::time_point time)
+{
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+std::int64_t makeHandle(std::size_t slot, std::uint32_t generation)
+{
+    return (static_cast<std::int64_t>(generation) << SLOT_BITS) | static_cast<std::int64_t>(slot);
+}
+
+std::uint32_t handleGeneration(std::int64_t handle)
+{
+    return static_cast<std::uint32_t>(handle >> SLOT_BITS);
+}
+
+// A voice's control word: generation in the high half, state in the low half
+std::uint64_t makeControl(std::uint32_t generation, int state)
+{
+    return (static_cast<std::uint64_t>(generation) << 32) | static_cast<std::uint32_t>(state);
+}
+
+std::uint32_t controlGeneration(std::uint64_t control)
+{
+    return static_cast<std::uint32_t>(control >> 32);
+}
+
+int controlState(std::uint64_t control)
+{
+    return static_cast<int>(control & 0xFFFFFFFFu);
+}
+
+} // namespace
+
+SoftwareMixer::SoftwareMixer(unsigned int sampleRate)
+    : sampleRate_(sampleRate > 0 ? sampleRate : 44100),
+      mixBuffer_(MAX_PERIOD_FRAMES * CHANNELS, 0.0f),
+      effects_(sampleRate_),
+      clockNs_(0.0),
+      clockValid_(false),
+      lateOnsets_(0)
+{
+}
+
+void SoftwareMixer::releaseFreeBuffers()
+{
+    for (auto &voice : voices_) {
+        if (voice.buffer && controlState(voice.control.load(std::memory_order_acquire)) == VOICE_FREE) {
+            voice.buffer.reset();
+        }
+    }
+}
+
+void SoftwareMixer::releaseFinishedVoices()
+{
+    std::lock_guard<std::mutex> lock(startMutex_);
+    releaseFreeBuffers();
+}
+
+template <typename Setup>
+std::int64_t SoftwareMixer::claimVoice(float volume, std::chrono::steady_clock::time_point onset, VoiceState state,
+                                       Setup setup)
+{
+    std::lock_guard<std::mutex> lock(startMutex_);
+
+    // Slots above the one claimed here may not be reused for a long time
+    releaseFreeBuffers();
+
+    for (std::size_t slot = 0; slot < MAX_VOICES; ++slot) {
+        Voice &voice = voices_[slot];
+        std::uint64_t control = voice.control.load(std::memory_order_acquire);
+        if (controlState(control) != VOICE_FREE) {
+            continue;
+        }
+
+        // The device thread has released this slot, so its fields are ours to rewrite
+        setup(voice);
+        voice.onsetNs = onset == std::chrono::steady_clock::time_point{}
+                            ? 0
+                            : std::chrono::duration_cast<std::chrono::nanoseconds>(onset.time_since_epoch()).count();
+        voice.gain.store(std::clamp(volume, 0.0f, 100.0f) / 100.0f, std::memory_order_relaxed);
+        std::uint32_t generation = controlGeneration(control) + 1;
+
+        // Only claims leave the free state, and they are serialized, so a plain store is enough
+        voice.control.store(makeControl(generation, state), std::memory_order_release);
+        return makeHandle(slot, generation);
+    }
+
+    return -1;
+}
+
+std::int64_t SoftwareMixer::claimBufferVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                             std::chrono::steady_clock::time_point onset, VoiceState state)
+{
+    if (!buffer || buffer->getSampleCount() == 0 || buffer->getChannelCount() == 0) {
+        return -1;
+    }
+
+    return claimVoice(volume, onset, state, [this, &buffer, state](Voice &voice) {
+        voice.synth = false;
+        voice.buffer = buffer;
+        voice.samples = buffer->getSamples();
+        voice.channels = buffer->getChannelCount();
+        voice.frameCount = buffer->getSampleCount() / voice.channels;
+        voice.step = static_cast<double>(buffer->getSampleRate()) / static_cast<double>(sampleRate_);
+        voice.position = 0.0;
+
+        // An armed voice reads its first period now, so the device thread does not fault it in later
+        if (state == VOICE_ARMED) {
+            std::size_t count = static_cast<std::size_t>(
+                std::min<std::uint64_t>(voice.frameCount, PRIME_FRAMES) * voice.channels);
+            std::uint32_t sum = 0;
+            for (std::size_t i = 0; i < count; i += PRIME_STRIDE) {
+                sum += static_cast<std::uint16_t>(voice.samples[i]);
+            }
+            primeSink_ += sum;
+        }
+    });
+}
+
+std::int64_t SoftwareMixer::claimSynthVoice(const ClickParams &params, float volume,
+                                            std::chrono::steady_clock::time_point onset, VoiceState state)
+{
+    return claimVoice(volume, onset, state, [this, &params](Voice &voice) {
+        voice.synth = true;
+        voice.buffer.reset();
+        voice.click.start(params, sampleRate_);
+    });
+}
+
+std::int64_t SoftwareMixer::startVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume,
+                                       std::chrono::steady_clock::time_point onset)
+{
+    return claimBufferVoice(buffer, volume, onset, VOICE_PLAYING);
+}
+
+std::int64_t SoftwareMixer::startSynthVoice(const ClickParams &params, float volume,
+                                            std::chrono::steady_clock::time_point onset)
+{
+    return claimSynthVoice(params, volume, onset, VOICE_PLAYING);
+}
+
+std::int64_t SoftwareMixer::armVoice(const std::shared_ptr<sf::SoundBuffer> &buffer, float volume)
+{
+    return claimBufferVoice(buffer, volume, {}, VOICE_ARMED);
+}
+
+std::int64_t SoftwareMixer::armSynthVoice(const ClickParams &params, float volume)
+{
+    return claimSynthVoice(params, volume, {}, VOICE_ARMED);
+}
+
+bool SoftwareMixer::triggerVoice(std::int64_t handle, std::chrono::steady_clock::time_point onset)
+{
+    if (handle < 0) {
+        return false;
+    }
+
+    // Taking the slot to triggering checks generation and state in one step, so a handle whose
+    // slot was released and armed again for another key cannot start that key's voice
+    Voice &voice = voices_[static_cast<std::size_t>(handle & SLOT_MASK)];
+    std::uint32_t generation = handleGeneration(handle);
+    std::uint64_t armed = makeControl(generation, VOICE_ARMED);
+    if (!voice.control.compare_exchange_strong(armed, makeControl(generation, VOICE_TRIGGERING),
+                                               std::memory_order_acquire)) {
+        return false;
+    }
+
+    // Neither the device thread nor a claim touches a triggering slot
+    voice.onsetNs = onset == std::chrono::steady_clock::time_point{}
+                        ? 0
+                        : std::chrono::duration_cast<std::chrono::nanoseconds>(onset.time_since_epoch()).count();
+
+    // Fails if stopVoice() or stopAllVoices() cancelled the trigger in the meantime; the slot is
+    // then handed back here, since only this thread knows when it stopped writing to it
+    std::uint64_t triggering = makeControl(generation, VOICE_TRIGGERING);
+    if (!voice.control.compare_exchange_strong(triggering, makeControl(generation, VOICE_PLAYING),
+                                               std::memory_order_release, std::memory_order_relaxed)) {
+        voice.control.store(makeControl(generation, VOICE_FREE), std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+bool SoftwareMixer::releaseVoice(Voice &voice, std::uint32_t generation, bool anyGeneration)
+{
+    std::uint64_t control = voice.control.load(std::memory_order_acquire);
+    for (;;) {
+        if (!anyGeneration && controlGeneration(control) != generation) {
+            return false;
+        }
+
+        // An armed slot was never seen by the device thread and is handed straight back, a slot
+        // being triggered is handed back by triggerVoice(), and a playing one by the device thread
+        int state = controlState(control);
+        int next;
+        if (state == VOICE_ARMED) {
+            next = VOICE_FREE;
+        } else if (state == VOICE_TRIGGERING) {
+            next = VOICE_CANCELLED;
+        } else if (state == VOICE_PLAYING) {
+            next = VOICE_STOPPING;
+        } else {
+            return false;
+        }
+
+        if (voice.control.compare_exchange_weak(control, makeControl(controlGeneration(control), next),
+                                                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return true;
+        }
+    }
+}
+
+void SoftwareMixer::stopVoice(std::int64_t handle)
+{
+    if (handle < 0) {
+        return;
+    }
+
+    releaseVoice(voices_[static_cast<std::size_t>(handle & SLOT_MASK)], handleGeneration(handle), false);
+}
+
+void SoftwareMixer::stopAllVoices()
+{
+    for (auto &voice : voices_) {
+        releaseVoice(voice, 0, true);
+    }
+}
+
+bool SoftwareMixer::isVoicePlaying(std::int64_t handle) const
+{
+    if (handle < 0) {
+        return false;
+    }
+
+    const Voice &voice = voices_[static_cast<std::size_t>(handle & SLOT_MASK)];
+    return voice.control.load(std::memory_order_acquire) == makeControl(handleGeneration(handle), VOICE_PLAYING);
+}
+
+void SoftwareMixer::setVoiceVolume(std::int64_t handle, float volume)
+{
+    if (handle < 0) {
+        return;
+    }
+
+    Voice &voice = voices_[static_cast<std::size_t>(handle & SLOT_MASK)];
+    if (controlGeneration(voice.control.load(std::memory_order_relaxed)) == handleGeneration(handle)) {
+        voice.gain.store(std::clamp(volume, 0.0f, 100.0f) / 100.0f, std::memory_order_relaxed);
+    }
+}
+
+void SoftwareMixer::render(std::int16_t *out, std::size_t frames)
+{
+    TraceSpan span("mix_period", "voices");
+    float peak = 0.0f;
+    std::uint32_t activeVoices = 0;
+
+    // Advance the frame clock towards the time this period is asked for
+    const double frameNs = 1e9 / static_cast<double>(sampleRate_);
+    const double periodNs = static_cast<double>(frames) * frameNs;
+    const double now = toNanoseconds(std::chrono::steady_clock::now());
+    const double error = now - clockNs_;
+    if (!clockValid_ || std::fabs(error) > std::max(CLOCK_RESYNC_PERIODS * periodNs, MIN_RESYNC_NS)) {
+        clockNs_ = now;
+        clockValid_ = true;
+    } else {
+        clockNs_ += CLOCK_SMOOTHING * error;
+    }
+
+    // Render in chunks that fit the preallocated accumulator
+    while (frames > 0) {
+        std::size_t chunk = std::min(frames, MAX_PERIOD_FRAMES);
+        activeVoices = std::max(activeVoices, mixVoices(chunk, clockNs_));
+        clockNs_ += static_cast<double>(chunk) * frameNs;
+        effects_.process(mixBuffer_.data(), chunk);
+
+        for (std::size_t i = 0; i < chunk * CHANNELS; ++i) {
+            float sample = std::clamp(mixBuffer_[i], -1.0f, 1.0f);
+            peak = std::max(peak, std::fabs(sample));
+            out[i] = static_cast<std::int16_t>(std::lrint(sample * 32767.0f));
+        }
+
+        out += chunk * CHANNELS;
+        frames -= chunk;
+    }
+
+    span.setArg(activeVoices);
+
+    // Meter only audible periods so an idle stream does not flood the ring
+    if (activeVoices > 0) {
+        TelemetryRing::publish(TelemetryType::VOICE_LEVEL, activeVoices, peak);
+    }
+}
+
+std::uint32_t SoftwareMixer::mixVoices(std::size_t frames, double startNs)
+{
+    std::fill(mixBuffer_.begin(), mixBuffer_.begin() + frames * CHANNELS, 0.0f);
+    std::uint32_t mixed = 0;
+
+    constexpr float SCALE = 1.0f / 32768.0f;
+
+    for (auto &voice : voices_) {
+        std::uint64_t control = voice.control.load(std::memory_order_acquire);
+        int state = controlState(control);
+        if (state == VOICE_STOPPING) {
+            voice.control.store(makeControl(controlGeneration(control), VOICE_FREE), std::memory_order_release);
+            continue;
+        }
+        if (state != VOICE_PLAYING) {
+            continue;
+        }
+
+        // Finishing may overwrite a concurrent move to stopping; either way the slot ends up free
+        const std::uint64_t finished = makeControl(controlGeneration(control), VOICE_FREE);
+
+        // A voice with an onset waits for the block holding it and starts at its sample
+        std::size_t offset = 0;
+        if (voice.onsetNs != 0) {
+            double onsetFrame = (static_cast<double>(voice.onsetNs) - startNs) * sampleRate_ / 1e9;
+            if (onsetFrame >= static_cast<double>(frames) && onsetFrame < MAX_ONSET_DELAY_SECONDS * sampleRate_) {
+                continue;
+            }
+            if (onsetFrame < -1.0) {
+                lateOnsets_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (onsetFrame > 0.0 && onsetFrame < static_cast<double>(frames)) {
+                offset = std::min(static_cast<std::size_t>(std::lround(onsetFrame)), frames - 1);
+            }
+            voice.onsetNs = 0;
+        }
+
+        ++mixed;
+        float *target = mixBuffer_.data() + offset * CHANNELS;
+        const std::size_t count = frames - offset;
+        if (voice.synth) {
+            // Synthesized straight into the accumulator, no samples behind it
+            if (!voice.click.render(target, count, voice.gain.load(std::memory_order_relaxed))) {
+                voice.control.store(finished, std::memory_order_release);
+            }
+            continue;
+        }
+
+        const float gain = voice.gain.load(std::memory_order_relaxed) * SCALE;
+        const unsigned int channels = voice.channels;
+        const std::uint64_t lastFrame = voice.frameCount - 1;
+        double position = voice.position;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint64_t index = static_cast<std::uint64_t>(position);
+            if (index >= voice.frameCount) {
+                break;
+            }
+
+            // Linear interpolation between neighbouring source frames
+            std::uint64_t next = std::min(index + 1, lastFrame);
+            float frac = static_cast<float>(position - static_cast<double>(index));
+            const std::int16_t *a = voice.samples + index * channels;
+            const std::int16_t *b = voice.samples + next * channels;
+
+            float left = a[0] + (b[0] - a[0]) * frac;
+            float right = channels > 1 ? a[1] + (b[1] - a[1]) * frac : left;
+
+            target[i * CHANNELS] += left * gain;
+            target[i * CHANNELS + 1] += right * gain;
+
+            position += voice.step;
+        }
+
+        voice.position = position;
+        if (static_cast<std::uint64_t>(position) >= voice.frameCount) {
+            voice.control.store(finished, std::memory_order_release);
+        }
+    }
+
+    return mixed;
+}
+
+bool SoftwareMixer::configureEffects(const BusEffectSettings &settings)
+{
+    return effects_.configure(settings);
+}
+
+unsigned int SoftwareMixer::getSampleRate() const
+{
+    return sampleRate_;
+}
+
+std::uint64_t SoftwareMixer::getLateOnsetCount() const
+{
+    return lateOnsets_.load(std::memory_order_relaxed);
+}
@@ -3,31 +3,26 @@
  * @brief Implementation of the SoundManager class
  */
 #include "SoundManager.h"
-#include "Utils.h"
+#include "ClickSynth.h"
+#include "EmbeddedPack.h"
+#include "Logger.h"
+#include "Tracer.h"
 #include <filesystem>
-#include <iostream>
 #include <random>
 #include <algorithm>
 
 SoundManager::SoundManager(const std::string &folder) : folderPath_(folder)
 {
     // Initialize key mappings
-    keyMappings_[VK_SPACE] = KeyType::SPACE;
-    keyMappings_[VK_RETURN] = KeyType::ENTER;
-    keyMappings_[VK_MENU] = KeyType::ALT; // Alt key
-
-    // Initialize categories map
-    categories_[KeyType::ALPHA] = SoundCategory();
-    categories_[KeyType::ALT] = SoundCategory();
-    categories_[KeyType::ENTER] = SoundCategory();
-    categories_[KeyType::SPACE] = SoundCategory();
-    categories_[KeyType::OTHER] = SoundCategory();
+    keyMappings_[0x20] = KeyType::SPACE; // VK_SPACE
+    keyMappings_[0x0D] = KeyType::ENTER; // VK_RETURN
+    keyMappings_[0x12] = KeyType::ALT;   // VK_MENU, the Alt key
 }
 
-bool SoundManager::loadSoundCategory(const std::string &categoryName, SoundCategory &cat)
+bool SoundManager::loadSoundCategory(const std::string &folder, const std::string &categoryName, SoundCategory &cat)
 {
-    std::string downPath = folderPath_ + "/" + categoryName + "/down";
-    std::string upPath = folderPath_ + "/" + categoryName + "/up";
+    std::string downPath = folder + "/" + categoryName + "/down";
+    std::string upPath = folder + "/" + categoryName + "/up";
 
     // Clear existing sounds
     cat.down.clear();
@@ -51,7 +46,7 @@ bool SoundManager::loadSoundCategory(const std::string &categoryName, SoundCateg
         }
         else
         {
-            std::cerr << "Directory not found or not accessible: " << downPath << std::endl;
+            KS_LOG_WARNING("Directory not found or not accessible: " << downPath);
         }
 
         // Load up sounds
@@ -68,37 +63,68 @@ bool SoundManager::loadSoundCategory(const std::string &categoryName, SoundCateg
         }
         else
         {
-            std::cerr << "Directory not found or not accessible: " << upPath << std::endl;
+            KS_LOG_WARNING("Directory not found or not accessible: " << upPath);
         }
     }
     catch (const std::filesystem::filesystem_error &e)
     {
-        std::cerr << "Error loading category '" << categoryName << "': " << e.what() << std::endl;
+        KS_LOG_ERROR("Error loading category '" << categoryName << "': " << e.what());
         return false;
     }
 
     return foundFiles;
 }
 
-bool SoundManager::loadSounds()
+bool SoundManager::loadEmbeddedCategory(const std::string &categoryName, SoundCategory &cat)
 {
-    // Print the current folder path for debugging
-    std::cerr << "Loading sounds from: " << folderPath_ << std::endl;
-    
-    // Check if the path exists
-    if (!std::filesystem::exists(folderPath_))
+    cat.down.clear();
+    cat.up.clear();
+
+    for (std::size_t i = 0; i < EmbeddedPack::getSoundCount(); ++i)
     {
-        std::cerr << "Error: Sound pack directory does not exist: " << folderPath_ << std::endl;
-        return false;
+        const EmbeddedSound &sound = EmbeddedPack::getSound(i);
+        if (categoryName == sound.category)
+        {
+            (sound.keyDown ? cat.down : cat.up).push_back(EmbeddedPack::getSoundPath(i));
+        }
     }
-    
-    // Clear all categories
-    for (auto &[type, category] : categories_)
+
+    return !cat.down.empty() || !cat.up.empty();
+}
+
+bool SoundManager::loadSynthCategory(const std::string &categoryName, SoundCategory &cat)
+{
+    cat.down.clear();
+    cat.up.clear();
+
+    for (std::size_t i = 0; i < ClickSynth::VARIANTS; ++i)
     {
-        category.down.clear();
-        category.up.clear();
+        cat.down.push_back(ClickSynth::getSoundPath(categoryName, true, i));
+        cat.up.push_back(ClickSynth::getSoundPath(categoryName, false, i));
     }
 
+    return true;
+}
+
+std::shared_ptr<SoundPack> SoundManager::scanPack(const std::string &folder)
+{
+    TraceSpan span("pack_load");
+
+    bool embedded = EmbeddedPack::isEmbeddedPath(folder);
+    bool synth = ClickSynth::isSynthPath(folder);
+
+    // Check if the path exists
+    bool exists = embedded ? folder == EmbeddedPack::getFolderPath()
+                           : synth ? folder == ClickSynth::getFolderPath() : std::filesystem::exists(folder);
+    if (!exists)
+    {
+        KS_LOG_ERROR("Sound pack directory does not exist: " << folder);
+        return nullptr;
+    }
+
+    auto pack = std::make_shared<SoundPack>();
+    pack->folderPath = folder;
+
     // Map from KeyType to category name
     const std::unordered_map<KeyType, std::string> categoryNames = {
         {KeyType::ALPHA, "alpha"},
@@ -112,37 +138,137 @@ bool SoundManager::loadSounds()
     // Load each category
     for (const auto &[type, name] : categoryNames)
     {
-        bool result = loadSoundCategory(name, categories_[type]);
+        bool result = embedded ? loadEmbeddedCategory(name, pack->categories[type])
+                      : synth  ? loadSynthCategory(name, pack->categories[type])
+                               : loadSoundCategory(folder, name, pack->categories[type]);
         anySuccess |= result;
-        std::cerr << "Loading category '" << name << "': " << (result ? "success" : "failed") << std::endl;
+        KS_LOG_DEBUG("Loading category '" << name << "': " << (result ? "success" : "failed"));
     }
 
     // If alpha category is empty, try to load a fallback
-    if (categories_[KeyType::ALPHA].down.empty() && categories_[KeyType::ALPHA].up.empty())
+    SoundCategory &alpha = pack->categories[KeyType::ALPHA];
+    const SoundCategory &other = pack->categories[KeyType::OTHER];
+    if (alpha.down.empty() && alpha.up.empty())
     {
         // Use "other" category as fallback if it exists
-        if (!categories_[KeyType::OTHER].down.empty() || !categories_[KeyType::OTHER].up.empty())
+        if (!other.down.empty() || !other.up.empty())
+        {
+            alpha = other;
+            KS_LOG_DEBUG("Using 'other' category as fallback for 'alpha'");
+        }
+    }
+
+    return anySuccess ? pack : nullptr;
+}
+
+bool SoundManager::loadSounds()
+{
+    std::string folder = getFolderPath();
+
+    // Print the current folder path for debugging
+    KS_LOG_INFO("Loading sounds from: " << folder);
+
+    // Scan into a new snapshot; the previous pack stays in use if this fails
+    std::shared_ptr<const SoundPack> pack = scanPack(folder);
+    if (!pack)
+    {
+        return false;
+    }
+
+    std::atomic_store(&pack_, pack);
+    return true;
+}
+
+bool SoundManager::switchPack(const std::string &folder)
+{
+    KS_LOG_INFO("Switching sound pack to: " << folder);
+
+    std::shared_ptr<const SoundPack> pack = scanPack(folder);
+    if (!pack)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(folderMutex_);
+    folderPath_ = folder;
+    std::atomic_store(&pack_, pack);
+    return true;
+}
+
+bool SoundManager::refreshCategories(const std::string &folder, const std::vector<std::string> &categoryNames)
+{
+    if (EmbeddedPack::isEmbeddedPath(folder) || ClickSynth::isSynthPath(folder))
+    {
+        return false;
+    }
+
+    const std::unordered_map<std::string, KeyType> categoryTypes = {
+        {"alpha", KeyType::ALPHA},
+        {"alt", KeyType::ALT},
+        {"enter", KeyType::ENTER},
+        {"space", KeyType::SPACE},
+        {"other", KeyType::OTHER}};
+
+    std::shared_ptr<const SoundPack> current = std::atomic_load(&pack_);
+    while (current && current->folderPath == folder)
+    {
+        // Copy the snapshot; untouched categories keep their lists
+        auto pack = std::make_shared<SoundPack>(*current);
+        bool alphaTouched = false;
+        for (const auto &name : categoryNames)
+        {
+            auto type = categoryTypes.find(name);
+            if (type == categoryTypes.end())
+            {
+                continue;
+            }
+            loadSoundCategory(folder, name, pack->categories[type->second]);
+            alphaTouched |= type->second == KeyType::ALPHA || type->second == KeyType::OTHER;
+        }
+
+        // Reapply the 'other' fallback from the real alpha listing
+        if (alphaTouched)
+        {
+            SoundCategory &alpha = pack->categories[KeyType::ALPHA];
+            loadSoundCategory(folder, "alpha", alpha);
+            if (alpha.down.empty() && alpha.up.empty())
+            {
+                alpha = pack->categories[KeyType::OTHER];
+            }
+        }
+
+        // Publish unless a pack switch won the race; then retry against the new snapshot
+        std::shared_ptr<const SoundPack> published = pack;
+        if (std::atomic_compare_exchange_strong(&pack_, &current, published))
         {
-            categories_[KeyType::ALPHA] = categories_[KeyType::OTHER];
-            std::cerr << "Using 'other' category as fallback for 'alpha'" << std::endl;
+            KS_LOG_INFO("Refreshed " << categoryNames.size() << " categories of " << folder);
+            return true;
         }
     }
 
-    return anySuccess;
+    return false;
 }
 
-std::string SoundManager::getRandomSoundForKey(WORD vkCode, bool keyDown) const
+std::string SoundManager::getRandomSoundForKey(std::uint16_t vkCode, bool keyDown) const
 {
     // Get the key type for this virtual key code
     KeyType keyType = getKeyTypeForVkCode(vkCode);
 
+    // Hold the snapshot for the duration of the lookup
+    std::shared_ptr<const SoundPack> pack = std::atomic_load(&pack_);
+    if (!pack)
+    {
+        // No pack loaded yet
+        return "";
+    }
+
     // Get the appropriate sound category
-    auto it = categories_.find(keyType);
-    if (it == categories_.end())
+    auto it = pack->categories.find(keyType);
+    if (it == pack->categories.end())
     {
         // Fallback to ALPHA category
-        it = categories_.find(KeyType::ALPHA);
-        if (it == categories_.end())
+        it = pack->categories.find(KeyType::ALPHA);
+        if (it == pack->categories.end())
         {
             // No sounds available
             return "";
@@ -155,9 +281,8 @@ std::string SoundManager::getRandomSoundForKey(WORD vkCode, bool keyDown) const
     // Return a random sound
     if (!sounds.empty())
     {
-        // Use a proper random number generator
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
+        // Use a proper random number generator (one per input thread)
+        thread_local std::mt19937 gen(std::random_device{}());
 
         std::uniform_int_distribution<> distrib(0, static_cast<int>(sounds.size()) - 1);
         return sounds[distrib(gen)];
@@ -168,20 +293,27 @@ std::string SoundManager::getRandomSoundForKey(WORD vkCode, bool keyDown) const
 
 void SoundManager::setFolderPath(const std::string &newFolder)
 {
+    std::lock_guard<std::mutex> lock(folderMutex_);
     folderPath_ = newFolder;
 }
 
-const std::string &SoundManager::getFolderPath() const
+std::string SoundManager::getFolderPath() const
 {
+    std::lock_guard<std::mutex> lock(folderMutex_);
     return folderPath_;
 }
 
-void SoundManager::addKeyMapping(WORD vkCode, KeyType type)
+std::shared_ptr<const SoundPack> SoundManager::getCurrentPack() const
+{
+    return std::atomic_load(&pack_);
+}
+
+void SoundManager::addKeyMapping(std::uint16_t vkCode, KeyType type)
 {
     keyMappings_[vkCode] = type;
 }
 
-KeyType SoundManager::getKeyTypeForVkCode(WORD vkCode) const
+KeyType SoundManager::getKeyTypeForVkCode(std::uint16_t vkCode) const
 {
     auto it = keyMappings_.find(vkCode);
     if (it != keyMappings_.end())
@@ -0,0 +1,201 @@
+/**
+ * @file StartupOrchestrator.cpp
+ * @brief Implementation of the StartupOrchestrator class
+ */
+#include "StartupOrchestrator.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+StartupOrchestrator::StartupOrchestrator(Clock::time_point origin)
+    : origin_(origin)
+{
+}
+
+void StartupOrchestrator::addTask(const std::string &name, const std::vector<std::string> &dependencies,
+                                  Affinity affinity, Task task)
+{
+    Node node;
+    node.name = name;
+    node.affinity = affinity;
+    node.task = std::move(task);
+
+    for (const auto &dependency : dependencies) {
+        auto it = std::find_if(nodes_.begin(), nodes_.end(),
+                               [&dependency](const Node &other) { return other.name == dependency; });
+        if (it == nodes_.end()) {
+            throw std::invalid_argument("unknown startup dependency '" + dependency + "'");
+        }
+        node.dependencies.push_back(static_cast<std::size_t>(it - nodes_.begin()));
+    }
+
+    nodes_.push_back(std::move(node));
+}
+
+bool StartupOrchestrator::run(const std::function<void()> &pump, std::chrono::milliseconds pumpInterval)
+{
+    std::vector<std::future<void>> workers;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        std::vector<std::size_t> callerTasks;
+        std::vector<std::size_t> workerTasks;
+        std::size_t changed = schedule(callerTasks, workerTasks);
+
+        for (std::size_t index : workerTasks) {
+            workers.push_back(std::async(std::launch::async, [this, index]() {
+                Tracer::setThreadName("startup");
+                bool succeeded = false;
+                try {
+                    TraceSpan span("startup_task", "index", static_cast<std::int64_t>(index));
+                    succeeded = nodes_[index].task();
+                } catch (const std::exception &e) {
+                    KS_LOG_ERROR("Startup task '" << nodes_[index].name << "' threw: " << e.what());
+                }
+                finish(index, succeeded);
+            }));
+        }
+
+        if (!callerTasks.empty()) {
+            lock.unlock();
+            for (std::size_t index : callerTasks) {
+                bool succeeded = false;
+                try {
+                    TraceSpan span("startup_task", "index", static_cast<std::int64_t>(index));
+                    succeeded = nodes_[index].task();
+                } catch (const std::exception &e) {
+                    KS_LOG_ERROR("Startup task '" << nodes_[index].name << "' threw: " << e.what());
+                }
+                finish(index, succeeded);
+            }
+            lock.lock();
+            continue;
+        }
+
+        bool remaining = std::any_of(nodes_.begin(), nodes_.end(), [](const Node &node) {
+            return node.state == State::PENDING || node.state == State::RUNNING;
+        });
+        if (!remaining) {
+            break;
+        }
+        if (changed > 0) {
+            continue;
+        }
+
+        // Nothing runnable here: wait for a worker, keeping the caller thread serviced
+        if (pump) {
+            changed_.wait_for(lock, pumpInterval);
+            lock.unlock();
+            pump();
+            lock.lock();
+        } else {
+            changed_.wait(lock);
+        }
+    }
+
+    lock.unlock();
+    workers.clear();
+
+    bool succeeded = true;
+    for (const Node &node : nodes_) {
+        if (node.state != State::DONE) {
+            KS_LOG_ERROR("Startup task '" << node.name << "' "
+                         << (node.state == State::SKIPPED ? "skipped" : "failed"));
+            succeeded = false;
+        }
+    }
+    KS_LOG_INFO("Startup finished:\n" << formatReport());
+    return succeeded;
+}
+
+std::size_t StartupOrchestrator::schedule(std::vector<std::size_t> &callerTasks,
+                                          std::vector<std::size_t> &workerTasks)
+{
+    std::size_t changed = 0;
+    bool progress = true;
+
+    // Repeat so skips propagate through chains of dependents
+    while (progress) {
+        progress = false;
+        for (std::size_t index = 0; index < nodes_.size(); ++index) {
+            Node &node = nodes_[index];
+            if (node.state != State::PENDING) {
+                continue;
+            }
+
+            bool ready = true;
+            bool blocked = false;
+            for (std::size_t dependency : node.dependencies) {
+                State state = nodes_[dependency].state;
+                blocked = blocked || state == State::FAILED || state == State::SKIPPED;
+                ready = ready && state == State::DONE;
+            }
+
+            if (blocked) {
+                node.state = State::SKIPPED;
+            } else if (ready) {
+                node.state = State::RUNNING;
+                node.started = Clock::now();
+                (node.affinity == Affinity::CALLER ? callerTasks : workerTasks).push_back(index);
+            } else {
+                continue;
+            }
+            progress = true;
+            ++changed;
+        }
+    }
+
+    return changed;
+}
+
+void StartupOrchestrator::finish(std::size_t index, bool succeeded)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Node &node = nodes_[index];
+        node.finished = Clock::now();
+        node.state = succeeded ? State::DONE : State::FAILED;
+    }
+    changed_.notify_all();
+}
+
+StartupOrchestrator::State StartupOrchestrator::getState(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Node &node : nodes_) {
+        if (node.name == name) {
+            return node.state;
+        }
+    }
+    return State::PENDING;
+}
+
+std::chrono::microseconds StartupOrchestrator::getFinishOffset(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Node &node : nodes_) {
+        if (node.name == name && (node.state == State::DONE || node.state == State::FAILED)) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(node.finished - origin_);
+        }
+    }
+    return std::chrono::microseconds(0);
+}
+
+std::string StartupOrchestrator::formatReport() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (const Node &node : nodes_) {
+        if (node.state != State::DONE && node.state != State::FAILED) {
+            continue;
+        }
+        auto finished = std::chrono::duration_cast<std::chrono::microseconds>(node.finished - origin_);
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(node.finished - node.started);
+        out << "startup_" << node.name << "_done_ms=" << finished.count() / 1000.0 << "\n"
+            << "startup_" << node.name << "_took_ms=" << duration.count() / 1000.0 << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,439 @@
+/**
+ * @file StreamInputSource.cpp
+ * @brief Implementation of the StreamInputSource class
+ */
+#include "StreamInputSource.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utils.h"
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::size_t READ_BUFFER_SIZE = 64 * 1024;
+#ifdef _WIN32
+constexpr auto STOP_RETRY_INTERVAL = std::chrono::milliseconds(10);
+#endif
+
+bool parseKeyCode(const char *text, std::size_t length, std::uint16_t &keyCode)
+{
+    int base = 10;
+    if (length > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        text += 2;
+        length -= 2;
+    }
+    if (length == 0) {
+        return false;
+    }
+
+    unsigned int value = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        unsigned int digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<unsigned int>(c - '0');
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = static_cast<unsigned int>(c - 'a' + 10);
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = static_cast<unsigned int>(c - 'A' + 10);
+        } else {
+            return false;
+        }
+        value = value * base + digit;
+        if (value > 0xFF) {
+            return false; // Virtual-key codes are one byte
+        }
+    }
+
+    keyCode = static_cast<std::uint16_t>(value);
+    return value != 0;
+}
+
+} // namespace
+
+StreamInputSource::StreamInputSource(const std::string &endpoint, Format format)
+    : endpoint_(endpoint),
+      format_(format),
+      running_(false),
+      eventCount_(0),
+      batchCount_(0),
+#ifdef _WIN32
+      readerThread_(nullptr),
+      readerDone_(false)
+#else
+      wakeFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+#endif
+{
+}
+
+StreamInputSource::~StreamInputSource()
+{
+    stop();
+#ifndef _WIN32
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+#endif
+}
+
+bool StreamInputSource::start(EventCallback callback)
+{
+    if (running_) {
+        return false;
+    }
+
+    callback_ = std::move(callback);
+    running_ = true;
+#ifdef _WIN32
+    readerDone_ = false;
+#endif
+    thread_ = std::thread(&StreamInputSource::readLoop, this);
+    return true;
+}
+
+void StreamInputSource::stop()
+{
+    if (!running_.exchange(false)) {
+        if (thread_.joinable()) {
+            thread_.join(); // Reader already finished on its own (e.g. stdin EOF)
+        }
+#ifdef _WIN32
+        closeReaderThread();
+#endif
+        return;
+    }
+
+#ifdef _WIN32
+    // Break a blocking ReadFile/ConnectNamedPipe on the reader thread. CancelIoEx does not reliably
+    // interrupt a synchronous read of console stdin, and a cancel landing just before the reader
+    // enters the call is lost, so cancel the thread's synchronous I/O until it has left.
+    while (!readerDone_) {
+        if (HANDLE thread = static_cast<HANDLE>(readerThread_.load())) {
+            CancelSynchronousIo(thread);
+        }
+        std::this_thread::sleep_for(STOP_RETRY_INTERVAL);
+    }
+#else
+    std::uint64_t one = 1;
+    ssize_t written = write(wakeFd_, &one, sizeof(one));
+    (void)written;
+#endif
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#ifdef _WIN32
+    closeReaderThread();
+#endif
+}
+
+std::string StreamInputSource::getName() const
+{
+    return "stream(" + endpoint_ + ")";
+}
+
+std::uint64_t StreamInputSource::getEventCount() const
+{
+    return eventCount_;
+}
+
+std::uint64_t StreamInputSource::getBatchCount() const
+{
+    return batchCount_;
+}
+
+bool StreamInputSource::parseFormat(const std::string &name, Format &format)
+{
+    if (name == "text") {
+        format = Format::TEXT;
+        return true;
+    }
+    if (name == "binary") {
+        format = Format::BINARY;
+        return true;
+    }
+    return false;
+}
+
+void StreamInputSource::consume(const char *data, std::size_t size)
+{
+    auto timestamp = std::chrono::steady_clock::now();
+    batchCount_++;
+
+    if (format_ == Format::BINARY) {
+        std::size_t offset = 0;
+
+        // Complete a record split across batches
+        if (!carry_.empty() && size > 0) {
+            carry_.push_back(data[0]);
+            offset = 1;
+            consumeRecord(static_cast<std::uint16_t>(static_cast<unsigned char>(carry_[0]) |
+                                                     (static_cast<unsigned char>(carry_[1]) << 8)),
+                          timestamp);
+            carry_.clear();
+        }
+
+        for (; offset + 2 <= size; offset += 2) {
+            consumeRecord(static_cast<std::uint16_t>(static_cast<unsigned char>(data[offset]) |
+                                                     (static_cast<unsigned char>(data[offset + 1]) << 8)),
+                          timestamp);
+        }
+
+        if (offset < size) {
+            carry_.assign(data + offset, size - offset);
+        }
+        return;
+    }
+
+    std::size_t lineStart = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (data[i] != '\n') {
+            continue;
+        }
+
+        if (!carry_.empty()) {
+            carry_.append(data + lineStart, i - lineStart);
+            consumeLine(carry_.data(), carry_.size(), timestamp);
+            carry_.clear();
+        } else {
+            consumeLine(data + lineStart, i - lineStart, timestamp);
+        }
+        lineStart = i + 1;
+    }
+
+    if (lineStart < size) {
+        carry_.append(data + lineStart, size - lineStart);
+        if (carry_.size() > 256) {
+            carry_.clear(); // Not our protocol; resynchronize at the next newline
+        }
+    }
+}
+
+void StreamInputSource::consumeRecord(std::uint16_t record, std::chrono::steady_clock::time_point timestamp)
+{
+    // Same key code range as the text format
+    std::uint16_t keyCode = record & 0x7FFF;
+    if (keyCode == 0 || keyCode > 0xFF) {
+        return;
+    }
+
+    KeyEvent event;
+    event.keyCode = keyCode;
+    event.keyDown = (record & 0x8000) != 0;
+    event.timestamp = timestamp;
+    callback_(event);
+    eventCount_++;
+}
+
+void StreamInputSource::consumeLine(const char *line, std::size_t length,
+                                    std::chrono::steady_clock::time_point timestamp)
+{
+    if (length > 0 && line[length - 1] == '\r') {
+        --length;
+    }
+    if (length < 3 || line[1] != ' ') {
+        return;
+    }
+
+    KeyEvent event;
+    char action = line[0];
+    if (action == 'd' || action == 'D') {
+        event.keyDown = true;
+    } else if (action != 'u' && action != 'U') {
+        return;
+    }
+
+    if (!parseKeyCode(line + 2, length - 2, event.keyCode)) {
+        return;
+    }
+
+    event.timestamp = timestamp;
+    callback_(event);
+    eventCount_++;
+}
+
+#ifdef _WIN32
+
+void StreamInputSource::closeReaderThread()
+{
+    if (HANDLE thread = static_cast<HANDLE>(readerThread_.exchange(nullptr))) {
+        CloseHandle(thread);
+    }
+}
+
+void StreamInputSource::readLoop()
+{
+    Tracer::setThreadName("stream-input");
+
+    // A real handle to this thread, so stop() can cancel its synchronous reads
+    readerThread_.store(OpenThread(THREAD_TERMINATE, FALSE, GetCurrentThreadId()));
+
+    readEndpoint();
+    running_ = false;
+    readerDone_ = true;
+}
+
+void StreamInputSource::readEndpoint()
+{
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    bool isPipe = endpoint_.rfind("pipe:", 0) == 0;
+
+    if (endpoint_ != "stdin" && !isPipe) {
+        KS_LOG_WARNING("Unsupported input stream endpoint on Windows: " << endpoint_);
+        return;
+    }
+
+    HANDLE handle = GetStdHandle(STD_INPUT_HANDLE);
+    if (isPipe) {
+        std::wstring pipeName = L"\\\\.\\pipe\\" + Utils::toWideString(endpoint_.substr(5));
+        handle = CreateNamedPipeW(pipeName.c_str(), PIPE_ACCESS_INBOUND,
+                                  PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                  1, 0, static_cast<DWORD>(READ_BUFFER_SIZE), 0, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            DWORD error = GetLastError();
+            KS_LOG_ERROR("Failed to create input pipe " << endpoint_ << ", error " << error);
+            return;
+        }
+    }
+
+    while (running_) {
+        if (isPipe && !ConnectNamedPipe(handle, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED) {
+            break; // Cancelled by stop()
+        }
+
+        DWORD bytesRead = 0;
+        while (running_ && ReadFile(handle, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, nullptr) &&
+               bytesRead > 0) {
+            consume(buffer.data(), bytesRead);
+        }
+        carry_.clear();
+
+        if (!isPipe) {
+            break; // stdin closed
+        }
+        DisconnectNamedPipe(handle);
+    }
+
+    if (isPipe) {
+        CloseHandle(handle);
+    }
+}
+
+#else
+
+namespace {
+
+/**
+ * @brief Wait until a descriptor is readable or the wake descriptor fires
+ * @return true if fd is readable, false if woken for stop
+ */
+bool waitReadable(int fd, int wakeFd)
+{
+    pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    for (;;) {
+        int result = poll(fds, 2, -1);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        return result > 0 && fds[1].revents == 0;
+    }
+}
+
+} // namespace
+
+void StreamInputSource::readLoop()
+{
+    Tracer::setThreadName("stream-input");
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+
+    // Read one connection until EOF; returns false when stop() interrupted it
+    auto drain = [&](int fd) {
+        while (running_) {
+            if (!waitReadable(fd, wakeFd_)) {
+                return false;
+            }
+            ssize_t bytes = read(fd, buffer.data(), buffer.size());
+            if (bytes > 0) {
+                consume(buffer.data(), static_cast<std::size_t>(bytes));
+            } else if (bytes == 0 || (errno != EAGAIN && errno != EINTR)) {
+                carry_.clear();
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (endpoint_ == "stdin") {
+        drain(STDIN_FILENO);
+    } else if (endpoint_.rfind("pipe:", 0) == 0) {
+        std::string path = endpoint_.substr(5);
+        if (mkfifo(path.c_str(), 0600) < 0 && errno != EEXIST) {
+            KS_LOG_ERROR("Failed to create input FIFO " << path << ": " << std::strerror(errno));
+        }
+        // Opening read-write keeps a writer attached, so writers can come and go without EOF
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            KS_LOG_ERROR("Failed to open input FIFO " << path << ": " << std::strerror(errno));
+        } else {
+            drain(fd);
+            close(fd);
+        }
+    } else if (endpoint_.rfind("unix:", 0) == 0) {
+        std::string path = endpoint_.substr(5);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct stat existing;
+        bool exists = lstat(path.c_str(), &existing) == 0;
+        if (listenFd < 0 || path.size() >= sizeof(address.sun_path)) {
+            KS_LOG_WARNING("Invalid input socket endpoint: " << endpoint_);
+        } else if (exists && !S_ISSOCK(existing.st_mode)) {
+            KS_LOG_ERROR("Input socket path exists and is not a socket: " << path);
+        } else {
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            if (exists) {
+                unlink(path.c_str()); // Stale socket left behind by a previous run
+            }
+            if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listenFd, 4) < 0) {
+                KS_LOG_ERROR("Failed to listen on " << path << ": " << std::strerror(errno));
+            } else {
+                while (running_ && waitReadable(listenFd, wakeFd_)) {
+                    int client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0) {
+                        continue;
+                    }
+                    bool finished = drain(client);
+                    close(client);
+                    if (!finished) {
+                        break;
+                    }
+                }
+                unlink(path.c_str());
+            }
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+        }
+    } else {
+        KS_LOG_WARNING("Unsupported input stream endpoint: " << endpoint_);
+    }
+
+    running_ = false;
+}
+
+#endif
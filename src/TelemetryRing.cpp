@@ -0,0 +1,260 @@
+/**
+ * @file TelemetryRing.cpp
+ * @brief Implementation of the TelemetryRing class
+ */
+#include "TelemetryRing.h"
+#include "Logger.h"
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utils.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::uint32_t TELEMETRY_MAGIC = 0x4B535452; // "KSTR"
+constexpr std::uint32_t TELEMETRY_VERSION = 1;
+
+std::uint64_t nowNs()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+/**
+ * @brief Segment header; writeIndex gets its own cache line
+ */
+struct TelemetryRing::Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::uint32_t slotSize;
+    alignas(64) std::atomic<std::uint64_t> writeIndex;
+};
+
+/**
+ * @brief One record; sequence is 2*index+1 while written and 2*index+2 once published
+ */
+struct alignas(32) TelemetryRing::Slot
+{
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> timestampNs;
+    std::atomic<std::uint32_t> type;
+    std::atomic<std::uint32_t> code;
+    std::atomic<std::uint32_t> flags;
+    std::atomic<std::uint32_t> valueBits;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "telemetry needs lock-free 64-bit atomics");
+
+std::atomic<TelemetryRing *> TelemetryRing::global_{nullptr};
+
+TelemetryRing::TelemetryRing(void *mapping, std::size_t size, const std::string &name, bool owner, void *handle)
+    : mapping_(mapping),
+      size_(size),
+      name_(name),
+      owner_(owner),
+      handle_(handle),
+      header_(static_cast<Header *>(mapping)),
+      slots_(reinterpret_cast<Slot *>(static_cast<char *>(mapping) + sizeof(Header)))
+{
+}
+
+TelemetryRing::~TelemetryRing()
+{
+    // Never leave the global writer pointing at an unmapped segment
+    TelemetryRing *self = this;
+    global_.compare_exchange_strong(self, nullptr);
+
+#ifdef _WIN32
+    UnmapViewOfFile(mapping_);
+    CloseHandle(static_cast<HANDLE>(handle_));
+#else
+    munmap(mapping_, size_);
+    if (owner_) {
+        shm_unlink(("/" + name_).c_str());
+    }
+#endif
+}
+
+std::unique_ptr<TelemetryRing> TelemetryRing::create(const std::string &name)
+{
+    const std::size_t size = sizeof(Header) + sizeof(Slot) * CAPACITY;
+    void *mapping = nullptr;
+    void *handle = nullptr;
+
+#ifdef _WIN32
+    std::wstring mappingName = L"Local\\" + Utils::toWideString(name);
+    HANDLE file = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                     static_cast<DWORD>(size), mappingName.c_str());
+    if (file == nullptr) {
+        DWORD error = GetLastError();
+        KS_LOG_ERROR("Failed to create telemetry segment " << name << ", error " << error);
+        return nullptr;
+    }
+    mapping = MapViewOfFile(file, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    handle = file;
+#else
+    int fd = shm_open(("/" + name).c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        KS_LOG_ERROR("Failed to create telemetry segment " << name);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return nullptr;
+    }
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+#endif
+
+    // Initialize in place; readers check the magic before trusting the layout
+    std::memset(mapping, 0, size);
+    auto *header = new (mapping) Header();
+    header->capacity = CAPACITY;
+    header->slotSize = sizeof(Slot);
+    header->version = TELEMETRY_VERSION;
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    auto *slots = reinterpret_cast<Slot *>(static_cast<char *>(mapping) + sizeof(Header));
+    for (std::uint32_t i = 0; i < CAPACITY; ++i) {
+        new (&slots[i]) Slot();
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = TELEMETRY_MAGIC;
+
+    return std::unique_ptr<TelemetryRing>(new TelemetryRing(mapping, size, name, true, handle));
+}
+
+std::unique_ptr<TelemetryRing> TelemetryRing::open(const std::string &name)
+{
+    const std::size_t size = sizeof(Header) + sizeof(Slot) * CAPACITY;
+    void *mapping = nullptr;
+    void *handle = nullptr;
+
+#ifdef _WIN32
+    std::wstring mappingName = L"Local\\" + Utils::toWideString(name);
+    HANDLE file = OpenFileMappingW(FILE_MAP_READ, FALSE, mappingName.c_str());
+    if (file == nullptr) {
+        return nullptr;
+    }
+    mapping = MapViewOfFile(file, FILE_MAP_READ, 0, 0, size);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    handle = file;
+#else
+    int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+#endif
+
+    std::unique_ptr<TelemetryRing> ring(new TelemetryRing(mapping, size, name, false, handle));
+    if (ring->header_->magic != TELEMETRY_MAGIC || ring->header_->version != TELEMETRY_VERSION ||
+        ring->header_->capacity != CAPACITY || ring->header_->slotSize != sizeof(Slot)) {
+        KS_LOG_WARNING("Telemetry segment " << name << " has an incompatible layout");
+        return nullptr;
+    }
+    return ring;
+}
+
+void TelemetryRing::write(TelemetryType type, std::uint32_t code, float value, std::uint32_t flags)
+{
+    std::uint64_t index = header_->writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots_[index & (CAPACITY - 1)];
+
+    // Odd sequence marks the slot as being written
+    slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::uint32_t valueBits;
+    std::memcpy(&valueBits, &value, sizeof(valueBits));
+    slot.timestampNs.store(nowNs(), std::memory_order_relaxed);
+    slot.type.store(static_cast<std::uint32_t>(type), std::memory_order_relaxed);
+    slot.code.store(code, std::memory_order_relaxed);
+    slot.flags.store(flags, std::memory_order_relaxed);
+    slot.valueBits.store(valueBits, std::memory_order_relaxed);
+
+    slot.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::size_t TelemetryRing::read(std::uint64_t &cursor, TelemetryEvent *out, std::size_t maxEvents,
+                                std::uint64_t &lost) const
+{
+    std::uint64_t head = header_->writeIndex.load(std::memory_order_acquire);
+
+    // Skip what the writers have already lapped
+    if (head > CAPACITY && cursor < head - CAPACITY) {
+        lost += head - CAPACITY - cursor;
+        cursor = head - CAPACITY;
+    }
+
+    std::size_t count = 0;
+    while (cursor < head && count < maxEvents) {
+        const Slot &slot = slots_[cursor & (CAPACITY - 1)];
+        const std::uint64_t expected = cursor * 2 + 2;
+
+        std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before < expected) {
+            break; // Claimed but not yet published; try again on the next poll
+        }
+        if (before > expected) {
+            ++lost; // Overwritten by a newer record
+            ++cursor;
+            continue;
+        }
+
+        TelemetryEvent event;
+        event.sequence = cursor;
+        event.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+        event.type = static_cast<TelemetryType>(slot.type.load(std::memory_order_relaxed));
+        event.code = slot.code.load(std::memory_order_relaxed);
+        event.flags = slot.flags.load(std::memory_order_relaxed);
+        std::uint32_t valueBits = slot.valueBits.load(std::memory_order_relaxed);
+        std::memcpy(&event.value, &valueBits, sizeof(valueBits));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            ++lost; // Torn by a concurrent overwrite
+            ++cursor;
+            continue;
+        }
+
+        out[count++] = event;
+        ++cursor;
+    }
+
+    return count;
+}
+
+std::uint64_t TelemetryRing::getWritePosition() const
+{
+    return header_->writeIndex.load(std::memory_order_acquire);
+}
+
+void TelemetryRing::setGlobal(TelemetryRing *ring)
+{
+    global_.store(ring, std::memory_order_release);
+}
@@ -0,0 +1,170 @@
+/**
+ * @file Tracer.cpp
+ * @brief Implementation of the Tracer class
+ */
+#include "Tracer.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+/**
+ * @brief Per-thread tracer state; the ring is only allocated once tracing is used
+ */
+struct TraceThreadState
+{
+    std::shared_ptr<Tracer::ThreadBuffer> buffer;
+    char pendingName[Tracer::MAX_THREAD_NAME] = {};
+
+    ~TraceThreadState()
+    {
+        if (buffer) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+namespace {
+
+thread_local TraceThreadState threadState;
+
+void writeJsonString(std::ostream &out, const char *text)
+{
+    out << '"';
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+void writeMicroseconds(std::ostream &out, std::int64_t ns)
+{
+    // Trace-event timestamps are microseconds; keep the sub-microsecond part
+    out << ns / 1000 << '.' << static_cast<char>('0' + (ns % 1000) / 100)
+        << static_cast<char>('0' + (ns % 100) / 10) << static_cast<char>('0' + ns % 10);
+}
+
+} // namespace
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    for (auto &buffer : buffers_) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    pruneRetired();
+    dropped_.store(0, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+    KS_LOG_INFO("Tracing started");
+}
+
+bool Tracer::stop(const std::string &path)
+{
+    enabled_.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(registryMutex_);
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        KS_LOG_ERROR("Failed to write trace file " << path);
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    std::size_t written = 0;
+
+    for (auto &buffer : buffers_) {
+        if (buffer->threadName[0] != '\0') {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->threadName);
+            out << "}}";
+            first = false;
+        }
+
+        std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        for (std::uint64_t index = buffer->tail.load(std::memory_order_relaxed); index < head; ++index) {
+            const Span &span = buffer->spans[index & (THREAD_CAPACITY - 1)];
+            out << (first ? "" : ",\n") << "{\"name\":";
+            writeJsonString(out, span.name);
+            out << ",\"cat\":\"keysound\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":";
+            writeMicroseconds(out, span.beginNs);
+            out << ",\"dur\":";
+            writeMicroseconds(out, span.durationNs);
+            if (span.argName) {
+                out << ",\"args\":{";
+                writeJsonString(out, span.argName);
+                out << ':' << span.argValue << '}';
+            }
+            out << '}';
+            first = false;
+            ++written;
+        }
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    out << "\n]}\n";
+    pruneRetired();
+    KS_LOG_INFO("Wrote " << written << " trace spans to " << path << " ("
+                << dropped_.load(std::memory_order_relaxed) << " dropped)");
+    return out.good();
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    std::strncpy(threadState.pendingName, name, MAX_THREAD_NAME - 1);
+}
+
+void Tracer::record(const char *name, const char *argName, std::int64_t argValue,
+                    std::chrono::steady_clock::time_point begin,
+                    std::chrono::steady_clock::time_point end)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= THREAD_CAPACITY) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Span &span = buffer.spans[head & (THREAD_CAPACITY - 1)];
+    span.name = name;
+    span.argName = argName;
+    span.argValue = argValue;
+    span.beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count();
+    span.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::uint64_t Tracer::getDroppedCount()
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void Tracer::pruneRetired()
+{
+    // Short-lived workers (async preloads) would otherwise pin their rings
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<ThreadBuffer> &buffer) {
+                                      return buffer->retired.load(std::memory_order_acquire) &&
+                                             buffer->tail.load(std::memory_order_relaxed) ==
+                                                 buffer->head.load(std::memory_order_acquire);
+                                  }),
+                   buffers_.end());
+}
+
+Tracer::ThreadBuffer &Tracer::threadBuffer()
+{
+    if (!threadState.buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadId = nextThreadId_.fetch_add(1, std::memory_order_relaxed);
+        std::memcpy(buffer->threadName, threadState.pendingName, MAX_THREAD_NAME);
+
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        buffers_.push_back(buffer);
+        threadState.buffer = std::move(buffer);
+    }
+    return *threadState.buffer;
+}
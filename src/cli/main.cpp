@@ -0,0 +1,391 @@
+/**
+ * @file main.cpp
+ * @brief Entry point for keysound-cli, the headless keyboard sounds daemon
+ *
+ * Usage:
+ *   keysound-cli [options]
+ *
+ * Runs the engine with no window, font or other GUI resource and every
+ * setting taken from the configuration file and the command line. Once
+ * started the main thread only sleeps: on POSIX it waits for SIGINT or
+ * SIGTERM, on Windows it runs the message loop the keyboard hook needs.
+ * With --metrics the metrics report is written to a file at exit, and
+ * every --metrics-interval seconds when set.
+ */
+#include "Config.h"
+#include "Engine.h"
+#include "Logger.h"
+#include "StartupOrchestrator.h"
+#include "Tracer.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <signal.h>
+#include <pthread.h>
+#endif
+
+namespace {
+
+struct Options
+{
+    std::string configFile = "keyboard_sounds.cfg";
+    std::string soundFolder = "sounds";
+    std::string packName;
+    int volume = -1;
+    int profile = -1;
+    bool hook = false;
+    bool help = false;
+    std::vector<std::pair<std::string, std::string>> settings; // Applied over the configuration file
+    std::string metricsFile;
+    std::chrono::seconds metricsInterval{0};
+};
+
+void printUsage(std::ostream &out)
+{
+    out << "Usage: keysound-cli [options]\n"
+           "  --config <file>           configuration file (default keyboard_sounds.cfg)\n"
+           "  --sounds <folder>         sound pack folder (default sounds)\n"
+           "  --pack <name>             pack to start with, by folder name\n"
+           "  --volume <0-100>          initial volume\n"
+           "  --profile <0-3>           latency optimization level\n"
+           "  --backend <name>          audio backend, as audio.backend\n"
+           "  --input <source>          hook (Windows), evdev (Linux), stdin, pipe:<path> or unix:<path>;\n"
+           "                            repeat to combine (one stream endpoint), defaults to hook on Windows\n"
+           "  --input-format <format>   text or binary, for stream inputs\n"
+           "  --metrics <file>          write the metrics report to a file at exit\n"
+           "  --metrics-interval <s>    also rewrite it every s seconds\n"
+           "  --log-level <level>       debug, info, warning or error\n"
+           "  --log-file <file>         log file, empty for stderr\n"
+           "  --set <key>=<value>       any configuration setting\n"
+           "  --help                    show this help\n";
+}
+
+/**
+ * @brief Parse a whole decimal number within a range
+ * @return true if the text is a number between minValue and maxValue
+ */
+bool parseNumber(const std::string &text, long minValue, long maxValue, long &value)
+{
+    char *end = nullptr;
+    value = std::strtol(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0' && value >= minValue && value <= maxValue;
+}
+
+/**
+ * @brief Parse the command line
+ * @return true if the arguments are valid, false after printing the problem
+ */
+bool parseArguments(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--help") {
+            options.help = true;
+            return true;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        long number = 0;
+
+        if (flag == "--config") {
+            options.configFile = value;
+        } else if (flag == "--sounds") {
+            options.soundFolder = value;
+        } else if (flag == "--pack") {
+            options.packName = value;
+        } else if (flag == "--volume" && parseNumber(value, 0, 100, number)) {
+            options.volume = static_cast<int>(number);
+        } else if (flag == "--profile" && parseNumber(value, 0, 3, number)) {
+            options.profile = static_cast<int>(number);
+        } else if (flag == "--backend") {
+            options.settings.emplace_back("audio.backend", value);
+        } else if (flag == "--input") {
+            if (value == "hook") {
+                options.hook = true;
+            } else if (value == "evdev") {
+                options.settings.emplace_back("input.evdev", "true");
+            } else {
+                options.settings.emplace_back("input.stream", value);
+            }
+        } else if (flag == "--input-format") {
+            options.settings.emplace_back("input.streamFormat", value);
+        } else if (flag == "--metrics") {
+            options.metricsFile = value;
+        } else if (flag == "--metrics-interval" && parseNumber(value, 1, 86400, number)) {
+            options.metricsInterval = std::chrono::seconds(number);
+        } else if (flag == "--log-level") {
+            options.settings.emplace_back("log.level", value);
+        } else if (flag == "--log-file") {
+            options.settings.emplace_back("log.file", value);
+        } else if (flag == "--set" && value.find('=') != std::string::npos) {
+            auto separator = value.find('=');
+            options.settings.emplace_back(value.substr(0, separator), value.substr(separator + 1));
+        } else {
+            std::cerr << "Invalid option: " << flag << " " << value << std::endl;
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // The hook is the only way to hear the keyboard unless a source is named
+    bool namedSource = false;
+    for (const auto &[key, value] : options.settings) {
+        namedSource = namedSource || key == "input.stream" || key == "input.evdev";
+    }
+    options.hook = options.hook || !namedSource;
+#else
+    if (options.hook) {
+        std::cerr << "--input hook is only available on Windows" << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Replace the metrics file with the current report
+ */
+void writeMetrics(const Engine &engine, const std::string &path)
+{
+    // Written aside and renamed so readers never see a partial report
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << engine.dumpMetrics();
+        if (!out) {
+            KS_LOG_ERROR("Failed to write metrics to " << temporary);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        KS_LOG_ERROR("Failed to replace " << path << ": " << ec.message());
+    }
+}
+
+/**
+ * @brief Name the first startup step that did not finish
+ */
+const char *describeFailure(const StartupOrchestrator &startup)
+{
+    using State = StartupOrchestrator::State;
+    std::pair<const char *, const char *> steps[] = {
+        {"scan_packs", "No sound packs found in sounds folder."},
+        {"load_pack", "Failed to load the sound pack."},
+        {"install_hook", "Error installing keyboard hook."},
+        {"open_device", "Failed to open the audio device."},
+        {"attach_inputs", "Failed to attach the input sources."}};
+    for (const auto &[task, message] : steps) {
+        State state = startup.getState(task);
+        if (state == State::FAILED || state == State::SKIPPED) {
+            return message;
+        }
+    }
+    return "Startup failed.";
+}
+
+#ifdef _WIN32
+DWORD g_mainThreadId = 0;
+
+BOOL WINAPI onConsoleControl(DWORD /* type */)
+{
+    // Runs on a thread of its own; the message loop does the shutdown
+    PostThreadMessage(g_mainThreadId, WM_QUIT, 0, 0);
+    return TRUE;
+}
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief The signals that stop the daemon
+ */
+sigset_t stopSignals()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+}
+#endif
+
+/**
+ * @brief Run the engine until asked to stop
+ * @return Exit code
+ */
+int run(const Options &options, const AppConfig &config)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    Engine engine(options.soundFolder, config, startTime);
+    if (options.volume >= 0) {
+        engine.setVolume(options.volume);
+    }
+    if (options.profile >= 0) {
+        engine.setLatencyOptimization(options.profile);
+    }
+
+    StartupOrchestrator startup(startTime);
+    engine.addStartupTasks(startup, options.hook, options.packName);
+
+    std::function<void()> pump;
+#ifdef _WIN32
+    // Keep the hook serviced while workers run, as the window application does
+    g_mainThreadId = GetCurrentThreadId();
+    bool quitRequested = false;
+    pump = [&quitRequested]() {
+        MSG msg;
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                quitRequested = true;
+                continue;
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    };
+    SetConsoleCtrlHandler(onConsoleControl, TRUE);
+#endif
+
+    bool succeeded = startup.run(pump);
+    engine.finishStartup(startup);
+    if (!succeeded) {
+        const char *message = describeFailure(startup);
+        KS_LOG_ERROR(message);
+        std::cerr << message << std::endl;
+        return 1;
+    }
+
+    engine.startServices();
+    KS_LOG_INFO("keysound-cli running");
+
+#ifdef _WIN32
+    // The hook is called from this loop; a thread timer drives the metrics file
+    MSG msg;
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    UINT_PTR timer = 0;
+    if (!options.metricsFile.empty() && options.metricsInterval.count() > 0) {
+        timer = SetTimer(nullptr, 0, static_cast<UINT>(options.metricsInterval.count() * 1000), nullptr);
+    }
+    while (!quitRequested && GetMessage(&msg, nullptr, 0, 0)) {
+        if (msg.message == WM_TIMER && msg.hwnd == nullptr) {
+            writeMetrics(engine, options.metricsFile);
+            continue;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    if (timer) {
+        KillTimer(nullptr, timer);
+    }
+    SetConsoleCtrlHandler(onConsoleControl, FALSE);
+#else
+    // Nothing runs here while idle: a waiter thread sleeps in sigwait, this one on the condition
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    bool stopping = false;
+    std::thread waiter([&]() {
+        sigset_t signals = stopSignals();
+        int signal = 0;
+        sigwait(&signals, &signal);
+        KS_LOG_INFO("Received signal " << signal << ", shutting down");
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            stopping = true;
+        }
+        stopCondition.notify_one();
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(stopMutex);
+        while (!stopping) {
+            if (options.metricsFile.empty() || options.metricsInterval.count() == 0) {
+                stopCondition.wait(lock, [&stopping]() { return stopping; });
+                continue;
+            }
+            if (!stopCondition.wait_for(lock, options.metricsInterval, [&stopping]() { return stopping; })) {
+                lock.unlock();
+                writeMetrics(engine, options.metricsFile);
+                lock.lock();
+            }
+        }
+    }
+    waiter.join();
+#endif
+
+    if (!options.metricsFile.empty()) {
+        writeMetrics(engine, options.metricsFile);
+    }
+    engine.stopServices();
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(std::cerr);
+        return 2;
+    }
+    if (options.help) {
+        printUsage(std::cout);
+        return 0;
+    }
+
+#ifndef _WIN32
+    // Blocked before the logger or the engine start a thread, so only run()'s waiter receives them
+    sigset_t signals = stopSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+
+    // Command-line settings override the file; messages are staged until the logger starts
+    AppConfig config = AppConfig::loadFromFile(options.configFile);
+    for (const auto &[key, value] : options.settings) {
+        if (!config.set(key, value)) {
+            std::cerr << "Invalid setting: " << key << " = " << value << std::endl;
+            return 2;
+        }
+    }
+    Logger::instance().setLevel(config.logLevel);
+    Logger::instance().start(config.logFile);
+    KS_LOG_INFO("keysound-cli starting...");
+    Tracer::setThreadName("main");
+
+    if (!config.traceFile.empty()) {
+        Tracer::start();
+    }
+
+    int result = 1;
+    try {
+        result = run(options, config);
+    } catch (const std::exception &e) {
+        KS_LOG_ERROR("Exception caught: " << e.what());
+        std::cerr << e.what() << std::endl;
+    }
+
+    if (!config.traceFile.empty()) {
+        Tracer::stop(config.traceFile);
+    }
+
+    Logger::instance().stop();
+    return result;
+}
@@ -3,9 +3,9 @@
  * @brief Entry point for the keyboard sounds application
  */
 #include "Application.h"
+#include "Logger.h"
+#include "Tracer.h"
 #include <windows.h>
-#include <iostream>
-#include <fstream>
 #include <stdexcept>
 
 /**
@@ -14,28 +14,39 @@
 int WINAPI WinMain(HINSTANCE /* hInstance */, HINSTANCE /* hPrevInstance */,
                    LPSTR /* lpCmdLine */, int /* nCmdShow */)
 {
-    // Redirect stderr to a file for debugging
-    std::ofstream logFile("keyboard_sounds_debug.log");
-    if (logFile.is_open()) {
-        std::cerr.rdbuf(logFile.rdbuf());
-        std::cerr << "Keyboard Sounds application starting..." << std::endl;
+    // Configuration messages are staged until the logger starts
+    AppConfig config = AppConfig::loadFromFile("keyboard_sounds.cfg");
+    Logger::instance().setLevel(config.logLevel);
+    Logger::instance().start(config.logFile);
+    KS_LOG_INFO("Keyboard Sounds application starting...");
+
+    if (!config.traceFile.empty())
+    {
+        Tracer::start();
     }
 
+    int result = 1;
     try
     {
-        Application app("sounds");
-        return app.run();
+        Application app("sounds", config);
+        result = app.run();
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Exception caught: " << e.what() << std::endl;
+        KS_LOG_ERROR("Exception caught: " << e.what());
         MessageBoxA(NULL, e.what(), "Error", MB_ICONERROR);
-        return 1;
     }
     catch (...)
     {
-        std::cerr << "Unknown exception caught" << std::endl;
+        KS_LOG_ERROR("Unknown exception caught");
         MessageBoxA(NULL, "An unknown error occurred", "Error", MB_ICONERROR);
-        return 1;
     }
-}
\ No newline at end of file
+
+    if (!config.traceFile.empty())
+    {
+        Tracer::stop(config.traceFile);
+    }
+
+    Logger::instance().stop();
+    return result;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file burst_bench.cpp
+ * @brief Replays key bursts under both overload policies and compares drops and peak level
+ *
+ * Usage:
+ *   burst-bench [bursts] [keys-per-burst] [output-dir] [idle-seconds]
+ *
+ * Each burst rolls over keys-per-burst keys 2 ms apart, holds each for
+ * 12 ms and taps it again 20 ms after the first press, so every burst
+ * trips the 25 ms repeat and 20 ms release rules and, with enough keys,
+ * the 32 voice cap. The trace runs in real time through a KeyThrottle and
+ * an SFMLSoundPlayer on the null backend at full volume, playing the
+ * synthesized pack, once per policy:
+ *   drop  - the old defence: throttled events and voice cap drops, no limiter
+ *   limit - every event plays, with the bus limiter on
+ * The rendered PCM (kept in output-dir, default the working directory) is
+ * then read back for the peak level and the number of clipped samples.
+ * After each run the player's lock contention figures are printed, one
+ * line per lock statistic.
+ *
+ * Last, a player with a short idle timeout plays one click and is left
+ * alone until it parks. Over the next idle-seconds (default 3) the
+ * processing thread's wakeups and the process CPU time are counted, and
+ * one more click measures what resuming costs.
+ */
+#include "ClickSynth.h"
+#include "KeyThrottle.h"
+#include "Logger.h"
+#include "SFMLSoundPlayer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto KEY_SPACING = std::chrono::milliseconds(2);
+constexpr auto HOLD = std::chrono::milliseconds(12);
+constexpr auto RETAP = std::chrono::milliseconds(20);
+constexpr auto BURST_SPACING = std::chrono::milliseconds(400);
+constexpr auto TAIL = std::chrono::milliseconds(600);
+constexpr auto IDLE_TIMEOUT = std::chrono::milliseconds(200);
+constexpr auto PARK_WAIT = std::chrono::seconds(3); // The loop notices the timeout at its next cleanup pass
+
+struct TraceEvent
+{
+    Clock::duration time;
+    std::uint16_t keyCode;
+    bool keyDown;
+};
+
+std::vector<TraceEvent> buildTrace(std::size_t bursts, std::size_t keys)
+{
+    std::vector<TraceEvent> trace;
+    for (std::size_t b = 0; b < bursts; ++b) {
+        Clock::duration start = BURST_SPACING * static_cast<int>(b);
+        for (std::size_t k = 0; k < keys; ++k) {
+            auto keyCode = static_cast<std::uint16_t>(0x41 + k);
+            Clock::duration press = start + KEY_SPACING * static_cast<int>(k);
+            trace.push_back({press, keyCode, true});
+            trace.push_back({press + HOLD, keyCode, false});
+            trace.push_back({press + RETAP, keyCode, true});
+            trace.push_back({press + RETAP + HOLD, keyCode, false});
+        }
+    }
+    std::stable_sort(trace.begin(), trace.end(),
+                     [](const TraceEvent &a, const TraceEvent &b) { return a.time < b.time; });
+    return trace;
+}
+
+struct RunResult
+{
+    std::uint64_t hookDrops = 0;
+    std::uint64_t playerDrops = 0;
+    double peakDb = -120.0;
+    std::uint64_t clippedSamples = 0;
+    std::string lockContention;
+};
+
+bool run(OverloadPolicy policy, const std::vector<TraceEvent> &trace, const std::string &outputFile, RunResult &result)
+{
+    AudioBackendConfig config;
+    config.backend = "null";
+    config.sampleRate = 48000;
+    config.outputFile = outputFile;
+    config.overloadPolicy = policy;
+    config.effects.limiter = policy == OverloadPolicy::LIMIT;
+
+    {
+        SFMLSoundPlayer player(config);
+        if (!player.open()) {
+            return false;
+        }
+        player.setVolume(100);
+
+        static const char *const CATEGORIES[] = {"alpha", "alpha", "alpha", "alt", "space", "enter"};
+        KeyThrottle throttle;
+        auto start = Clock::now();
+        for (const auto &event : trace) {
+            std::this_thread::sleep_until(start + event.time);
+            auto now = Clock::now();
+            bool allowed = event.keyDown ? throttle.allowKeyDown(event.keyCode, now, policy)
+                                         : throttle.allowKeyUp(event.keyCode, now, policy);
+            if (allowed) {
+                const char *category = CATEGORIES[event.keyCode % (sizeof(CATEGORIES) / sizeof(CATEGORIES[0]))];
+                player.playSound(ClickSynth::getSoundPath(category, event.keyDown, event.keyCode % ClickSynth::VARIANTS),
+                                 event.keyDown, now);
+            }
+        }
+        std::this_thread::sleep_for(TAIL);
+
+        result.hookDrops = throttle.getDroppedCount();
+        result.playerDrops = player.getDroppedCount();
+        result.lockContention = player.dumpLockContention();
+    }
+
+    std::ifstream input(outputFile, std::ios::binary);
+    std::vector<std::int16_t> samples(4096);
+    int peak = 0;
+    while (input.read(reinterpret_cast<char *>(samples.data()), samples.size() * sizeof(std::int16_t)) ||
+           input.gcount() > 0) {
+        std::size_t count = static_cast<std::size_t>(input.gcount()) / sizeof(std::int16_t);
+        for (std::size_t i = 0; i < count; ++i) {
+            int magnitude = std::abs(static_cast<int>(samples[i]));
+            peak = std::max(peak, magnitude);
+            result.clippedSamples += magnitude >= 32767 ? 1 : 0;
+        }
+    }
+    if (peak > 0) {
+        result.peakDb = 20.0 * std::log10(peak / 32767.0);
+    }
+    return true;
+}
+
+/**
+ * @brief User and system CPU time of the whole process so far
+ */
+std::chrono::microseconds getProcessCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return std::chrono::microseconds(0);
+    }
+    auto toMicroseconds = [](const FILETIME &time) {
+        return ((static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10;
+    };
+    return std::chrono::microseconds(toMicroseconds(kernel) + toMicroseconds(user));
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+struct IdleResult
+{
+    bool parked = false;
+    std::uint64_t wakeups = 0;
+    double cpuMs = 0.0;
+    long long wakeLatencyUs = 0;
+};
+
+bool measureIdle(std::chrono::seconds idle, IdleResult &result)
+{
+    AudioBackendConfig config;
+    config.backend = "null";
+    config.sampleRate = 48000;
+    SFMLSoundPlayer player(config);
+    if (!player.open()) {
+        return false;
+    }
+    player.setIdleTimeout(IDLE_TIMEOUT);
+    const std::string click = ClickSynth::getSoundPath("alpha", true, 0);
+
+    player.playSound(click, true);
+    auto deadline = Clock::now() + IDLE_TIMEOUT + PARK_WAIT;
+    while (!player.isIdle() && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    result.parked = player.isIdle();
+
+    std::uint64_t wakeups = player.getWakeupCount();
+    std::chrono::microseconds cpu = getProcessCpuTime();
+    std::this_thread::sleep_for(idle);
+    result.wakeups = player.getWakeupCount() - wakeups;
+    result.cpuMs = static_cast<double>((getProcessCpuTime() - cpu).count()) / 1000.0;
+
+    // The first sound after the pause pays for the resume
+    player.playSound(click, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    result.wakeLatencyUs = player.getLastWakeLatency().count();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t bursts = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10;
+    std::size_t keys = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 24;
+    std::string outputDir = argc > 3 ? argv[3] : ".";
+    long idleSeconds = argc > 4 ? std::strtol(argv[4], nullptr, 10) : 3;
+    if (bursts == 0 || keys == 0 || keys > 26 || idleSeconds <= 0) {
+        std::cerr << "Usage: burst-bench [bursts] [keys-per-burst <= 26] [output-dir] [idle-seconds]" << std::endl;
+        return 1;
+    }
+    Logger::instance().start("");
+
+    std::vector<TraceEvent> trace = buildTrace(bursts, keys);
+    std::cout << "events=" << trace.size() << " bursts=" << bursts << " keys_per_burst=" << keys << std::endl;
+
+    std::pair<const char *, OverloadPolicy> policies[] = {{"drop", OverloadPolicy::DROP},
+                                                          {"limit", OverloadPolicy::LIMIT}};
+    for (const auto &[name, policy] : policies) {
+        RunResult result;
+        std::string outputFile = outputDir + "/burst_" + name + ".pcm";
+        if (!run(policy, trace, outputFile, result)) {
+            std::cerr << "Failed to open the null backend writing " << outputFile << std::endl;
+            Logger::instance().stop();
+            return 1;
+        }
+        std::cout << "policy=" << name << " hook_drops=" << result.hookDrops << " player_drops=" << result.playerDrops
+                  << " played=" << trace.size() - result.hookDrops - result.playerDrops
+                  << " peak_dbfs=" << result.peakDb << " clipped_samples=" << result.clippedSamples << std::endl;
+        std::cout << result.lockContention;
+    }
+
+    IdleResult idle;
+    if (!measureIdle(std::chrono::seconds(idleSeconds), idle)) {
+        std::cerr << "Failed to open the null backend" << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+    std::cout << "idle_seconds=" << idleSeconds << " parked=" << (idle.parked ? 1 : 0)
+              << " idle_wakeups=" << idle.wakeups << " idle_cpu_ms=" << idle.cpuMs
+              << " wake_latency_us=" << idle.wakeLatencyUs << std::endl;
+
+    Logger::instance().stop();
+    return 0;
+}
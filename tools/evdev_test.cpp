@@ -0,0 +1,203 @@
+/**
+ * @file evdev_test.cpp
+ * @brief Feeds an EvdevInputSource from a pipe and checks what it dispatches
+ *
+ * Usage:
+ *   evdev-test
+ *
+ * Watches an empty temporary directory, so no real keyboard is opened,
+ * and hands the read end of a pipe to addDevice(). struct input_event
+ * records written to the other end must come out as translated
+ * KeyEvents:
+ *   translate - key down and up, with EV_SYN, autorepeat and unmapped codes skipped
+ *   partial   - a record split across two writes is carried over to the next read
+ *   eof       - closing the write end removes the device
+ * Prints each failed check and exits with 1 if there was any.
+ */
+#include "EvdevInputSource.h"
+#include "Logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <linux/input.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr auto WAIT_TIMEOUT = std::chrono::seconds(2);
+constexpr auto SETTLE_TIME = std::chrono::milliseconds(50);
+
+int failures = 0;
+
+void check(bool condition, const std::string &what)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+/**
+ * @brief Collects dispatched events for the checks
+ */
+class EventLog
+{
+public:
+    void add(const KeyEvent &event)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_.push_back(event);
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief Wait until at least count events have arrived
+     * @return Every event so far
+     */
+    std::vector<KeyEvent> waitFor(std::size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, WAIT_TIMEOUT, [this, count] { return events_.size() >= count; });
+        return events_;
+    }
+
+    std::vector<KeyEvent> snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<KeyEvent> events_;
+};
+
+input_event makeRecord(std::uint16_t type, std::uint16_t code, std::int32_t value)
+{
+    input_event record;
+    std::memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.code = code;
+    record.value = value;
+    return record;
+}
+
+void writeBytes(int fd, const void *data, std::size_t size)
+{
+    auto bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) {
+            check(false, "write to the pipe");
+            return;
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+void writeRecords(int fd, const std::vector<input_event> &records)
+{
+    writeBytes(fd, records.data(), records.size() * sizeof(input_event));
+}
+
+bool matches(const KeyEvent &event, std::uint16_t keyCode, bool keyDown)
+{
+    return event.keyCode == keyCode && event.keyDown == keyDown && !event.injected &&
+           event.timestamp != std::chrono::steady_clock::time_point{};
+}
+
+} // namespace
+
+int main()
+{
+    Logger::instance().setLevel(LogLevel::ERR);
+    Logger::instance().start("");
+
+    std::filesystem::path inputDir =
+        std::filesystem::temp_directory_path() / ("evdev-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(inputDir);
+
+    EventLog log;
+    EvdevInputSource source(inputDir.string());
+    check(source.start([&log](const KeyEvent &event) { log.add(event); }), "start on an empty directory");
+    check(source.getDeviceCount() == 0, "no device before addDevice");
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::cerr << "pipe: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    check(source.addDevice(fds[0], "test-pipe"), "addDevice on a pipe");
+    check(source.getDeviceCount() == 1, "pipe counted as a device");
+
+    // translate
+    writeRecords(fds[1], {
+        makeRecord(EV_MSC, MSC_SCAN, 0x1e),
+        makeRecord(EV_KEY, KEY_A, 1),
+        makeRecord(EV_SYN, SYN_REPORT, 0),
+        makeRecord(EV_KEY, KEY_A, 2), // Autorepeat
+        makeRecord(EV_KEY, KEY_A, 0),
+        makeRecord(EV_KEY, KEY_MUTE, 1), // No engine code
+        makeRecord(EV_KEY, KEY_SPACE, 1),
+        makeRecord(EV_KEY, KEY_LEFTALT, 1),
+    });
+    std::vector<KeyEvent> events = log.waitFor(4);
+    check(events.size() == 4, "translate: 4 events, got " + std::to_string(events.size()));
+    if (events.size() >= 4) {
+        check(matches(events[0], 'A', true), "translate: KEY_A press is 'A' down");
+        check(matches(events[1], 'A', false), "translate: KEY_A release is 'A' up");
+        check(matches(events[2], 0x20, true), "translate: KEY_SPACE is VK_SPACE");
+        check(matches(events[3], 0x12, true), "translate: KEY_LEFTALT is VK_MENU");
+    }
+
+    // partial: one and a half records, then the rest
+    input_event split[2] = {makeRecord(EV_KEY, KEY_ENTER, 1), makeRecord(EV_KEY, KEY_ENTER, 0)};
+    const auto *bytes = reinterpret_cast<const unsigned char *>(split);
+    const std::size_t half = sizeof(input_event) + sizeof(input_event) / 2;
+    writeBytes(fds[1], bytes, half);
+    events = log.waitFor(5);
+    std::this_thread::sleep_for(SETTLE_TIME);
+    events = log.snapshot();
+    check(events.size() == 5, "partial: only the whole record is dispatched, got " + std::to_string(events.size()));
+    if (events.size() >= 5) {
+        check(matches(events[4], 0x0D, true), "partial: whole record is VK_RETURN down");
+    }
+    writeBytes(fds[1], bytes + half, sizeof(split) - half);
+    events = log.waitFor(6);
+    check(events.size() == 6, "partial: the split record arrives once completed");
+    if (events.size() >= 6) {
+        check(matches(events[5], 0x0D, false), "partial: completed record is VK_RETURN up");
+    }
+
+    // eof
+    close(fds[1]);
+    auto deadline = std::chrono::steady_clock::now() + WAIT_TIMEOUT;
+    while (source.getDeviceCount() != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    check(source.getDeviceCount() == 0, "eof: device removed once the writer closes");
+    check(log.snapshot().size() == 6, "eof: no events from the closed pipe");
+
+    source.stop();
+    std::error_code ec;
+    std::filesystem::remove_all(inputDir, ec);
+    Logger::instance().stop();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "evdev-test: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file jitter_bench.cpp
+ * @brief Measures how well rendered keystrokes keep the spacing of the input
+ *
+ * Usage:
+ *   jitter-bench [events] [period-frames] [latency-ms] [output-dir]
+ *
+ * Replays a seeded trace of key presses 40 to 150 ms apart in real time
+ * through an SFMLSoundPlayer on the null backend at 48 kHz, playing the
+ * synthesized pack. It runs twice:
+ *   immediate - audio.scheduleLatencyMs = 0, voices start at the next period
+ *   scheduled - audio.scheduleLatencyMs = latency-ms (default 10)
+ * Each click is followed by silence, so the onsets are found again in the
+ * rendered PCM (kept in output-dir, default the working directory) as the
+ * first non-zero sample after a silent gap. The error of every
+ * inter-onset interval against the interval of the input timestamps is
+ * reported in microseconds.
+ */
+#include "ClickSynth.h"
+#include "Logger.h"
+#include "SFMLSoundPlayer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr unsigned int SAMPLE_RATE = 48000;
+constexpr int MIN_INTERVAL_MS = 40;
+constexpr int MAX_INTERVAL_MS = 150;
+constexpr std::size_t SILENT_GAP_FRAMES = SAMPLE_RATE / 200; // 5 ms, well inside the gaps between clicks
+constexpr auto TAIL = std::chrono::milliseconds(400);
+
+struct RunResult
+{
+    std::size_t onsets = 0;
+    double meanErrorUs = 0.0;
+    double p50ErrorUs = 0.0;
+    double p99ErrorUs = 0.0;
+    double maxErrorUs = 0.0;
+};
+
+/**
+ * @brief Find click onsets in interleaved stereo PCM
+ * @return Frame index of each onset
+ */
+std::vector<std::size_t> findOnsets(const std::string &path)
+{
+    std::vector<std::size_t> onsets;
+    std::ifstream input(path, std::ios::binary);
+    std::vector<std::int16_t> samples(4096 * 2);
+    std::size_t frame = 0;
+    std::size_t silentFrames = SILENT_GAP_FRAMES;
+    while (input.read(reinterpret_cast<char *>(samples.data()), samples.size() * sizeof(std::int16_t)) ||
+           input.gcount() > 0) {
+        std::size_t frames = static_cast<std::size_t>(input.gcount()) / (2 * sizeof(std::int16_t));
+        for (std::size_t i = 0; i < frames; ++i, ++frame) {
+            if (samples[i * 2] == 0 && samples[i * 2 + 1] == 0) {
+                ++silentFrames;
+                continue;
+            }
+            if (silentFrames >= SILENT_GAP_FRAMES) {
+                onsets.push_back(frame);
+            }
+            silentFrames = 0;
+        }
+    }
+    return onsets;
+}
+
+bool run(const std::vector<Clock::duration> &trace, unsigned int periodFrames, unsigned int latencyMs,
+         const std::string &outputFile, RunResult &result)
+{
+    AudioBackendConfig config;
+    config.backend = "null";
+    config.sampleRate = SAMPLE_RATE;
+    config.periodFrames = periodFrames;
+    config.outputFile = outputFile;
+    config.scheduleLatencyMs = latencyMs;
+
+    std::vector<Clock::time_point> timestamps;
+    {
+        SFMLSoundPlayer player(config);
+        if (!player.open()) {
+            return false;
+        }
+
+        auto start = Clock::now() + std::chrono::milliseconds(100);
+        for (std::size_t i = 0; i < trace.size(); ++i) {
+            std::this_thread::sleep_until(start + trace[i]);
+            auto now = Clock::now();
+            timestamps.push_back(now);
+            player.playSound(ClickSynth::getSoundPath("alpha", true, i % ClickSynth::VARIANTS), true, now);
+        }
+        std::this_thread::sleep_for(TAIL);
+    }
+
+    std::vector<std::size_t> onsets = findOnsets(outputFile);
+    result.onsets = onsets.size();
+    if (onsets.size() != timestamps.size()) {
+        return true;
+    }
+
+    std::vector<double> errors;
+    for (std::size_t i = 1; i < onsets.size(); ++i) {
+        double rendered = static_cast<double>(onsets[i] - onsets[i - 1]) * 1e6 / SAMPLE_RATE;
+        double input = std::chrono::duration<double, std::micro>(timestamps[i] - timestamps[i - 1]).count();
+        errors.push_back(std::fabs(rendered - input));
+    }
+    if (errors.empty()) {
+        return true;
+    }
+    std::sort(errors.begin(), errors.end());
+    double sum = 0.0;
+    for (double error : errors) {
+        sum += error;
+    }
+    result.meanErrorUs = sum / static_cast<double>(errors.size());
+    result.p50ErrorUs = errors[errors.size() / 2];
+    result.p99ErrorUs = errors[std::min(errors.size() - 1, errors.size() * 99 / 100)];
+    result.maxErrorUs = errors.back();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    unsigned long periodFrames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+    unsigned long latencyMs = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+    std::string outputDir = argc > 4 ? argv[4] : ".";
+    if (events < 2 || periodFrames < 32 || periodFrames > 4096 || latencyMs == 0 || latencyMs > 1000) {
+        std::cerr << "Usage: jitter-bench [events >= 2] [period-frames 32-4096] [latency-ms 1-1000] [output-dir]"
+                  << std::endl;
+        return 1;
+    }
+    Logger::instance().start("");
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> interval(MIN_INTERVAL_MS, MAX_INTERVAL_MS);
+    std::vector<Clock::duration> trace;
+    Clock::duration time{};
+    for (std::size_t i = 0; i < events; ++i) {
+        trace.push_back(time);
+        time += std::chrono::milliseconds(interval(random));
+    }
+    std::cout << "events=" << events << " period_frames=" << periodFrames
+              << " period_us=" << periodFrames * 1e6 / SAMPLE_RATE << std::endl;
+
+    std::pair<const char *, unsigned int> modes[] = {{"immediate", 0u}, {"scheduled", static_cast<unsigned int>(latencyMs)}};
+    for (const auto &[name, latency] : modes) {
+        RunResult result;
+        std::string outputFile = outputDir + "/jitter_" + name + ".pcm";
+        if (!run(trace, static_cast<unsigned int>(periodFrames), latency, outputFile, result)) {
+            std::cerr << "Failed to open the null backend writing " << outputFile << std::endl;
+            Logger::instance().stop();
+            return 1;
+        }
+        if (result.onsets != events) {
+            std::cout << "mode=" << name << " onsets=" << result.onsets << " (expected " << events
+                      << ", clicks overlapped or were dropped)" << std::endl;
+            continue;
+        }
+        std::cout << "mode=" << name << " latency_ms=" << latency << " mean_error_us=" << result.meanErrorUs
+                  << " p50_error_us=" << result.p50ErrorUs << " p99_error_us=" << result.p99ErrorUs
+                  << " max_error_us=" << result.maxErrorUs << std::endl;
+    }
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file mixer_bench.cpp
+ * @brief Measures the software mixer's render cost per voice
+ *
+ * Usage:
+ *   mixer-bench [periods] [period-frames]
+ *
+ * Renders periods at 48 kHz with 1 to 64 voices of each kind playing:
+ *   sample - a decoded 44.1 kHz buffer, resampled by the mixer
+ *   synth  - a synthesized click from the "synth:" pack
+ * Finished voices are restarted between periods, outside the timing. The
+ * cost of an empty period is subtracted before dividing by the voice count.
+ *
+ * Then each bus effect is timed on its own, and all of them together, on
+ * periods of noise.
+ */
+#include "BusEffects.h"
+#include "ClickSynth.h"
+#include "Logger.h"
+#include "SoftwareMixer.h"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr unsigned int SAMPLE_RATE = 48000;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Keeps a number of voices playing and times the periods rendered
+ */
+class VoiceLoad
+{
+public:
+    VoiceLoad(SoftwareMixer &mixer, std::size_t voices, bool synth, const std::shared_ptr<sf::SoundBuffer> &buffer)
+        : mixer_(mixer), handles_(voices, -1), synth_(synth), buffer_(buffer)
+    {
+    }
+
+    /**
+     * @brief Render periods and return the mean time per period in nanoseconds
+     */
+    double run(std::size_t periods, std::size_t periodFrames)
+    {
+        std::vector<std::int16_t> out(periodFrames * SoftwareMixer::CHANNELS);
+        double total = 0.0;
+        for (std::size_t p = 0; p < periods; ++p) {
+            refill();
+            auto start = Clock::now();
+            mixer_.render(out.data(), periodFrames);
+            total += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        }
+        for (std::int64_t handle : handles_) {
+            mixer_.stopVoice(handle);
+        }
+        mixer_.render(out.data(), periodFrames);
+        return total / static_cast<double>(periods);
+    }
+
+private:
+    void refill()
+    {
+        for (std::int64_t &handle : handles_) {
+            if (mixer_.isVoicePlaying(handle)) {
+                continue;
+            }
+            if (synth_) {
+                ClickParams params;
+                ClickSynth::getParams(ClickSynth::getSoundPath("alpha", true, keystroke_ % ClickSynth::VARIANTS),
+                                      keystroke_, params);
+                ++keystroke_;
+                handle = mixer_.startSynthVoice(params, 50.0f);
+            } else {
+                handle = mixer_.startVoice(buffer_, 50.0f);
+            }
+        }
+    }
+
+    SoftwareMixer &mixer_;
+    std::vector<std::int64_t> handles_;
+    bool synth_;
+    std::shared_ptr<sf::SoundBuffer> buffer_;
+    std::uint32_t keystroke_ = 0;
+};
+
+/**
+ * @brief Mean time per period of a bus effect setup, in nanoseconds
+ */
+double timeEffects(const BusEffectSettings &settings, std::size_t periods, std::size_t periodFrames)
+{
+    BusEffectChain chain(SAMPLE_RATE);
+    chain.configure(settings);
+
+    std::vector<float> noise(periodFrames * SoftwareMixer::CHANNELS);
+    std::uint32_t state = 7;
+    for (float &sample : noise) {
+        state = state * 1664525u + 1013904223u;
+        sample = static_cast<float>(static_cast<std::int32_t>(state)) / 2147483648.0f * 0.5f;
+    }
+
+    // The first call adopts the setup
+    std::vector<float> mix(noise);
+    chain.process(mix.data(), periodFrames);
+
+    double total = 0.0;
+    for (std::size_t p = 0; p < periods; ++p) {
+        std::copy(noise.begin(), noise.end(), mix.begin());
+        auto start = Clock::now();
+        chain.process(mix.data(), periodFrames);
+        total += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    return total / static_cast<double>(periods);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t periods = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::size_t periodFrames = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+    if (periods == 0 || periodFrames == 0 || periodFrames > SoftwareMixer::MAX_PERIOD_FRAMES) {
+        std::cerr << "Usage: mixer-bench [periods] [period-frames <= " << SoftwareMixer::MAX_PERIOD_FRAMES << "]"
+                  << std::endl;
+        return 1;
+    }
+    Logger::instance().start("");
+
+    // One second of stereo noise stands in for a decoded key sound
+    std::vector<std::int16_t> samples(44100 * 2);
+    std::uint32_t state = 1;
+    for (auto &sample : samples) {
+        state = state * 1664525u + 1013904223u;
+        sample = static_cast<std::int16_t>(state >> 16);
+    }
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    if (!buffer->loadFromSamples(samples.data(), samples.size(), 2, 44100,
+                                 {sf::SoundChannel::FrontLeft, sf::SoundChannel::FrontRight})) {
+        std::cerr << "Failed to create the test buffer" << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+
+    SoftwareMixer mixer(SAMPLE_RATE);
+    double budget = static_cast<double>(periodFrames) * 1e9 / SAMPLE_RATE;
+    double empty = VoiceLoad(mixer, 0, false, buffer).run(periods, periodFrames);
+    std::cout << "period_frames=" << periodFrames << " budget_ns=" << budget << " empty_ns=" << empty
+              << " sample_pcm_bytes=" << samples.size() * sizeof(std::int16_t) << " synth_pcm_bytes=0" << std::endl;
+
+    for (std::size_t voices : {1, 4, 16, 64}) {
+        double sample = VoiceLoad(mixer, voices, false, buffer).run(periods, periodFrames);
+        double synth = VoiceLoad(mixer, voices, true, buffer).run(periods, periodFrames);
+        std::cout << "voices=" << voices
+                  << " sample_ns_per_voice=" << (sample - empty) / static_cast<double>(voices)
+                  << " synth_ns_per_voice=" << (synth - empty) / static_cast<double>(voices)
+                  << " sample_budget_pct=" << 100.0 * sample / budget
+                  << " synth_budget_pct=" << 100.0 * synth / budget << std::endl;
+    }
+
+    BusEffectSettings limiter;
+    BusEffectSettings eq;
+    eq.limiter = false;
+    eq.eq = true;
+    eq.lowGainDb = 3.0f;
+    eq.midGainDb = -2.0f;
+    eq.highGainDb = 2.0f;
+    BusEffectSettings reverb;
+    reverb.limiter = false;
+    reverb.reverb = true;
+    reverb.reverbTimeMs = 1000.0f * BusEffectChain::MAX_REVERB_SECONDS;
+    BusEffectSettings compressor;
+    compressor.limiter = false;
+    compressor.compressor = true;
+    compressor.thresholdDb = -20.0f;
+    BusEffectSettings all = reverb;
+    all.eq = true;
+    all.compressor = true;
+    all.limiter = true;
+
+    std::pair<const char *, const BusEffectSettings *> effects[] = {
+        {"eq", &eq}, {"reverb", &reverb}, {"compressor", &compressor}, {"limiter", &limiter}, {"all", &all}};
+    for (const auto &[name, settings] : effects) {
+        double cost = timeEffects(*settings, periods, periodFrames);
+        std::cout << "effect=" << name << " ns_per_period=" << cost << " budget_pct=" << 100.0 * cost / budget
+                  << std::endl;
+    }
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file pack_embedder.cpp
+ * @brief Converts a sound pack into PCM that is compiled into the executable
+ *
+ * Usage:
+ *   pack-embedder <pack-folder> <output.inc>
+ *
+ * Every mp3 under <category>/<down|up>/ is decoded once at build time and
+ * conditioned: leading and trailing silence is trimmed, and stereo files
+ * whose channels are identical are folded to mono. The output defines
+ * embedded_pack::PACK_NAME, SAMPLES[] and SOUNDS[] for EmbeddedPack.cpp.
+ */
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Samples at or below this magnitude count as silence (about -60 dBFS)
+constexpr std::int16_t SILENCE_THRESHOLD = 32;
+
+struct Entry
+{
+    std::string category;
+    bool keyDown;
+    std::size_t offset;
+    std::size_t sampleCount;
+    unsigned int channels;
+    unsigned int sampleRate;
+};
+
+/**
+ * @brief Decode and condition one file
+ * @param path File to decode
+ * @param samples Receives interleaved PCM
+ * @param channels Receives the channel count
+ * @param sampleRate Receives the sample rate
+ * @return true if successful, false otherwise
+ */
+bool condition(const std::filesystem::path &path, std::vector<std::int16_t> &samples,
+               unsigned int &channels, unsigned int &sampleRate)
+{
+    sf::SoundBuffer buffer;
+    if (!buffer.loadFromFile(path.string())) {
+        return false;
+    }
+
+    channels = buffer.getChannelCount();
+    sampleRate = buffer.getSampleRate();
+    if (channels == 0 || channels > 2) {
+        return false;
+    }
+    const std::int16_t *data = buffer.getSamples();
+    std::size_t frames = static_cast<std::size_t>(buffer.getSampleCount()) / channels;
+    if (frames == 0) {
+        return false;
+    }
+
+    auto silent = [&](std::size_t frame) {
+        for (unsigned int c = 0; c < channels; ++c) {
+            if (std::abs(data[frame * channels + c]) > SILENCE_THRESHOLD) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::size_t first = 0;
+    while (first < frames && silent(first)) {
+        ++first;
+    }
+    std::size_t last = frames;
+    while (last > first && silent(last - 1)) {
+        --last;
+    }
+    if (first == last) {
+        // Entirely silent (first == frames): keep the first frame so the index stays valid
+        first = 0;
+        last = 1;
+    }
+
+    bool dualMono = channels == 2;
+    for (std::size_t frame = first; dualMono && frame < last; ++frame) {
+        dualMono = data[frame * 2] == data[frame * 2 + 1];
+    }
+
+    samples.clear();
+    if (dualMono) {
+        channels = 1;
+        for (std::size_t frame = first; frame < last; ++frame) {
+            samples.push_back(data[frame * 2]);
+        }
+    } else {
+        samples.assign(data + first * channels, data + last * channels);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: pack-embedder <pack-folder> <output.inc>" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path folder(argv[1]);
+    const char *categories[] = {"alpha", "alt", "enter", "space", "other"};
+
+    std::vector<std::int16_t> allSamples;
+    std::vector<Entry> entries;
+    std::size_t sourceBytes = 0;
+
+    for (const char *category : categories) {
+        for (bool keyDown : {true, false}) {
+            std::filesystem::path directory = folder / category / (keyDown ? "down" : "up");
+            if (!std::filesystem::is_directory(directory)) {
+                continue;
+            }
+
+            // Sort so the generated file is reproducible
+            std::vector<std::filesystem::path> files;
+            for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".mp3") {
+                    files.push_back(entry.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+
+            for (const auto &file : files) {
+                std::vector<std::int16_t> samples;
+                unsigned int channels = 0;
+                unsigned int sampleRate = 0;
+                if (!condition(file, samples, channels, sampleRate)) {
+                    std::cerr << "Skipping undecodable file: " << file.string() << std::endl;
+                    continue;
+                }
+
+                // Keep every sound 16-byte aligned within SAMPLES
+                while (allSamples.size() % 8 != 0) {
+                    allSamples.push_back(0);
+                }
+                entries.push_back({category, keyDown, allSamples.size(), samples.size(), channels, sampleRate});
+                allSamples.insert(allSamples.end(), samples.begin(), samples.end());
+                sourceBytes += static_cast<std::size_t>(std::filesystem::file_size(file));
+            }
+        }
+    }
+
+    if (entries.empty()) {
+        std::cerr << "No sounds found in " << folder.string() << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(argv[2], std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to open output file: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    out << "// Generated by pack-embedder from " << folder.generic_string() << ". Do not edit.\n"
+        << "namespace embedded_pack {\n\n"
+        << "constexpr const char *PACK_NAME = \"" << folder.filename().string() << "\";\n\n"
+        << "alignas(16) const std::int16_t SAMPLES[] = {";
+    for (std::size_t i = 0; i < allSamples.size(); ++i) {
+        out << (i % 16 == 0 ? "\n    " : " ") << allSamples[i] << ",";
+    }
+    out << "\n};\n\n"
+        << "const EmbeddedSound SOUNDS[] = {\n";
+    for (const Entry &entry : entries) {
+        out << "    {\"" << entry.category << "\", " << (entry.keyDown ? "true" : "false")
+            << ", SAMPLES + " << entry.offset << ", " << entry.sampleCount << ", "
+            << entry.channels << ", " << entry.sampleRate << "},\n";
+    }
+    out << "};\n\n"
+        << "} // namespace embedded_pack\n";
+
+    if (!out) {
+        std::cerr << "Failed to write output file: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Embedded " << entries.size() << " sounds from " << folder.string() << ": "
+              << allSamples.size() * sizeof(std::int16_t) << " bytes of PCM from "
+              << sourceBytes << " bytes of source" << std::endl;
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file pack_load_bench.cpp
+ * @brief Compares cold-cache pack load time and peak memory of the decode paths
+ *
+ * Usage:
+ *   pack-load-bench <pack-folder> [runs]
+ *
+ * Each run evicts the pack's files from the page cache (posix_fadvise on
+ * POSIX; not available on Windows, where runs after the first are warm)
+ * before each of these ways of loading the pack:
+ *   per_file  - sf::SoundBuffer::loadFromFile for each file in turn
+ *   mapped    - loadFromMemory on a read-only mapping of each file
+ *   batched   - BatchFileReader::readAll, then loadFromMemory for each file
+ *
+ * The peak resident set growth of each variant is reported alongside
+ * (Linux only, where the peak can be reset between variants). Decoded
+ * buffers are kept until the variant ends, as a pack load would.
+ */
+#include "BatchFileReader.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "ProcessMemory.h"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Drop the files from the page cache
+ * @return false if eviction is not supported here
+ */
+bool evict(const std::vector<std::string> &paths)
+{
+#ifdef _WIN32
+    (void)paths;
+    return false;
+#else
+    for (const auto &path : paths) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+    return true;
+#endif
+}
+
+/**
+ * @brief Time a load variant and the resident set growth it causes
+ */
+struct Measurement
+{
+    double milliseconds = 0.0;
+    std::size_t peakGrowth = 0;
+};
+
+template <typename Load>
+Measurement measure(const std::vector<std::string> &paths, Load load)
+{
+    evict(paths);
+    ProcessMemory::resetPeak();
+    std::size_t before = ProcessMemory::getResidentBytes();
+
+    Measurement result;
+    {
+        std::vector<sf::SoundBuffer> buffers(paths.size());
+        result.milliseconds = load(buffers);
+    }
+    std::size_t peak = ProcessMemory::getPeakResidentBytes();
+    result.peakGrowth = peak > before ? peak - before : 0;
+    return result;
+}
+
+double loadPerFile(const std::vector<std::string> &paths, std::vector<sf::SoundBuffer> &buffers)
+{
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (!buffers[i].loadFromFile(paths[i])) {
+            std::cerr << "Failed to decode " << paths[i] << std::endl;
+        }
+    }
+    return millisecondsSince(start);
+}
+
+double loadMapped(const std::vector<std::string> &paths, std::vector<sf::SoundBuffer> &buffers)
+{
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        MappedFile file(paths[i]);
+        if (!file.isValid() || !buffers[i].loadFromMemory(file.data(), file.size())) {
+            std::cerr << "Failed to decode " << paths[i] << std::endl;
+        }
+    }
+    return millisecondsSince(start);
+}
+
+double loadBatched(const std::vector<std::string> &paths, std::vector<sf::SoundBuffer> &buffers,
+                   BatchFileReader::Method method)
+{
+    auto start = Clock::now();
+    std::vector<FileRead> files;
+    for (const auto &path : paths) {
+        files.push_back(FileRead{path, {}, false});
+    }
+    BatchFileReader::readAll(files, method);
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const FileRead &file = files[i];
+        if (!file.ok || !buffers[i].loadFromMemory(file.data.data(), file.data.size())) {
+            std::cerr << "Failed to decode " << file.path << std::endl;
+        }
+    }
+    return millisecondsSince(start);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: pack-load-bench <pack-folder> [runs]" << std::endl;
+        return 1;
+    }
+    Logger::instance().start("");
+
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(argv[1], ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".mp3") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "No sounds found in " << argv[1] << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+    bool cold = evict(paths);
+    std::cout << "files=" << paths.size() << " runs=" << runs << " cache=" << (cold ? "cold" : "warm") << std::endl;
+
+    using Buffers = std::vector<sf::SoundBuffer>;
+    for (int run = 0; run < runs; ++run) {
+        Measurement results[] = {
+            measure(paths, [&](Buffers &buffers) { return loadPerFile(paths, buffers); }),
+            measure(paths, [&](Buffers &buffers) { return loadMapped(paths, buffers); }),
+            measure(paths, [&](Buffers &buffers) {
+                return loadBatched(paths, buffers, BatchFileReader::Method::IO_URING);
+            }),
+            measure(paths, [&](Buffers &buffers) {
+                return loadBatched(paths, buffers, BatchFileReader::Method::THREAD_POOL);
+            })};
+        const char *names[] = {"per_file", "mapped", "batched_io_uring", "batched_thread_pool"};
+
+        std::cout << "run=" << run;
+        for (std::size_t i = 0; i < 4; ++i) {
+            std::cout << " " << names[i] << "_ms=" << results[i].milliseconds
+                      << " " << names[i] << "_peak_kb=" << results[i].peakGrowth / 1024;
+        }
+        std::cout << std::endl;
+    }
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,585 @@
+/**
+ * @file prefetch_sim.cpp
+ * @brief Replays key traces against models of the preloader and sound cache
+ *
+ * Usage:
+ *   prefetch-sim <pack-folder> <trace-file> [wpm] [seed]
+ *
+ * The trace is either a recording made with telemetry-reader (its "key"
+ * lines; other lines are skipped) or any text file, which is typed out at
+ * wpm words per minute (default 60) with lognormal key intervals and hold
+ * times. Every strategy replays the same trace and the same random sound
+ * variants:
+ *   none      - cold cache, nothing preloaded
+ *   level0-3  - what the application does at each optimization level: the
+ *               common keys preloaded at startup, KeyPredictor preloads and,
+ *               above level 0, key-up sounds armed at key down
+ *   frequency - startup preload plus, on each press, the sounds of the two
+ *               most pressed keys so far
+ *   resident  - the whole pack decoded up front and never evicted
+ *
+ * The cache holds 100 buffers and evicts an arbitrary one when full, like
+ * SFMLSoundPlayer. Each file's decode time and PCM size are measured by
+ * decoding the pack once. A keystroke stalls when its buffer is neither
+ * cached nor armed and ready, and waits for a decode on the processing
+ * thread or for a preload still in flight. A wasted decode is a preload
+ * that was evicted, replaced or left over without ever being played.
+ */
+#include "KeyPredictor.h"
+#include "Logger.h"
+#include <SFML/Audio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t CACHE_CAPACITY = 100; // SFMLSoundPlayer::MAX_CACHE_SIZE
+constexpr std::size_t FREQUENCY_KEYS = 2;   // Same count as level 2 predicts
+constexpr double INTERVAL_SIGMA = 0.5;
+constexpr double HOLD_MEAN_MS = 90.0;
+constexpr double HOLD_SIGMA = 0.3;
+
+// Categories the way SoundManager maps keys: Space, Enter and Alt have their own, the rest is alpha
+constexpr std::uint16_t KEY_RETURN = 0x0D;
+constexpr std::uint16_t KEY_MENU = 0x12;
+constexpr std::uint16_t KEY_SPACE = 0x20;
+const char *const CATEGORY_NAMES[] = {"alpha", "alt", "enter", "space"};
+constexpr std::size_t CATEGORY_COUNT = sizeof(CATEGORY_NAMES) / sizeof(CATEGORY_NAMES[0]);
+
+// Keys KeyboardHookManager::preloadCommonSounds() loads at startup
+const std::uint16_t COMMON_KEYS[] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T',
+    'U', 'V', 'W', 'X', 'Y', 'Z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', KEY_SPACE, KEY_RETURN,
+    0x08, 0x09, 0xA0, 0xA1, 0xA2, 0xA3, 0x1B, 0x14};
+
+struct PackFile
+{
+    std::string path;
+    std::uint64_t pcmBytes = 0;
+    std::int64_t decodeNs = 0;
+};
+
+struct PackModel
+{
+    std::vector<PackFile> files;
+    std::vector<std::size_t> sounds[CATEGORY_COUNT][2]; // File indices per category, [0] up and [1] down
+};
+
+std::size_t categoryFor(std::uint16_t keyCode, const PackModel &pack)
+{
+    std::size_t category = 0;
+    if (keyCode == KEY_SPACE) {
+        category = 3;
+    } else if (keyCode == KEY_RETURN) {
+        category = 2;
+    } else if (keyCode == KEY_MENU) {
+        category = 1;
+    }
+    // Missing categories fall back to alpha
+    if (pack.sounds[category][0].empty() && pack.sounds[category][1].empty()) {
+        category = 0;
+    }
+    return category;
+}
+
+/**
+ * @brief List the pack like SoundManager and decode every file once for its size and cost
+ */
+bool loadPack(const std::string &folder, PackModel &pack)
+{
+    namespace fs = std::filesystem;
+    for (std::size_t category = 0; category < CATEGORY_COUNT; ++category) {
+        for (int down = 0; down < 2; ++down) {
+            fs::path dir = fs::path(folder) / CATEGORY_NAMES[category] / (down ? "down" : "up");
+            std::error_code error;
+            if (!fs::is_directory(dir, error)) {
+                continue;
+            }
+            for (const auto &entry : fs::directory_iterator(dir, error)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".mp3") {
+                    continue;
+                }
+                PackFile file;
+                file.path = entry.path().string();
+                sf::SoundBuffer buffer;
+                auto start = Clock::now();
+                if (!buffer.loadFromFile(entry.path())) {
+                    std::cerr << "Failed to decode " << file.path << std::endl;
+                    continue;
+                }
+                file.decodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                file.pcmBytes = buffer.getSampleCount() * sizeof(std::int16_t);
+                pack.sounds[category][down].push_back(pack.files.size());
+                pack.files.push_back(std::move(file));
+            }
+        }
+    }
+    return !pack.sounds[0][0].empty() && !pack.sounds[0][1].empty();
+}
+
+struct TraceEvent
+{
+    std::int64_t timeNs;
+    std::uint16_t keyCode;
+    bool keyDown;
+    std::size_t release = 0; // Key down: index of the matching key up, if any
+    std::size_t variant = 0; // Drawn once so every strategy plays the same sounds
+};
+
+std::uint16_t keyCodeForChar(char c)
+{
+    if (c >= 'a' && c <= 'z') {
+        return static_cast<std::uint16_t>(c - 'a' + 'A');
+    }
+    if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+        return static_cast<std::uint16_t>(c);
+    }
+    switch (c) {
+    case ' ':
+        return KEY_SPACE;
+    case '\n':
+        return KEY_RETURN;
+    case '\t':
+        return 0x09;
+    case '.':
+        return 0xBE;
+    case ',':
+        return 0xBC;
+    case ';':
+        return 0xBA;
+    case '/':
+        return 0xBF;
+    case '-':
+        return 0xBD;
+    case '\'':
+        return 0xDE;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Read a telemetry-reader recording, or type out a text file
+ */
+bool loadTrace(const std::string &path, double wpm, std::mt19937 &random, std::vector<TraceEvent> &trace)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    // A recording starts with "<timestamp-ns> <type> ..."
+    std::istringstream firstLine(text.substr(0, text.find('\n')));
+    std::uint64_t timestamp = 0;
+    std::string type;
+    bool recorded = static_cast<bool>(firstLine >> timestamp >> type);
+
+    if (recorded) {
+        std::istringstream lines(text);
+        std::string line;
+        std::int64_t origin = -1;
+        while (std::getline(lines, line)) {
+            std::istringstream fields(line);
+            std::uint64_t code = 0;
+            std::uint32_t flags = 0;
+            if (!(fields >> timestamp >> type >> code >> flags) || type != "key" || code == 0 || code > 0xFF) {
+                continue;
+            }
+            if (origin < 0) {
+                origin = static_cast<std::int64_t>(timestamp);
+            }
+            trace.push_back({static_cast<std::int64_t>(timestamp) - origin, static_cast<std::uint16_t>(code),
+                             (flags & 1) != 0});
+        }
+    } else {
+        // Five characters per word; lognormal intervals and holds with the given means
+        double meanIntervalMs = 60000.0 / (wpm * 5.0);
+        std::lognormal_distribution<double> interval(std::log(meanIntervalMs) - INTERVAL_SIGMA * INTERVAL_SIGMA / 2,
+                                                     INTERVAL_SIGMA);
+        std::lognormal_distribution<double> hold(std::log(HOLD_MEAN_MS) - HOLD_SIGMA * HOLD_SIGMA / 2, HOLD_SIGMA);
+        std::unordered_map<std::uint16_t, std::int64_t> nextPress;
+        double timeMs = 0.0;
+        std::vector<std::pair<std::int64_t, std::uint16_t>> presses;
+        for (char c : text) {
+            std::uint16_t keyCode = keyCodeForChar(c);
+            if (keyCode == 0) {
+                continue;
+            }
+            presses.push_back({static_cast<std::int64_t>(timeMs * 1e6), keyCode});
+            timeMs += interval(random);
+        }
+        // Release each key before it is pressed again
+        for (auto it = presses.rbegin(); it != presses.rend(); ++it) {
+            std::int64_t release = it->first + static_cast<std::int64_t>(hold(random) * 1e6);
+            auto next = nextPress.find(it->second);
+            if (next != nextPress.end()) {
+                release = std::min(release, next->second - 1000);
+            }
+            nextPress[it->second] = it->first;
+            trace.push_back({it->first, it->second, true});
+            trace.push_back({release, it->second, false});
+        }
+    }
+
+    std::stable_sort(trace.begin(), trace.end(),
+                     [](const TraceEvent &a, const TraceEvent &b) { return a.timeNs < b.timeNs; });
+
+    // Pair presses with their releases and fix the variant of every sound
+    std::unordered_map<std::uint16_t, std::size_t> held;
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        trace[i].variant = random();
+        if (trace[i].keyDown) {
+            held[trace[i].keyCode] = i;
+            trace[i].release = trace.size();
+        } else {
+            auto it = held.find(trace[i].keyCode);
+            if (it != held.end()) {
+                trace[it->second].release = i;
+                held.erase(it);
+            }
+        }
+    }
+    return !trace.empty();
+}
+
+enum class Strategy
+{
+    NONE,
+    LEVEL,
+    FREQUENCY,
+    RESIDENT
+};
+
+struct RunResult
+{
+    std::uint64_t plays = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t stalled = 0;
+    std::int64_t stallNs = 0;
+    std::uint64_t decodes = 0;
+    std::uint64_t prefetchDecodes = 0;
+    std::uint64_t wastedDecodes = 0;
+    std::uint64_t prefetchedBytes = 0;
+    std::uint64_t peakCacheBytes = 0;
+};
+
+/**
+ * @brief Cache, decode threads and preloader of one replay
+ */
+class Simulation
+{
+public:
+    Simulation(const PackModel &pack, Strategy strategy, int level, std::uint32_t seed)
+        : pack_(pack), strategy_(strategy), level_(level), predictRandom_(seed)
+    {
+    }
+
+    RunResult run(const std::vector<TraceEvent> &trace)
+    {
+        if (strategy_ == Strategy::RESIDENT) {
+            for (std::size_t file = 0; file < pack_.files.size(); ++file) {
+                prefetch(file, 0, false);
+            }
+        } else if (strategy_ != Strategy::NONE) {
+            // preloadSounds() skips duplicates within the batch
+            for (std::uint16_t keyCode : COMMON_KEYS) {
+                for (bool keyDown : {true, false}) {
+                    std::size_t file = pick(keyCode, keyDown, predictRandom_());
+                    if (inFlight_.count(file) == 0) {
+                        prefetch(file, 0, false);
+                    }
+                }
+            }
+        }
+        // Startup finishes before the first keystroke
+        complete(trace.empty() ? 0 : std::max<std::int64_t>(trace.front().timeNs, lastReady_));
+
+        std::vector<std::int64_t> armedReady(trace.size(), -1);
+        std::vector<std::uint16_t> predicted;
+        for (std::size_t i = 0; i < trace.size(); ++i) {
+            const TraceEvent &event = trace[i];
+            std::int64_t now = event.timeNs;
+            complete(now);
+
+            if (!event.keyDown) {
+                if (armedReady[i] >= 0) {
+                    // The voice armed at key down holds its buffer
+                    account(armedReady[i], now);
+                } else {
+                    account(fetch(pick(event.keyCode, false, event.variant), now), now);
+                }
+                continue;
+            }
+
+            account(fetch(pick(event.keyCode, true, event.variant), now), now);
+
+            if (strategy_ == Strategy::LEVEL && level_ > 0) {
+                if (event.release < trace.size()) {
+                    const TraceEvent &release = trace[event.release];
+                    armedReady[event.release] = fetch(pick(release.keyCode, false, release.variant), now);
+                }
+                predictor_.observe(event.keyCode, level_, predicted);
+                for (std::uint16_t nextKey : predicted) {
+                    prefetch(pick(nextKey, true, predictRandom_()), now, level_ >= 3);
+                    prefetch(pick(nextKey, false, predictRandom_()), now, level_ >= 3);
+                }
+            } else if (strategy_ == Strategy::FREQUENCY) {
+                ++pressCounts_[event.keyCode];
+                predicted.clear();
+                for (const auto &entry : pressCounts_) {
+                    predicted.push_back(entry.first);
+                }
+                std::size_t count = std::min(FREQUENCY_KEYS, predicted.size());
+                std::partial_sort(predicted.begin(), predicted.begin() + count, predicted.end(),
+                                  [this](std::uint16_t a, std::uint16_t b) { return pressCounts_[a] > pressCounts_[b]; });
+                for (std::size_t k = 0; k < count; ++k) {
+                    prefetch(pick(predicted[k], true, predictRandom_()), now, false);
+                    prefetch(pick(predicted[k], false, predictRandom_()), now, false);
+                }
+            }
+        }
+
+        complete(std::numeric_limits<std::int64_t>::max());
+        for (const auto &entry : cache_) {
+            if (entry.second.prefetched && !entry.second.played) {
+                ++result_.wastedDecodes;
+            }
+        }
+        return result_;
+    }
+
+private:
+    struct CacheEntry
+    {
+        bool prefetched = false;
+        bool played = false;
+    };
+
+    struct Decode
+    {
+        std::int64_t readyNs;
+        std::size_t file;
+        bool prefetched;
+        bool operator>(const Decode &other) const { return readyNs > other.readyNs; }
+    };
+
+    std::size_t pick(std::uint16_t keyCode, bool keyDown, std::size_t variant) const
+    {
+        const auto &sounds = pack_.sounds[categoryFor(keyCode, pack_)][keyDown ? 1 : 0];
+        const auto &fallback = pack_.sounds[0][keyDown ? 1 : 0];
+        const auto &list = sounds.empty() ? fallback : sounds;
+        return list[variant % list.size()];
+    }
+
+    /**
+     * @brief Start a decode that ends up in the cache
+     * @param busyUntil Thread doing the decode, or nullptr for its own thread
+     */
+    std::int64_t decode(std::size_t file, std::int64_t now, bool prefetched, std::int64_t *busyUntil)
+    {
+        std::int64_t start = busyUntil != nullptr ? std::max(now, *busyUntil) : now;
+        std::int64_t ready = start + pack_.files[file].decodeNs;
+        if (busyUntil != nullptr) {
+            *busyUntil = ready;
+        }
+        lastReady_ = std::max(lastReady_, ready);
+        pending_.push({ready, file, prefetched});
+        inFlight_[file] = ready;
+        ++result_.decodes;
+        return ready;
+    }
+
+    /**
+     * @brief SFMLSoundPlayer::preloadSound(): decode unless cached, even if already in flight
+     */
+    void prefetch(std::size_t file, std::int64_t now, bool synchronous)
+    {
+        if (cache_.count(pack_.files[file].path) != 0) {
+            return;
+        }
+        ++result_.prefetchDecodes;
+        result_.prefetchedBytes += pack_.files[file].pcmBytes;
+        decode(file, now, true, synchronous ? &workerBusy_ : nullptr);
+    }
+
+    /**
+     * @brief Buffer lookup on the processing thread
+     * @return When the buffer is ready
+     */
+    std::int64_t fetch(std::size_t file, std::int64_t now)
+    {
+        auto cached = cache_.find(pack_.files[file].path);
+        if (cached != cache_.end()) {
+            cached->second.played = true;
+            return now;
+        }
+        auto flight = inFlight_.find(file);
+        if (flight != inFlight_.end()) {
+            playedOnArrival_[file] = true;
+            return flight->second;
+        }
+        playedOnArrival_[file] = true;
+        return decode(file, now, false, &processingBusy_);
+    }
+
+    void account(std::int64_t ready, std::int64_t now)
+    {
+        ++result_.plays;
+        if (ready <= now) {
+            ++result_.hits;
+        } else {
+            ++result_.stalled;
+            result_.stallNs += ready - now;
+        }
+    }
+
+    /**
+     * @brief Move decodes finished by now into the cache, evicting like the player
+     */
+    void complete(std::int64_t now)
+    {
+        while (!pending_.empty() && pending_.top().readyNs <= now) {
+            Decode done = pending_.top();
+            pending_.pop();
+            const std::string &path = pack_.files[done.file].path;
+            bool played = playedOnArrival_[done.file];
+            auto flight = inFlight_.find(done.file);
+            if (flight != inFlight_.end() && flight->second == done.readyNs) {
+                inFlight_.erase(flight);
+                playedOnArrival_[done.file] = false;
+            }
+
+            auto existing = cache_.find(path);
+            if (existing != cache_.end()) {
+                // A duplicate preload replaces the buffer already there
+                if (done.prefetched) {
+                    ++result_.wastedDecodes;
+                }
+                existing->second.played = existing->second.played || played;
+                continue;
+            }
+            if (strategy_ != Strategy::RESIDENT && cache_.size() >= CACHE_CAPACITY) {
+                auto victim = cache_.begin();
+                if (victim->second.prefetched && !victim->second.played) {
+                    ++result_.wastedDecodes;
+                }
+                cacheBytes_ -= pack_.files[fileIndex(victim->first)].pcmBytes;
+                cache_.erase(victim);
+            }
+            cache_[path] = CacheEntry{done.prefetched, played};
+            cacheBytes_ += pack_.files[done.file].pcmBytes;
+            result_.peakCacheBytes = std::max(result_.peakCacheBytes, cacheBytes_);
+        }
+    }
+
+    std::size_t fileIndex(const std::string &path)
+    {
+        if (fileIndices_.empty()) {
+            for (std::size_t i = 0; i < pack_.files.size(); ++i) {
+                fileIndices_[pack_.files[i].path] = i;
+            }
+        }
+        return fileIndices_[path];
+    }
+
+    const PackModel &pack_;
+    Strategy strategy_;
+    int level_;
+    std::mt19937 predictRandom_;
+    KeyPredictor predictor_;
+    std::unordered_map<std::uint16_t, std::uint64_t> pressCounts_;
+
+    // Keyed by path, so eviction order follows the player's cache
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::unordered_map<std::string, std::size_t> fileIndices_;
+    std::uint64_t cacheBytes_ = 0;
+
+    std::priority_queue<Decode, std::vector<Decode>, std::greater<Decode>> pending_;
+    std::unordered_map<std::size_t, std::int64_t> inFlight_;
+    std::unordered_map<std::size_t, bool> playedOnArrival_;
+    std::int64_t processingBusy_ = 0; // Sound processing thread: misses and armed key-ups
+    std::int64_t workerBusy_ = 0;     // Input worker: high-priority preloads at level 3
+    std::int64_t lastReady_ = 0;
+
+    RunResult result_;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: prefetch-sim <pack-folder> <trace-file> [wpm] [seed]" << std::endl;
+        return 1;
+    }
+    double wpm = argc > 3 ? std::strtod(argv[3], nullptr) : 60.0;
+    std::uint32_t seed = argc > 4 ? static_cast<std::uint32_t>(std::strtoul(argv[4], nullptr, 10)) : 42;
+    if (wpm <= 0.0 || wpm > 1000.0) {
+        std::cerr << "wpm must be between 0 and 1000" << std::endl;
+        return 1;
+    }
+    Logger::instance().start("");
+
+    PackModel pack;
+    if (!loadPack(argv[1], pack)) {
+        std::cerr << "No alpha down and up sounds under " << argv[1] << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+    std::mt19937 random(seed);
+    std::vector<TraceEvent> trace;
+    if (!loadTrace(argv[2], wpm, random, trace)) {
+        std::cerr << "No key events in " << argv[2] << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+
+    std::uint64_t packBytes = 0;
+    std::int64_t decodeNs = 0;
+    for (const auto &file : pack.files) {
+        packBytes += file.pcmBytes;
+        decodeNs += file.decodeNs;
+    }
+    std::cout << "files=" << pack.files.size() << " pack_pcm_kib=" << packBytes / 1024
+              << " mean_decode_us=" << decodeNs / 1000.0 / static_cast<double>(pack.files.size())
+              << " events=" << trace.size() << " duration_s=" << trace.back().timeNs / 1e9 << std::endl;
+
+    struct Run
+    {
+        const char *name;
+        Strategy strategy;
+        int level;
+    };
+    const Run runs[] = {{"none", Strategy::NONE, 0},         {"level0", Strategy::LEVEL, 0},
+                        {"level1", Strategy::LEVEL, 1},      {"level2", Strategy::LEVEL, 2},
+                        {"level3", Strategy::LEVEL, 3},      {"frequency", Strategy::FREQUENCY, 0},
+                        {"resident", Strategy::RESIDENT, 0}};
+    for (const Run &run : runs) {
+        RunResult result = Simulation(pack, run.strategy, run.level, seed).run(trace);
+        std::cout << "strategy=" << run.name
+                  << " hit_rate_pct=" << 100.0 * static_cast<double>(result.hits) / static_cast<double>(result.plays)
+                  << " stalled=" << result.stalled << " stall_ms=" << result.stallNs / 1e6
+                  << " decodes=" << result.decodes << " prefetch_decodes=" << result.prefetchDecodes
+                  << " wasted_decodes=" << result.wastedDecodes << " prefetched_kib=" << result.prefetchedBytes / 1024
+                  << " peak_cache_kib=" << result.peakCacheBytes / 1024 << std::endl;
+    }
+
+    Logger::instance().stop();
+    return 0;
+}
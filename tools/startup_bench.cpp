@@ -0,0 +1,187 @@
+/**
+ * @file startup_bench.cpp
+ * @brief Measures time to the first playable keystroke of a headless engine
+ *
+ * Usage:
+ *   startup-bench [runs] [sounds-folder] [pack]
+ *
+ * Each run (default 5) builds an Engine on the null backend with a
+ * "pipe:" stream input and runs its startup graph, without the keyboard
+ * hook, as keysound-cli does. sounds-folder defaults to "sounds"; pack is
+ * a folder name under it, or empty for the default pack. Per run it
+ * prints when each startup step finished and the resulting time to the
+ * first playable keystroke, all from the start of the run. One key press
+ * is then written to the input to check that it really plays, and the
+ * time from the write until the player counts it is reported.
+ * A summary gives the median and the worst run.
+ */
+#include "Config.h"
+#include "Engine.h"
+#include "Logger.h"
+#include "StartupOrchestrator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(5);
+constexpr auto PLAY_TIMEOUT = std::chrono::seconds(5);
+
+const char *const STEPS[] = {"open_device", "scan_packs", "load_pack", "decode_common", "attach_inputs"};
+
+/**
+ * @brief Write one line to the engine's input pipe once it exists
+ */
+bool writeToPipe(const std::string &name, const std::string &line)
+{
+    auto deadline = Clock::now() + CONNECT_TIMEOUT;
+#ifdef _WIN32
+    std::string path = "\\\\.\\pipe\\" + name;
+    while (Clock::now() < deadline) {
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (handle != INVALID_HANDLE_VALUE) {
+            DWORD written = 0;
+            bool ok = WriteFile(handle, line.data(), static_cast<DWORD>(line.size()), &written, nullptr) &&
+                      written == line.size();
+            CloseHandle(handle);
+            return ok;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#else
+    while (Clock::now() < deadline) {
+        struct stat info;
+        if (stat(name.c_str(), &info) == 0 && S_ISFIFO(info.st_mode)) {
+            int fd = open(name.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                bool ok = write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+                close(fd);
+                return ok;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief Read one value out of the engine's metrics report
+ */
+double readMetric(const Engine &engine, const std::string &name)
+{
+    std::string metrics = engine.dumpMetrics();
+    std::string key = "\n" + name + "=";
+    std::size_t at = metrics.find(key);
+    return at == std::string::npos ? 0.0 : std::strtod(metrics.c_str() + at + key.size(), nullptr);
+}
+
+struct RunResult
+{
+    double firstPlayableMs = 0.0;
+    double firstKeyMs = 0.0;
+};
+
+bool run(const std::string &soundFolder, const std::string &pack, RunResult &result)
+{
+#ifdef _WIN32
+    std::string pipeName = "startup-bench-" + std::to_string(GetCurrentProcessId());
+#else
+    std::string pipeName =
+        (std::filesystem::temp_directory_path() / ("startup-bench-" + std::to_string(getpid()) + ".fifo")).string();
+#endif
+    AppConfig config;
+    config.audio.backend = "null";
+    config.inputStream = "pipe:" + pipeName;
+
+    auto start = Clock::now();
+    Engine engine(soundFolder, config, start);
+    StartupOrchestrator startup(start);
+    engine.addStartupTasks(startup, false, pack);
+    bool succeeded = startup.run();
+    engine.finishStartup(startup);
+    if (!succeeded) {
+        std::cerr << "Startup failed" << std::endl;
+        return false;
+    }
+
+    std::cout << "run";
+    for (const char *step : STEPS) {
+        std::cout << " " << step << "_ms=" << startup.getFinishOffset(step).count() / 1000.0;
+    }
+    result.firstPlayableMs = readMetric(engine, "startup_first_playable_ms");
+
+    // The same key press a user would make, through the attached input
+    auto sent = Clock::now();
+    bool played = writeToPipe(pipeName, "d 0x41\n");
+    while (played && readMetric(engine, "sounds_played") < 1) {
+        if (Clock::now() - sent > PLAY_TIMEOUT) {
+            played = false;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    result.firstKeyMs = std::chrono::duration<double, std::milli>(Clock::now() - sent).count();
+    std::cout << " first_playable_ms=" << result.firstPlayableMs << " first_key_played=" << (played ? 1 : 0)
+              << " first_key_ms=" << result.firstKeyMs << std::endl;
+#ifndef _WIN32
+    std::remove(pipeName.c_str());
+#endif
+    return played;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? std::atoi(argv[1]) : 5;
+    std::string soundFolder = argc > 2 ? argv[2] : "sounds";
+    std::string pack = argc > 3 ? argv[3] : "";
+    if (runs <= 0) {
+        std::cerr << "Usage: startup-bench [runs] [sounds-folder] [pack]" << std::endl;
+        return 1;
+    }
+    Logger::instance().setLevel(LogLevel::ERR);
+    Logger::instance().start("");
+
+    std::vector<double> firstPlayable;
+    std::vector<double> firstKey;
+    for (int i = 0; i < runs; ++i) {
+        RunResult result;
+        if (!run(soundFolder, pack, result)) {
+            Logger::instance().stop();
+            return 1;
+        }
+        firstPlayable.push_back(result.firstPlayableMs);
+        firstKey.push_back(result.firstKeyMs);
+    }
+    std::cout << "runs=" << runs << " first_playable_median_ms=" << median(firstPlayable)
+              << " first_playable_max_ms=" << *std::max_element(firstPlayable.begin(), firstPlayable.end())
+              << " first_key_median_ms=" << median(firstKey)
+              << " first_key_max_ms=" << *std::max_element(firstKey.begin(), firstKey.end()) << std::endl;
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file stream_bench.cpp
+ * @brief Measures the throughput and latency of the stream input source
+ *
+ * Usage:
+ *   stream-bench [events] [latency-samples]
+ *
+ * Starts a StreamInputSource on a "pipe:" endpoint (a FIFO on POSIX, a
+ * named pipe on Windows) and writes to it from this process, once per
+ * wire format:
+ *   throughput - events (default 1000000) key downs and ups written in
+ *                64 KiB batches as fast as the pipe takes them, timed
+ *                from the first write to the last dispatched event
+ *   latency    - latency-samples (default 2000) single events, each
+ *                written once the previous one has been dispatched; the
+ *                time from write() to the callback is reported
+ */
+#include "Logger.h"
+#include "StreamInputSource.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t BATCH_BYTES = 64 * 1024;
+constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(5);
+constexpr auto EVENT_TIMEOUT = std::chrono::seconds(5);
+
+/**
+ * @brief Write end of the benchmark pipe
+ */
+class PipeWriter
+{
+public:
+    ~PipeWriter()
+    {
+#ifdef _WIN32
+        if (handle_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle_);
+        }
+#else
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    /**
+     * @brief Connect once the source has created the endpoint
+     * @param name Endpoint name after "pipe:"
+     */
+    bool connect(const std::string &name)
+    {
+        auto deadline = Clock::now() + CONNECT_TIMEOUT;
+#ifdef _WIN32
+        std::string path = "\\\\.\\pipe\\" + name;
+        while (Clock::now() < deadline) {
+            handle_ = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            if (handle_ != INVALID_HANDLE_VALUE) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+#else
+        while (Clock::now() < deadline) {
+            struct stat info;
+            if (stat(name.c_str(), &info) == 0 && S_ISFIFO(info.st_mode)) {
+                fd_ = open(name.c_str(), O_WRONLY | O_CLOEXEC);
+                if (fd_ >= 0) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+#endif
+        return false;
+    }
+
+    bool write(const char *data, std::size_t size)
+    {
+        while (size > 0) {
+#ifdef _WIN32
+            DWORD written = 0;
+            if (!WriteFile(handle_, data, static_cast<DWORD>(size), &written, nullptr) || written == 0) {
+                return false;
+            }
+#else
+            ssize_t written = ::write(fd_, data, size);
+            if (written <= 0) {
+                return false;
+            }
+#endif
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+/**
+ * @brief Append the encoding of one event
+ */
+void encode(StreamInputSource::Format format, std::uint16_t keyCode, bool keyDown, std::string &out)
+{
+    if (format == StreamInputSource::Format::BINARY) {
+        std::uint16_t record = static_cast<std::uint16_t>(keyCode | (keyDown ? 0x8000 : 0));
+        out.push_back(static_cast<char>(record & 0xFF));
+        out.push_back(static_cast<char>(record >> 8));
+        return;
+    }
+    char line[16];
+    int length = std::snprintf(line, sizeof(line), "%c 0x%02X\n", keyDown ? 'd' : 'u', keyCode);
+    out.append(line, static_cast<std::size_t>(length));
+}
+
+/**
+ * @brief Wait until the source has dispatched count events
+ */
+bool waitForEvents(const std::atomic<std::uint64_t> &received, std::uint64_t count)
+{
+    auto deadline = Clock::now() + EVENT_TIMEOUT;
+    while (received.load(std::memory_order_acquire) < count) {
+        if (Clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(p / 100.0 * values.size()));
+    return values[index];
+}
+
+bool run(const char *name, StreamInputSource::Format format, std::uint64_t events, std::size_t samples)
+{
+#ifdef _WIN32
+    std::string pipeName = "stream-bench-" + std::to_string(GetCurrentProcessId());
+#else
+    std::string pipeName =
+        (std::filesystem::temp_directory_path() / ("stream-bench-" + std::to_string(getpid()) + ".fifo")).string();
+#endif
+
+    std::atomic<std::uint64_t> received{0};
+    std::vector<Clock::time_point> arrivals(samples);
+    std::atomic<bool> timing{false};
+    StreamInputSource source("pipe:" + pipeName, format);
+    source.start([&](const KeyEvent &) {
+        std::uint64_t index = received.load(std::memory_order_relaxed);
+        if (timing.load(std::memory_order_relaxed) && index < arrivals.size()) {
+            arrivals[index] = Clock::now();
+        }
+        received.store(index + 1, std::memory_order_release);
+    });
+
+    PipeWriter writer;
+    if (!writer.connect(pipeName)) {
+        std::cerr << "Failed to connect to " << pipeName << std::endl;
+        source.stop();
+        return false;
+    }
+
+    // Throughput: whole batches, as fast as the reader drains them
+    std::string batch;
+    auto start = Clock::now();
+    for (std::uint64_t i = 0; i < events; ++i) {
+        encode(format, static_cast<std::uint16_t>('A' + (i / 2) % 26), i % 2 == 0, batch);
+        if (batch.size() >= BATCH_BYTES - 16 || i + 1 == events) {
+            if (!writer.write(batch.data(), batch.size())) {
+                std::cerr << "Write failed" << std::endl;
+                source.stop();
+                return false;
+            }
+            batch.clear();
+        }
+    }
+    bool complete = waitForEvents(received, events);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::uint64_t batches = source.getBatchCount();
+
+    // Latency: one event in flight at a time
+    received.store(0, std::memory_order_relaxed);
+    timing.store(true, std::memory_order_relaxed);
+    std::vector<double> latencies;
+    latencies.reserve(samples);
+    for (std::size_t i = 0; i < samples && complete; ++i) {
+        std::string one;
+        encode(format, static_cast<std::uint16_t>('A' + (i / 2) % 26), i % 2 == 0, one);
+        auto sent = Clock::now();
+        if (!writer.write(one.data(), one.size()) || !waitForEvents(received, i + 1)) {
+            complete = false;
+            break;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(arrivals[i] - sent).count());
+    }
+    source.stop();
+#ifndef _WIN32
+    std::remove(pipeName.c_str());
+#endif
+
+    if (!complete) {
+        std::cerr << "format=" << name << ": events went missing" << std::endl;
+        return false;
+    }
+    std::cout << "format=" << name << " events=" << events << " events_per_second=" << events / seconds
+              << " read_batches=" << batches << " latency_samples=" << latencies.size()
+              << " latency_p50_us=" << percentile(latencies, 50) << " latency_p99_us=" << percentile(latencies, 99)
+              << " latency_max_us=" << percentile(latencies, 100) << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::uint64_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::size_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+    if (events == 0) {
+        std::cerr << "Usage: stream-bench [events] [latency-samples]" << std::endl;
+        return 1;
+    }
+    Logger::instance().setLevel(LogLevel::ERR);
+    Logger::instance().start("");
+
+    bool ok = run("text", StreamInputSource::Format::TEXT, events, samples) &&
+              run("binary", StreamInputSource::Format::BINARY, events, samples);
+
+    Logger::instance().stop();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+/**
+ * @file stress_test.cpp
+ * @brief Hammers the player, the pack manager and the hook manager from many threads at once
+ *
+ * Usage:
+ *   stress-test [seconds] [threads-per-role] [sounds-folder]
+ *
+ * Runs an SFMLSoundPlayer on the null backend with a SoundManager and a
+ * KeyboardHookManager on top, and starts threads-per-role threads
+ * (default 2) for each role below. They run flat out for the given time
+ * (default 10 s):
+ *   keys     - key downs and ups through dispatchKeyEvent, some out of range
+ *   play     - playSound with random sounds of the current pack
+ *   preload  - preloadSound and preloadSounds
+ *   refresh  - refreshSound and refreshCategories, the pack reload path
+ *   volume   - setVolume
+ *   stop     - stopAllSounds and releaseArmedVoices
+ *   packs    - switchPack through every pack, then preloadCommonSounds
+ *   settings - latency level, overload policy and key filter changes
+ *   effects  - setEffects with alternating bus setups
+ *   metrics  - dumpMetrics and getMemoryUsage
+ * Packs are the synthesized one, the embedded one if built in and every
+ * folder under sounds-folder (default "sounds").
+ *
+ * Every role's operation count and rate is printed once per second and at
+ * the end. A role that makes no progress for 5 s is reported as stalled
+ * and the process aborts, so a deadlock shows up as a failure rather
+ * than a hang. Build with the tsan or asan preset to catch races and
+ * memory errors; the sanitizer's own exit code marks a failed run.
+ */
+#include "ClickSynth.h"
+#include "EmbeddedPack.h"
+#include "KeyboardHookManager.h"
+#include "Logger.h"
+#include "SFMLSoundPlayer.h"
+#include "SoundManager.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(1);
+constexpr int STALL_REPORTS = 5;
+
+/**
+ * @brief A kind of work done by several threads, and how much of it they got through
+ */
+struct Role
+{
+    const char *name;
+    std::function<void(std::mt19937 &)> step;
+    std::atomic<std::uint64_t> operations{0};
+};
+
+std::vector<std::string> findPacks(const std::string &soundFolder)
+{
+    std::vector<std::string> packs{ClickSynth::getFolderPath()};
+    if (EmbeddedPack::isAvailable()) {
+        packs.push_back(EmbeddedPack::getFolderPath());
+    }
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(soundFolder, ec)) {
+        if (entry.is_directory()) {
+            packs.push_back(entry.path().string());
+        }
+    }
+    return packs;
+}
+
+/**
+ * @brief Every sound path of a pack
+ */
+std::vector<std::string> listSounds(const SoundPack &pack)
+{
+    std::vector<std::string> paths;
+    for (const auto &[type, category] : pack.categories) {
+        paths.insert(paths.end(), category.down.begin(), category.down.end());
+        paths.insert(paths.end(), category.up.begin(), category.up.end());
+    }
+    return paths;
+}
+
+/**
+ * @brief A random sound of whichever pack is current when called
+ */
+std::string pickSound(const SoundManager &sounds, std::mt19937 &random)
+{
+    std::shared_ptr<const SoundPack> pack = sounds.getCurrentPack();
+    if (!pack) {
+        return "";
+    }
+    std::vector<std::string> paths = listSounds(*pack);
+    if (paths.empty()) {
+        return "";
+    }
+    return paths[random() % paths.size()];
+}
+
+std::uint16_t pickKey(std::mt19937 &random)
+{
+    // Letters most of the time, the mapped specials and now and then a code the engine must reject
+    static const std::uint16_t SPECIALS[] = {0x20, 0x0D, 0x12, 0x10, 0x08};
+    switch (random() % 8) {
+    case 0:
+        return SPECIALS[random() % (sizeof(SPECIALS) / sizeof(SPECIALS[0]))];
+    case 1:
+        return static_cast<std::uint16_t>(random() % 512);
+    default:
+        return static_cast<std::uint16_t>(0x41 + random() % 26);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long seconds = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 10;
+    long threadsPerRole = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 2;
+    std::string soundFolder = argc > 3 ? argv[3] : "sounds";
+    if (seconds <= 0 || threadsPerRole <= 0 || threadsPerRole > 64) {
+        std::cerr << "Usage: stress-test [seconds] [threads-per-role 1-64] [sounds-folder]" << std::endl;
+        return 1;
+    }
+    Logger::instance().setLevel(LogLevel::ERR);
+    Logger::instance().start("");
+
+    std::vector<std::string> packs = findPacks(soundFolder);
+
+    AudioBackendConfig config;
+    config.backend = "null";
+    config.sampleRate = 48000;
+    SFMLSoundPlayer player(config);
+    if (!player.open()) {
+        std::cerr << "Failed to open the null backend" << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+    SoundManager sounds(packs[0]);
+    if (!sounds.loadSounds()) {
+        std::cerr << "Failed to load " << packs[0] << std::endl;
+        Logger::instance().stop();
+        return 1;
+    }
+    KeyboardHookManager hook(sounds, player);
+    hook.preloadCommonSounds();
+
+    std::atomic<std::size_t> nextPack{1};
+    std::array<Role, 10> roles{{
+        {"keys",
+         [&hook](std::mt19937 &random) {
+             KeyEvent event;
+             event.keyCode = pickKey(random);
+             event.keyDown = true;
+             event.injected = random() % 16 == 0;
+             event.timestamp = Clock::now();
+             hook.dispatchKeyEvent(event);
+             event.keyDown = false;
+             event.timestamp = Clock::now();
+             hook.dispatchKeyEvent(event);
+         }},
+        {"play",
+         [&sounds, &player](std::mt19937 &random) {
+             std::string path = pickSound(sounds, random);
+             if (!path.empty()) {
+                 player.playSound(path, random() % 2 == 0, Clock::now());
+             }
+         }},
+        {"preload",
+         [&sounds, &player](std::mt19937 &random) {
+             if (random() % 32 == 0) {
+                 std::vector<std::string> batch;
+                 for (int i = 0; i < 8; ++i) {
+                     batch.push_back(pickSound(sounds, random));
+                 }
+                 player.preloadSounds(batch);
+                 return;
+             }
+             player.preloadSound(pickSound(sounds, random), random() % 2 == 0);
+         }},
+        {"refresh",
+         [&sounds, &player](std::mt19937 &random) {
+             if (random() % 16 == 0) {
+                 static const char *const CATEGORIES[] = {"alpha", "alt", "enter", "space", "other"};
+                 sounds.refreshCategories(sounds.getFolderPath(), {CATEGORIES[random() % 5]});
+                 return;
+             }
+             player.refreshSound(pickSound(sounds, random));
+         }},
+        {"volume", [&player](std::mt19937 &random) { player.setVolume(static_cast<int>(random() % 101)); }},
+        {"stop",
+         [&player](std::mt19937 &random) {
+             if (random() % 2 == 0) {
+                 player.stopAllSounds();
+             } else {
+                 player.releaseArmedVoices();
+             }
+         }},
+        {"packs",
+         [&sounds, &player, &hook, &packs, &nextPack](std::mt19937 &) {
+             const std::string &folder = packs[nextPack.fetch_add(1) % packs.size()];
+             if (sounds.switchPack(folder)) {
+                 player.releaseArmedVoices();
+                 hook.preloadCommonSounds();
+             }
+         }},
+        {"settings",
+         [&hook](std::mt19937 &random) {
+             switch (random() % 4) {
+             case 0:
+                 hook.setLatencyOptimization(static_cast<int>(random() % 4));
+                 break;
+             case 1:
+                 hook.setOverloadPolicy(random() % 2 == 0 ? OverloadPolicy::DROP : OverloadPolicy::LIMIT);
+                 break;
+             case 2:
+                 hook.setKeyFilteringEnabled(random() % 2 == 0);
+                 break;
+             default:
+                 if (random() % 2 == 0) {
+                     hook.addKeyToFilter(pickKey(random));
+                 } else {
+                     hook.removeKeyFromFilter(pickKey(random));
+                 }
+                 break;
+             }
+         }},
+        {"effects",
+         [&player](std::mt19937 &random) {
+             BusEffectSettings settings;
+             settings.eq = random() % 2 == 0;
+             settings.midGainDb = static_cast<float>(random() % 13) - 6.0f;
+             settings.compressor = random() % 2 == 0;
+             settings.reverb = random() % 4 == 0;
+             player.setEffects(settings);
+         }},
+        {"metrics",
+         [&player](std::mt19937 &) {
+             player.dumpMetrics();
+             player.getMemoryUsage();
+         }},
+    }};
+
+    std::cout << "seconds=" << seconds << " threads_per_role=" << threadsPerRole << " packs=" << packs.size()
+              << std::endl;
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < roles.size(); ++r) {
+        for (long t = 0; t < threadsPerRole; ++t) {
+            threads.emplace_back([&running, &role = roles[r], seed = static_cast<unsigned>(r * 1000 + t)]() {
+                std::mt19937 random(seed);
+                while (running.load(std::memory_order_relaxed)) {
+                    role.step(random);
+                    role.operations.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    // Report progress and catch stalls while the threads run
+    auto start = Clock::now();
+    std::array<std::uint64_t, 10> previous{};
+    std::array<int, 10> idleReports{};
+    bool stalled = false;
+    for (auto next = start + REPORT_INTERVAL; next <= start + std::chrono::seconds(seconds); next += REPORT_INTERVAL) {
+        std::this_thread::sleep_until(next);
+        std::cout << "t=" << std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - start).count() << "s";
+        for (std::size_t r = 0; r < roles.size(); ++r) {
+            std::uint64_t operations = roles[r].operations.load(std::memory_order_relaxed);
+            std::cout << " " << roles[r].name << "=" << operations - previous[r];
+            idleReports[r] = operations == previous[r] ? idleReports[r] + 1 : 0;
+            stalled = stalled || idleReports[r] >= STALL_REPORTS;
+            previous[r] = operations;
+        }
+        std::cout << std::endl;
+        if (stalled) {
+            for (std::size_t r = 0; r < roles.size(); ++r) {
+                if (idleReports[r] >= STALL_REPORTS) {
+                    std::cerr << "Role '" << roles[r].name << "' made no progress for " << STALL_REPORTS << " s"
+                              << std::endl;
+                }
+            }
+            std::abort();
+        }
+    }
+
+    running = false;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::uint64_t total = 0;
+    for (const auto &role : roles) {
+        std::uint64_t operations = role.operations.load();
+        total += operations;
+        std::cout << "role=" << role.name << " operations=" << operations
+                  << " per_second=" << static_cast<double>(operations) / elapsed << std::endl;
+    }
+    std::cout << "total_operations=" << total << " per_second=" << static_cast<double>(total) / elapsed
+              << " sounds_dropped=" << player.getDroppedCount() << std::endl;
+
+    Logger::instance().stop();
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file telemetry_reader.cpp
+ * @brief Prints live telemetry from a running engine, or benchmarks the writer
+ *
+ * Usage:
+ *   telemetry-reader [segment-name]
+ *   telemetry-reader --bench [writes]
+ */
+#include "TelemetryRing.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char *typeName(TelemetryType type)
+{
+    switch (type) {
+    case TelemetryType::KEY_EVENT:
+        return "key";
+    case TelemetryType::VOICE_LEVEL:
+        return "level";
+    case TelemetryType::LATENCY:
+        return "latency";
+    }
+    return "unknown";
+}
+
+int runBenchmark(std::uint64_t writes)
+{
+    auto ring = TelemetryRing::create("keyboard-sounds-telemetry-bench");
+    if (!ring) {
+        std::cerr << "Failed to create benchmark segment" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < writes; ++i) {
+        ring->write(TelemetryType::KEY_EVENT, static_cast<std::uint32_t>(i & 0xFF), 0.0f, 1);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "writes=" << writes << " ns_per_write=" << (elapsed / static_cast<double>(writes)) << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Logger::instance().start("");
+
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        return runBenchmark(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000ULL);
+    }
+
+    std::string name = argc > 1 ? argv[1] : TelemetryRing::DEFAULT_NAME;
+    auto ring = TelemetryRing::open(name);
+    if (!ring) {
+        std::cerr << "Telemetry segment '" << name << "' not found; is telemetry.enabled set?" << std::endl;
+        return 1;
+    }
+
+    // Start from the live edge; history is not interesting to an overlay
+    std::uint64_t cursor = ring->getWritePosition();
+    std::uint64_t lost = 0;
+    TelemetryEvent events[256];
+
+    for (;;) {
+        std::size_t count = ring->read(cursor, events, 256, lost);
+        for (std::size_t i = 0; i < count; ++i) {
+            const TelemetryEvent &event = events[i];
+            std::cout << event.timestampNs << ' ' << typeName(event.type) << ' ' << event.code << ' '
+                      << event.flags << ' ' << event.value << '\n';
+        }
+        if (count > 0) {
+            std::cout.flush();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        if (lost > 0) {
+            std::cerr << "lost " << lost << " records" << std::endl;
+            lost = 0;
+        }
+    }
+}